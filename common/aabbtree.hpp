@@ -0,0 +1,342 @@
+#pragma once
+
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/// 太らせた箱の余白
+constexpr float AABB_MARGIN = 2.0f;
+
+/// 太らせた箱を移動方向に伸ばす量(1フレームの移動量に対する倍率)
+constexpr float AABB_DISPLACEMENT_MULTIPLIER = 16.0f;
+
+/// 軸に平行な箱
+struct Aabb {
+	float x0;
+	float y0;
+	float x1;
+	float y1;
+
+	static inline Aabb ofCircle(float x, float y, float r) {
+		return {x - r, y - r, x + r, y + r};
+	}
+	static inline Aabb merge(const Aabb &a, const Aabb &b) {
+		return {std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1)};
+	}
+	inline bool contains(const Aabb &other) const {
+		return x0 <= other.x0 && y0 <= other.y0 && other.x1 <= x1 && other.y1 <= y1;
+	}
+	inline bool overlaps(const Aabb &other) const {
+		return x0 <= other.x1 && other.x0 <= x1 && y0 <= other.y1 && other.y0 <= y1;
+	}
+	inline float perimeter() const {
+		return 2.0f * ((x1 - x0) + (y1 - y0));
+	}
+};
+
+/// 動的AABB木
+///
+/// 葉は物体を太らせた箱を持ち、物体が太らせた箱の内側にとどまる限り木は変化しない。
+/// はみ出した葉だけを抜いて入れ直し、挿入先は周長の増分で選ぶ。
+/// 挿入と削除とで辿った祖先の箱を詰め直し、左右の高さの差が2以上になった節は回転で均衡させる。
+class AabbTree final {
+public:
+	static constexpr int NULL_NODE = -1;
+
+private:
+	struct Node {
+		Aabb box;
+		int parent;
+		int left;
+		int right;
+		int height;
+		uint32_t id;
+
+		inline bool isLeaf() const {
+			return left == NULL_NODE;
+		}
+	};
+
+	/// 問い合わせで用いるスタックの深さ
+	///
+	/// NOTE: 高さは回転によって葉の数の対数程度に保たれるため、十分に大きい。
+	static constexpr size_t STACK_SIZE = 128;
+
+	const float _margin;
+	const float _displacementMultiplier;
+	std::vector<Node> _nodes;
+	int _root;
+	int _freeList;
+	size_t _leafCount;
+
+	int allocateNode() {
+		if (_freeList == NULL_NODE) {
+			_nodes.push_back({});
+			_freeList = static_cast<int>(_nodes.size() - 1);
+			_nodes[_freeList].parent = NULL_NODE;
+		}
+		const auto index = _freeList;
+		_freeList = _nodes[index].parent;
+		_nodes[index] = {{}, NULL_NODE, NULL_NODE, NULL_NODE, 0, 0};
+		return index;
+	}
+
+	/// 解放した節はparentを次の空き節へのリンクとして使う
+	void freeNode(int index) {
+		_nodes[index].parent = _freeList;
+		_nodes[index].height = -1;
+		_freeList = index;
+	}
+
+	/// 内部節の箱と高さとを子から求め直す関数
+	inline void fix(int index) {
+		auto &node = _nodes[index];
+		const auto &left = _nodes[node.left];
+		const auto &right = _nodes[node.right];
+		node.box = Aabb::merge(left.box, right.box);
+		node.height = 1 + std::max(left.height, right.height);
+	}
+
+	/// 節indexの親が指す子をindexからreplacementに付け替える関数
+	inline void replaceChild(int parent, int index, int replacement) {
+		if (parent == NULL_NODE) {
+			_root = replacement;
+		} else if (_nodes[parent].left == index) {
+			_nodes[parent].left = replacement;
+		} else {
+			_nodes[parent].right = replacement;
+		}
+	}
+
+	/// 節aの左右の高さの差が2以上ならば、高い方の子を持ち上げる関数
+	///
+	/// 回転後にaの位置に来た節を返す。
+	int balance(int a) {
+		if (_nodes[a].isLeaf() || _nodes[a].height < 2) {
+			return a;
+		}
+		const auto b = _nodes[a].left;
+		const auto c = _nodes[a].right;
+		const auto diff = _nodes[c].height - _nodes[b].height;
+		if (diff > 1) {
+			return rotate(a, c, false);
+		}
+		if (diff < -1) {
+			return rotate(a, b, true);
+		}
+		return a;
+	}
+
+	/// aの子childを持ち上げ、childの低い方の子をaに渡す関数
+	///
+	/// isLeftはchildがaの左の子であるか。
+	int rotate(int a, int child, bool isLeft) {
+		const auto f = _nodes[child].left;
+		const auto g = _nodes[child].right;
+		const auto parent = _nodes[a].parent;
+		_nodes[child].parent = parent;
+		replaceChild(parent, a, child);
+		_nodes[a].parent = child;
+		// 高い方の孫はchildに残し、低い方の孫をaのchildがあった側に付ける
+		const auto keep = _nodes[f].height > _nodes[g].height ? f : g;
+		const auto give = keep == f ? g : f;
+		_nodes[child].left = a;
+		_nodes[child].right = keep;
+		if (isLeft) {
+			_nodes[a].left = give;
+		} else {
+			_nodes[a].right = give;
+		}
+		_nodes[give].parent = a;
+		fix(a);
+		fix(child);
+		return child;
+	}
+
+	/// 節indexから根までの祖先を均衡させながら詰め直す関数
+	void refitAncestors(int index) {
+		while (index != NULL_NODE) {
+			index = balance(index);
+			fix(index);
+			index = _nodes[index].parent;
+		}
+	}
+
+	/// 葉leafを周長の増分が最小になる位置に挿入する関数
+	void insertLeaf(int leaf) {
+		_leafCount += 1;
+		if (_root == NULL_NODE) {
+			_root = leaf;
+			_nodes[leaf].parent = NULL_NODE;
+			return;
+		}
+		const auto box = _nodes[leaf].box;
+		auto index = _root;
+		while (!_nodes[index].isLeaf()) {
+			const auto &node = _nodes[index];
+			const auto area = node.box.perimeter();
+			const auto combined = Aabb::merge(node.box, box).perimeter();
+			// ここに新しい親を作る費用と、子へ降りたときに祖先が広がる費用
+			const auto cost = 2.0f * combined;
+			const auto inheritance = 2.0f * (combined - area);
+			const auto descend = [&](int child) {
+				const auto &n = _nodes[child];
+				const auto merged = Aabb::merge(n.box, box).perimeter();
+				return (n.isLeaf() ? merged : merged - n.box.perimeter()) + inheritance;
+			};
+			const auto costLeft = descend(node.left);
+			const auto costRight = descend(node.right);
+			if (cost < costLeft && cost < costRight) {
+				break;
+			}
+			index = costLeft < costRight ? node.left : node.right;
+		}
+		const auto sibling = index;
+		const auto oldParent = _nodes[sibling].parent;
+		const auto newParent = allocateNode();
+		_nodes[newParent].parent = oldParent;
+		_nodes[newParent].left = sibling;
+		_nodes[newParent].right = leaf;
+		replaceChild(oldParent, sibling, newParent);
+		_nodes[sibling].parent = newParent;
+		_nodes[leaf].parent = newParent;
+		refitAncestors(newParent);
+	}
+
+	/// 葉leafを木から外す関数
+	///
+	/// 葉の節自体は解放しない。
+	void removeLeaf(int leaf) {
+		_leafCount -= 1;
+		if (leaf == _root) {
+			_root = NULL_NODE;
+			return;
+		}
+		const auto parent = _nodes[leaf].parent;
+		const auto grandParent = _nodes[parent].parent;
+		const auto sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+		replaceChild(grandParent, parent, sibling);
+		_nodes[sibling].parent = grandParent;
+		freeNode(parent);
+		refitAncestors(grandParent);
+	}
+
+	/// 箱boxを余白と1フレームの移動量(dx, dy)の予測とで太らせる関数
+	inline Aabb fatten(const Aabb &box, float dx, float dy) const {
+		auto fat = Aabb{box.x0 - _margin, box.y0 - _margin, box.x1 + _margin, box.y1 + _margin};
+		const auto ex = _displacementMultiplier * dx;
+		const auto ey = _displacementMultiplier * dy;
+		(ex < 0.0f ? fat.x0 : fat.x1) += ex;
+		(ey < 0.0f ? fat.y0 : fat.y1) += ey;
+		return fat;
+	}
+
+public:
+	explicit AabbTree(float margin = AABB_MARGIN, float displacementMultiplier = AABB_DISPLACEMENT_MULTIPLIER):
+		_margin(margin),
+		_displacementMultiplier(displacementMultiplier),
+		_nodes(),
+		_root(NULL_NODE),
+		_freeList(NULL_NODE),
+		_leafCount(0)
+	{}
+	AabbTree(const AabbTree &) = delete;
+	AabbTree(const AabbTree &&) = delete;
+	AabbTree &operator=(const AabbTree &) = delete;
+	AabbTree &&operator=(const AabbTree &&) = delete;
+	~AabbTree() = default;
+
+	/// 物体idを箱boxで木に加える関数
+	///
+	/// 以後の操作で用いる葉の番号を返す。
+	int createProxy(const Aabb &box, uint32_t id) {
+		const auto leaf = allocateNode();
+		_nodes[leaf].box = fatten(box, 0.0f, 0.0f);
+		_nodes[leaf].id = id;
+		insertLeaf(leaf);
+		return leaf;
+	}
+
+	void destroyProxy(int proxy) {
+		removeLeaf(proxy);
+		freeNode(proxy);
+	}
+
+	/// 葉proxyの物体が箱boxに移動したことを伝える関数
+	///
+	/// (dx, dy)は1フレームの移動量。boxが太らせた箱の内側にとどまるならば何もせずfalseを返す。
+	/// はみ出したならば太らせ直して入れ直し、trueを返す。
+	bool moveProxy(int proxy, const Aabb &box, float dx, float dy) {
+		if (_nodes[proxy].box.contains(box)) {
+			return false;
+		}
+		removeLeaf(proxy);
+		_nodes[proxy].box = fatten(box, dx, dy);
+		insertLeaf(proxy);
+		return true;
+	}
+
+	/// 箱boxと太らせた箱が重なる物体の識別子を順にfに渡す関数
+	///
+	/// WARN: 太らせた箱で判定するため、実際の形状との判定は呼び出し側で行うこと。
+	template<typename F>
+	void query(const Aabb &box, F f) const {
+		if (_root == NULL_NODE) {
+			return;
+		}
+		std::array<int, STACK_SIZE> stack;
+		size_t top = 0;
+		stack[top++] = _root;
+		while (top > 0) {
+			const auto &node = _nodes[stack[--top]];
+			if (!node.box.overlaps(box)) {
+				continue;
+			}
+			if (node.isLeaf()) {
+				f(node.id);
+				continue;
+			}
+			if (top + 2 > STACK_SIZE) {
+				throw "aabb tree is too deep.";
+			}
+			stack[top++] = node.left;
+			stack[top++] = node.right;
+		}
+	}
+
+	/// 木の状態をsnapshotに書き込む関数
+	///
+	/// 節の配列はそのままmemcpyで写すため、葉の番号(createProxy()の戻り値)も復元後にそのまま使える。
+	void save(Snapshot &snapshot) const {
+		snapshot.write(_nodes);
+		snapshot.write(_root);
+		snapshot.write(_freeList);
+		snapshot.write(_leafCount);
+	}
+
+	/// save()で書き込んだ木の状態を読み出す関数
+	void restore(Snapshot &snapshot) {
+		snapshot.read(_nodes);
+		snapshot.read(_root);
+		snapshot.read(_freeList);
+		snapshot.read(_leafCount);
+	}
+
+	/// 葉proxyの物体の識別子を付け直す関数
+	inline void setProxyId(int proxy, uint32_t id) {
+		_nodes[proxy].id = id;
+	}
+
+	inline const Aabb &getFatBox(int proxy) const {
+		return _nodes[proxy].box;
+	}
+	inline size_t getLeafCount() const {
+		return _leafCount;
+	}
+	inline int getHeight() const {
+		return _root == NULL_NODE ? 0 : _nodes[_root].height;
+	}
+};
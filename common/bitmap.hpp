@@ -0,0 +1,570 @@
+#pragma once
+
+#include "common.hpp"
+#include "coverage.hpp"
+#include "footprint.hpp"
+#include "mask.hpp"
+#include "raycast.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// CPU上で描画する衝突判定ビットマップ
+///
+/// 物体群ごとに1画素1bitの面を持つ。各面は行ごとに64bitの語を並べたもの。
+/// 描画と照合とはワールドの座標で行い、ワールドの1単位をscale画素としてビットマップの画素に直す。
+/// 大きなワールドを区画に分けるときは(originX, originY)に区画の左上の画素を与える(TiledBitmapを参照)。
+/// 画素(x, y)は既定では中心(x + 0.5, y + 0.5)が図形の内側にあるときに塗られる。規則はsetCoverage()で変えられる。
+class SoftwareBitmap final {
+private:
+	const int _width;
+	const int _height;
+	const size_t _wordsPerRow;
+	const unsigned int _groupCount;
+	/// ワールドの1単位あたりの画素数
+	const float _scale;
+	/// ビットマップの左上の画素の、ワールド全体を覆う画素の格子での位置
+	const int _originX;
+	const int _originY;
+	std::vector<uint64_t> _planes;
+	OccupancyGrid _occupancy;
+	const DiskFootprints *_footprints;
+	Coverage _coverage;
+
+	/// ワールドのx座標をビットマップの画素の座標に直す関数
+	inline float toPixelX(float x) const {
+		return x * _scale - static_cast<float>(_originX);
+	}
+	/// ワールドのy座標をビットマップの画素の座標に直す関数
+	inline float toPixelY(float y) const {
+		return y * _scale - static_cast<float>(_originY);
+	}
+
+	/// 行の[x0, x1)のビットを立てる関数
+	///
+	/// WARN: 0 <= x0 < x1 <= widthであること。
+	static inline void fillRow(uint64_t *row, int x0, int x1) {
+		const auto w0 = static_cast<size_t>(x0) / 64;
+		const auto w1 = static_cast<size_t>(x1 - 1) / 64;
+		const auto m0 = ~0ull << (x0 % 64);
+		const auto m1 = ~0ull >> (63 - (x1 - 1) % 64);
+		if (w0 == w1) {
+			row[w0] |= m0 & m1;
+			return;
+		}
+		row[w0] |= m0;
+		for (auto w = w0 + 1; w < w1; ++w) {
+			row[w] = ~0ull;
+		}
+		row[w1] |= m1;
+	}
+
+	/// 行の[x0, x1)にビットが一つでも立っているか調べる関数
+	///
+	/// WARN: 0 <= x0 < x1 <= widthであること。
+	static inline bool testRow(const uint64_t *row, int x0, int x1) {
+		const auto w0 = static_cast<size_t>(x0) / 64;
+		const auto w1 = static_cast<size_t>(x1 - 1) / 64;
+		const auto m0 = ~0ull << (x0 % 64);
+		const auto m1 = ~0ull >> (63 - (x1 - 1) % 64);
+		if (w0 == w1) {
+			return (row[w0] & m0 & m1) != 0;
+		}
+		uint64_t acc = (row[w0] & m0) | (row[w1] & m1);
+		for (auto w = w0 + 1; w < w1; ++w) {
+			acc |= row[w];
+		}
+		return acc != 0;
+	}
+
+	/// 画素xから始まる64画素分のビットbitsを、ビットマップの内側に切り詰めて語の位置に合わせる関数
+	///
+	/// 立つビットが残らなければfalseを返す。
+	inline bool clipBits(int &x, uint64_t &bits) const {
+		if (x < 0) {
+			bits = x > -64 ? bits >> -x : 0;
+			x = 0;
+		}
+		const auto n = _width - x;
+		if (n <= 0) {
+			return false;
+		}
+		if (n < 64) {
+			bits &= (1ull << n) - 1;
+		}
+		return bits != 0;
+	}
+
+	/// 行の画素xから始まる64画素分にビットbitsを立てる関数
+	inline void orBits(uint64_t *row, int x, uint64_t bits) const {
+		if (!clipBits(x, bits)) {
+			return;
+		}
+		const auto w = static_cast<size_t>(x) / 64;
+		const auto s = x % 64;
+		row[w] |= bits << s;
+		if (s != 0 && (bits >> (64 - s)) != 0) {
+			row[w + 1] |= bits >> (64 - s);
+		}
+	}
+
+	/// 行の画素xから始まる64画素分のうち、ビットbitsの位置にビットが一つでも立っているか調べる関数
+	inline bool testBits(const uint64_t *row, int x, uint64_t bits) const {
+		if (!clipBits(x, bits)) {
+			return false;
+		}
+		const auto w = static_cast<size_t>(x) / 64;
+		const auto s = x % 64;
+		if ((row[w] & (bits << s)) != 0) {
+			return true;
+		}
+		return s != 0 && (bits >> (64 - s)) != 0 && (row[w + 1] & (bits >> (64 - s))) != 0;
+	}
+
+	/// 足跡footprintが覆う行の範囲を、ビットマップの内側に切り詰めて[k0, k1)として求める関数
+	inline void getFootprintRows(const DiskFootprint &footprint, int y, int &k0, int &k1) const {
+		k0 = std::max(-(y + footprint.top), 0);
+		k1 = std::min(static_cast<int>(footprint.rowCount), _height - (y + footprint.top));
+	}
+
+	/// 円(cx, cy, r)の行yにおける画素の範囲[x0, x1)を求める関数
+	///
+	/// 範囲が空ならばfalseを返す。範囲はビットマップの内側に切り詰められる。
+	inline bool getDiskSpan(float cx, float cy, float r, int y, int &x0, int &x1) const {
+		if (!getCenterDiskSpan(cx, cy, r, y, x0, x1)) {
+			return false;
+		}
+		x0 = std::max(x0, 0);
+		x1 = std::min(x1, _width);
+		return x0 < x1;
+	}
+
+	/// 円(cx, cy, r)が覆う行の範囲[y0, y1)を、ビットマップの内側に切り詰めて求める関数
+	inline void getDiskRows(float cy, float r, int &y0, int &y1) const {
+		getCenterDiskRows(cy, r, y0, y1);
+		y0 = std::max(y0, 0);
+		y1 = std::min(y1, _height);
+	}
+
+	/// 円(cx, cy, r)と少しでも重なる行の範囲[y0, y1)を、ビットマップの内側に切り詰めて求める関数
+	inline void getConservativeRows(float cy, float r, int &y0, int &y1) const {
+		getConservativeDiskRows(cy, r, y0, y1);
+		y0 = std::max(y0, 0);
+		y1 = std::min(y1, _height);
+	}
+
+	/// 円(cx, cy, r)と少しでも重なる、行yの画素の範囲[x0, x1)を、ビットマップの内側に切り詰めて求める関数
+	inline bool getConservativeSpan(float cx, float cy, float r, int y, int &x0, int &x1) const {
+		if (!getConservativeDiskSpan(cx, cy, r, y, x0, x1)) {
+			return false;
+		}
+		x0 = std::max(x0, 0);
+		x1 = std::min(x1, _width);
+		return x0 < x1;
+	}
+
+	/// 行の中心を通る水平線と図形との交わり[lo, hi]を、画素の範囲[x0, x1)に直す関数
+	inline bool toPixelSpan(float lo, float hi, int &x0, int &x1) const {
+		if (lo > hi) {
+			return false;
+		}
+		x0 = std::max(static_cast<int>(std::ceil(lo - 0.5f)), 0);
+		x1 = std::min(static_cast<int>(std::floor(hi - 0.5f)) + 1, _width);
+		return x0 < x1;
+	}
+
+	/// 線分(ax, ay)-(bx, by)を半径rだけ太らせたカプセル
+	///
+	/// 胴体の長方形の辺は、行ごとの交点計算が乗算だけで済むよう傾きの逆数を前もって求めておく。
+	struct Capsule {
+		struct Edge {
+			float x0;
+			float y0;
+			float y1;
+			float dxdy;
+		};
+
+		float ax;
+		float ay;
+		float bx;
+		float by;
+		float r;
+		std::array<Edge, 4> edges;
+		size_t edgeCount;
+
+		Capsule(float ax_, float ay_, float bx_, float by_, float r_): ax(ax_), ay(ay_), bx(bx_), by(by_), r(r_), edges{}, edgeCount(0) {
+			const auto dx = bx - ax;
+			const auto dy = by - ay;
+			const auto len = std::sqrt(dx * dx + dy * dy);
+			if (len <= 0.0f) {
+				return;
+			}
+			const auto nx = -dy / len * r;
+			const auto ny = dx / len * r;
+			const std::array<std::pair<float, float>, 4> quad{
+				std::pair{ax + nx, ay + ny},
+				std::pair{bx + nx, by + ny},
+				std::pair{bx - nx, by - ny},
+				std::pair{ax - nx, ay - ny},
+			};
+			for (size_t i = 0; i < quad.size(); ++i) {
+				const auto [px, py] = quad[i];
+				const auto [qx, qy] = quad[(i + 1) % quad.size()];
+				if (py == qy) {
+					continue;
+				}
+				edges[edgeCount] = {px, py, qy, (qx - px) / (qy - py)};
+				edgeCount += 1;
+			}
+		}
+	};
+
+	/// カプセルの行yにおける画素の範囲[x0, x1)を求める関数
+	///
+	/// カプセルは凸なので、両端の円と胴体の長方形とのそれぞれと水平線との交わりを合わせれば一つの区間になる。
+	inline bool getCapsuleSpan(const Capsule &capsule, int y, int &x0, int &x1) const {
+		const auto yc = static_cast<float>(y) + 0.5f;
+		auto lo = HUGE_VALF;
+		auto hi = -HUGE_VALF;
+		for (const auto &[cx, cy]: {std::pair{capsule.ax, capsule.ay}, std::pair{capsule.bx, capsule.by}}) {
+			const auto dy = yc - cy;
+			const auto hh = capsule.r * capsule.r - dy * dy;
+			if (hh >= 0.0f) {
+				const auto half = std::sqrt(hh);
+				lo = std::min(lo, cx - half);
+				hi = std::max(hi, cx + half);
+			}
+		}
+		for (size_t i = 0; i < capsule.edgeCount; ++i) {
+			const auto &edge = capsule.edges[i];
+			if ((edge.y0 - yc) * (edge.y1 - yc) > 0.0f) {
+				continue;
+			}
+			const auto x = edge.x0 + (yc - edge.y0) * edge.dxdy;
+			lo = std::min(lo, x);
+			hi = std::max(hi, x);
+		}
+		return toPixelSpan(lo, hi, x0, x1);
+	}
+
+	/// 行の範囲[y0, y1)について、span(y, x0, x1)が返す画素の範囲を物体群groupの面に描画する関数
+	template<typename F>
+	inline void fillShape(unsigned int group, int y0, int y1, F span) {
+		for (int y = y0; y < y1; ++y) {
+			int x0, x1;
+			if (span(y, x0, x1)) {
+				fillRow(getRow(group, y), x0, x1);
+			}
+		}
+	}
+
+	/// 行の範囲[y0, y1)について、span(y, x0, x1)が返す画素の範囲と重なっているmaskの物体群を調べる関数
+	///
+	/// maskのビットがすべて見つかった時点で打ち切る。
+	template<typename F>
+	inline uint32_t overlapShape(int y0, int y1, uint32_t mask, F span) const {
+		uint32_t found = 0;
+		for (int y = y0; y < y1; ++y) {
+			int x0, x1;
+			if (!span(y, x0, x1)) {
+				continue;
+			}
+			for (auto bits = mask & ~found; bits != 0; bits &= bits - 1) {
+				const auto g = static_cast<unsigned int>(std::countr_zero(bits));
+				if (testRow(getRow(g, y), x0, x1)) {
+					found |= 1u << g;
+				}
+			}
+			if (found == mask) {
+				break;
+			}
+		}
+		return found;
+	}
+
+public:
+	explicit SoftwareBitmap(int width, int height, unsigned int groupCount, float scale = 1.0f, int originX = 0, int originY = 0):
+		_width(width),
+		_height(height),
+		_wordsPerRow((static_cast<size_t>(width) + 63) / 64),
+		_groupCount(groupCount),
+		_scale(scale),
+		_originX(originX),
+		_originY(originY),
+		_planes(_wordsPerRow * height * groupCount, 0),
+		_occupancy(width, height),
+		_footprints(nullptr),
+		_coverage(Coverage::center())
+	{}
+	SoftwareBitmap() = delete;
+	SoftwareBitmap(const SoftwareBitmap &) = delete;
+	SoftwareBitmap(const SoftwareBitmap &&) = delete;
+	SoftwareBitmap &operator=(const SoftwareBitmap &) = delete;
+	SoftwareBitmap &&operator=(const SoftwareBitmap &&) = delete;
+	~SoftwareBitmap() = default;
+
+	inline int getWidth() const {
+		return _width;
+	}
+	inline int getHeight() const {
+		return _height;
+	}
+	inline size_t getWordsPerRow() const {
+		return _wordsPerRow;
+	}
+	inline unsigned int getGroupCount() const {
+		return _groupCount;
+	}
+	inline float getScale() const {
+		return _scale;
+	}
+	inline int getOriginX() const {
+		return _originX;
+	}
+	inline int getOriginY() const {
+		return _originY;
+	}
+	inline uint64_t *getRow(unsigned int group, int y) {
+		return &_planes[(static_cast<size_t>(group) * _height + y) * _wordsPerRow];
+	}
+	inline const uint64_t *getRow(unsigned int group, int y) const {
+		return &_planes[(static_cast<size_t>(group) * _height + y) * _wordsPerRow];
+	}
+
+	/// 円の描画と照合とに用いる足跡の表を設定する関数
+	///
+	/// 設定すると、表の範囲の半径の円は足跡の表引きで描画・照合する(中心と半径とは1/4pxに丸められる)。
+	/// nullptrならばすべての円を行ごとに解析的に求める。
+	/// WARN: 表はビットマップより長く生存させること。
+	inline void setFootprints(const DiskFootprints *footprints) {
+		_footprints = footprints;
+	}
+
+	/// 描画と照合とで画素を覆っているとみなす規則を設定する関数
+	///
+	/// 足跡の表は中心・しきい値の規則でだけ用いる(しきい値の規則では半径を変えた円の足跡を引く)。
+	/// カプセルは保守的な規則では画素の対角線の半分だけ太らせて近似する。
+	inline void setCoverage(const Coverage &coverage) {
+		_coverage = coverage;
+	}
+	inline const Coverage &getCoverage() const {
+		return _coverage;
+	}
+
+	inline void clear() {
+		std::fill(_planes.begin(), _planes.end(), 0);
+	}
+	/// 物体群groupの面だけを消す関数
+	inline void clear(unsigned int group) {
+		std::fill(getRow(group, 0), getRow(group, 0) + _wordsPerRow * _height, 0);
+	}
+
+	/// 物体群groupの面に円(cx, cy, r)を描画する関数
+	///
+	/// 足跡の表が設定されていて半径がその範囲にあれば、表の行をシフトして論理和をとるだけで描画する。
+	inline void drawDisk(unsigned int group, float cx, float cy, float r) {
+		cx = toPixelX(cx);
+		cy = toPixelY(cy);
+		r *= _scale;
+		if (_coverage.mode == CoverageMode::Conservative) {
+			int y0, y1;
+			getConservativeRows(cy, r, y0, y1);
+			fillShape(group, y0, y1, [&](int y, int &x0, int &x1) { return getConservativeSpan(cx, cy, r, y, x0, x1); });
+			return;
+		}
+		r = getCoveredRadius(r, _coverage);
+		int x, y;
+		if (const auto *footprint = _footprints ? _footprints->find(cx, cy, r, x, y) : nullptr) {
+			const auto *fill = _footprints->getFill(*footprint);
+			int k0, k1;
+			getFootprintRows(*footprint, y, k0, k1);
+			for (auto k = k0; k < k1; ++k) {
+				orBits(getRow(group, y + footprint->top + k), x + footprint->left, fill[k]);
+			}
+			return;
+		}
+		int y0, y1;
+		getDiskRows(cy, r, y0, y1);
+		fillShape(group, y0, y1, [&](int y, int &x0, int &x1) { return getDiskSpan(cx, cy, r, y, x0, x1); });
+	}
+
+	/// 物体群groupの面に線分(ax, ay)-(bx, by)を半径rだけ太らせたカプセルを描画する関数
+	inline void drawCapsule(unsigned int group, float ax, float ay, float bx, float by, float r) {
+		ax = toPixelX(ax);
+		ay = toPixelY(ay);
+		bx = toPixelX(bx);
+		by = toPixelY(by);
+		r = getCoveredRadius(r * _scale, _coverage);
+		int y0, y1;
+		getDiskRows((ay + by) / 2.0f, std::abs(by - ay) / 2.0f + r, y0, y1);
+		const Capsule capsule(ax, ay, bx, by, r);
+		fillShape(group, y0, y1, [&](int y, int &x0, int &x1) { return getCapsuleSpan(capsule, y, x0, x1); });
+	}
+
+	/// 物体群groupの面に、(cx, cy)に半径rで角度angleだけ回して置いたatlasの形shapeを描画する関数
+	inline void drawMask(unsigned int group, const MaskAtlas &atlas, uint32_t shape, float cx, float cy, float r, float angle = 0.0f) {
+		forEachMaskSpan(atlas, shape, toPixelX(cx), toPixelY(cy), r * _scale, angle, _coverage, _width, _height, [&](int y, int x0, int x1) {
+			fillRow(getRow(group, y), x0, x1);
+		});
+	}
+
+	/// 物体群groupのすべての物体を描画する関数
+	///
+	/// atlasを渡すと、円以外の形の物体はその形で描画する。
+	inline void drawGroup(unsigned int group, const EntityGroup &entities, const MaskAtlas *atlas = nullptr) {
+		for (size_t i = 0; i < entities.size(); ++i) {
+			if (atlas && entities.shape[i] != SHAPE_CIRCLE) {
+				drawMask(group, *atlas, entities.shape[i], entities.x[i], entities.y[i], entities.r[i], entities.angle[i]);
+			} else {
+				drawDisk(group, entities.x[i], entities.y[i], entities.r[i]);
+			}
+		}
+	}
+
+	/// 物体群groupのすべての物体を、直前の位置から現在の位置までのカプセルとして描画する関数
+	inline void drawGroupSwept(unsigned int group, const EntityGroup &entities) {
+		for (size_t i = 0; i < entities.size(); ++i) {
+			drawCapsule(group, entities.px[i], entities.py[i], entities.x[i], entities.y[i], entities.r[i]);
+		}
+	}
+
+	/// 画素(x, y)にmaskの物体群のうちどれが存在するか調べる関数
+	///
+	/// 存在する物体群のビットを返す。ビットマップの外側では0を返す。
+	/// NOTE: (x, y)はワールドの座標ではなくビットマップの画素の番号。
+	inline uint32_t check(int x, int y, uint32_t mask) const {
+		if (x < 0 || x >= _width || y < 0 || y >= _height) {
+			return 0;
+		}
+		uint32_t found = 0;
+		for (auto bits = mask; bits != 0; bits &= bits - 1) {
+			const auto g = static_cast<unsigned int>(std::countr_zero(bits));
+			if ((getRow(g, y)[x / 64] >> (x % 64)) & 1) {
+				found |= 1u << g;
+			}
+		}
+		return found;
+	}
+
+	/// 円(cx, cy, r)と重なっているmaskの物体群を調べる関数
+	///
+	/// 円の画素と物体群の面とを行ごとに照合し、重なっている物体群のビットを返す。
+	/// 足跡の表が設定されていて半径がその範囲にあれば、表の行をシフトして論理積をとって照合する。
+	/// maskのビットがすべて見つかった時点で打ち切る。
+	inline uint32_t overlapDisk(float cx, float cy, float r, uint32_t mask) const {
+		cx = toPixelX(cx);
+		cy = toPixelY(cy);
+		r *= _scale;
+		if (_coverage.mode == CoverageMode::Conservative) {
+			int y0, y1;
+			getConservativeRows(cy, r, y0, y1);
+			return overlapShape(y0, y1, mask, [&](int y, int &x0, int &x1) { return getConservativeSpan(cx, cy, r, y, x0, x1); });
+		}
+		r = getCoveredRadius(r, _coverage);
+		int x, y;
+		if (const auto *footprint = _footprints ? _footprints->find(cx, cy, r, x, y) : nullptr) {
+			const auto *fill = _footprints->getFill(*footprint);
+			int k0, k1;
+			getFootprintRows(*footprint, y, k0, k1);
+			uint32_t found = 0;
+			for (auto k = k0; k < k1 && found != mask; ++k) {
+				for (auto bits = mask & ~found; bits != 0; bits &= bits - 1) {
+					const auto g = static_cast<unsigned int>(std::countr_zero(bits));
+					if (testBits(getRow(g, y + footprint->top + k), x + footprint->left, fill[k])) {
+						found |= 1u << g;
+					}
+				}
+			}
+			return found;
+		}
+		int y0, y1;
+		getDiskRows(cy, r, y0, y1);
+		return overlapShape(y0, y1, mask, [&](int y, int &x0, int &x1) { return getDiskSpan(cx, cy, r, y, x0, x1); });
+	}
+
+	/// (cx, cy)に半径rで角度angleだけ回して置いたatlasの形shapeと重なっているmaskの物体群を調べる関数
+	///
+	/// 形の画素の範囲と物体群の面とを行ごとに照合する。見つかった物体群は以後の行では調べない。
+	inline uint32_t overlapMask(const MaskAtlas &atlas, uint32_t shape, float cx, float cy, float r, float angle, uint32_t mask) const {
+		uint32_t found = 0;
+		forEachMaskSpan(atlas, shape, toPixelX(cx), toPixelY(cy), r * _scale, angle, _coverage, _width, _height, [&](int y, int x0, int x1) {
+			for (auto bits = mask & ~found; bits != 0; bits &= bits - 1) {
+				const auto g = static_cast<unsigned int>(std::countr_zero(bits));
+				if (testRow(getRow(g, y), x0, x1)) {
+					found |= 1u << g;
+				}
+			}
+		});
+		return found;
+	}
+
+	/// 線分(ax, ay)-(bx, by)を半径rだけ太らせたカプセルと重なっているmaskの物体群を調べる関数
+	///
+	/// NOTE: 面には時刻の情報がないため、同じ時刻に重なったかは区別できない(保守的な判定になる)。
+	inline uint32_t overlapCapsule(float ax, float ay, float bx, float by, float r, uint32_t mask) const {
+		ax = toPixelX(ax);
+		ay = toPixelY(ay);
+		bx = toPixelX(bx);
+		by = toPixelY(by);
+		r = getCoveredRadius(r * _scale, _coverage);
+		int y0, y1;
+		getDiskRows((ay + by) / 2.0f, std::abs(by - ay) / 2.0f + r, y0, y1);
+		const Capsule capsule(ax, ay, bx, by, r);
+		return overlapShape(y0, y1, mask, [&](int y, int &x0, int &x1) { return getCapsuleSpan(capsule, y, x0, x1); });
+	}
+
+	/// 粗い占有格子を面から作り直す関数
+	///
+	/// 各面の語を8bitずつ調べ、8x8画素の升目に物体群のビットを加える。
+	/// WARN: 描画した後、castRays()の前に呼ぶこと。
+	void updateOccupancy() {
+		static_assert(OCCUPANCY_CELL_SIZE == 8, "occupancy cells are built from bytes of a word.");
+		_occupancy.fill(0);
+		for (unsigned int g = 0; g < _groupCount; ++g) {
+			const auto bit = 1u << g;
+			for (int y = 0; y < _height; ++y) {
+				const auto *row = getRow(g, y);
+				const auto cy = y >> OCCUPANCY_CELL_SHIFT;
+				for (size_t w = 0; w < _wordsPerRow; ++w) {
+					for (auto word = row[w]; word != 0; word &= ~(0xffull << (std::countr_zero(word) & ~7))) {
+						const auto cx = static_cast<int>(w * 8 + std::countr_zero(word) / 8);
+						_occupancy.mark(cx, cy, bit);
+					}
+				}
+			}
+		}
+	}
+
+	inline const OccupancyGrid &getOccupancy() const {
+		return _occupancy;
+	}
+
+	/// count本の光線raysが最初に通るmaskの物体群の画素までの距離を求める関数
+	///
+	/// 光線と距離とはワールドの座標で表す。
+	/// 結果はdistances[q * groupCount + g]に書かれる(castRays()を参照)。確保は起こらない。
+	/// WARN: updateOccupancy()で占有格子を作り直しておくこと。
+	inline void castRays(const Ray *rays, size_t count, uint32_t mask, float *distances) const {
+		const auto check = [this](int x, int y, uint32_t m) {
+			return this->check(x, y, m);
+		};
+		if (_scale == 1.0f && _originX == 0 && _originY == 0) {
+			::castRays(_occupancy, rays, count, mask, distances, _groupCount, check);
+			return;
+		}
+		for (size_t q = 0; q < count; ++q) {
+			const auto &ray = rays[q];
+			const Ray scaled{toPixelX(ray.x), toPixelY(ray.y), ray.dx, ray.dy, ray.length * _scale};
+			auto *results = distances + q * _groupCount;
+			castRay(_occupancy, scaled, mask, results, check);
+			for (auto bits = mask; bits != 0; bits &= bits - 1) {
+				results[std::countr_zero(bits)] /= _scale;
+			}
+		}
+	}
+};
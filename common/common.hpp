@@ -1,50 +1,355 @@
 #pragma once
 
 #include "constant.hpp"
+#include "contact.hpp"
+#include "coverage.hpp"
+#include "footprint.hpp"
+#include "mask.hpp"
+#include "snapshot.hpp"
+#include "world.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <optional>
 #include <vector>
 
 #undef max
 #undef min
 
-class EntityBase {
-protected:
-	float _x, _y, _r, _spd, _dir;
+/// 物体群の最大数
+///
+/// NOTE: 衝突判定ビットマップの1画素(32bit)に物体群ごとに1bitを割り当てるため、32個まで。
+constexpr unsigned int MAX_GROUP_COUNT = 32;
+
+/// 物体群どうしが衝突判定を行うかを表す対称行列
+///
+/// 行はビット集合で持ち、i行目のjビット目が立っていればi群とj群とが衝突判定を行う。
+class InteractionMatrix final {
+private:
+	std::array<uint32_t, MAX_GROUP_COUNT> _rows;
 
 public:
-	EntityBase(float x, float y, float r, float spd, float dir): _x(x), _y(y), _r(r), _spd(spd), _dir(dir) {}
-	virtual ~EntityBase() = default;
-	inline void update() {
-		_x += _spd * std::cosf(_dir);
-		_y += _spd * std::sinf(_dir);
-		if (_x < 0.0f || _x > WIDTH_FLOAT) {
-			_dir = PI - _dir;
-			_x = std::max(std::min(_x, WIDTH_FLOAT), 0.0f);
+	InteractionMatrix(): _rows{} {}
+
+	inline void set(unsigned int a, unsigned int b, bool enabled = true) {
+		if (enabled) {
+			_rows[a] |= 1u << b;
+			_rows[b] |= 1u << a;
+		} else {
+			_rows[a] &= ~(1u << b);
+			_rows[b] &= ~(1u << a);
+		}
+	}
+	inline bool interacts(unsigned int a, unsigned int b) const {
+		return (_rows[a] >> b) & 1;
+	}
+	inline uint32_t getRow(unsigned int a) const {
+		return _rows[a];
+	}
+};
+
+/// 物体群の生成方法
+///
+/// rMaxがrより大きければ、半径は[r, rMax]から対数が一様になるよう決定的に選ばれる。
+/// spreadが正ならば、物体は一列ではなく[y, y + spread)の範囲に決定的に散らばる。
+/// shapeは物体の衝突判定の形の番号(MaskAtlasを参照)。
+struct GroupDesc {
+	size_t count;
+	float y;
+	float r;
+	float spd;
+	float rMax = 0.0f;
+	float spread = 0.0f;
+	uint32_t shape = SHAPE_CIRCLE;
+};
+
+/// 物体群
+///
+/// 物体の状態を要素ごとの配列(SoA)で持つ。px, pyは直前のupdate()を呼ぶ前の位置。
+/// shapeは衝突判定の形の番号で、半径rの円に外接する正方形に合わせて置かれる。
+/// angleは形の回転角(ラジアン、dirと同じく画面の下向きがπ/2)。円の判定には影響しない。
+struct EntityGroup {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> r;
+	std::vector<float> spd;
+	std::vector<float> dir;
+	std::vector<float> px;
+	std::vector<float> py;
+	std::vector<uint32_t> shape;
+	std::vector<float> angle;
+
+	inline size_t size() const {
+		return x.size();
+	}
+	inline void reserve(size_t count) {
+		for (auto *n: {&x, &y, &r, &spd, &dir, &px, &py, &angle}) {
+			n->reserve(count);
+		}
+		shape.reserve(count);
+	}
+	inline void push(float x_, float y_, float r_, float spd_, float dir_, uint32_t shape_ = SHAPE_CIRCLE, float angle_ = 0.0f) {
+		x.push_back(x_);
+		y.push_back(y_);
+		r.push_back(r_);
+		spd.push_back(spd_);
+		dir.push_back(dir_);
+		px.push_back(x_);
+		py.push_back(y_);
+		shape.push_back(shape_);
+		angle.push_back(angle_);
+	}
+
+	/// 物体の並びを入れ替える関数
+	///
+	/// order[i]は新しい並びでi番目になる物体の、元の並びでの番号。scratch, shapeScratchは作業領域。
+	inline void permute(const uint32_t *order, std::vector<float> &scratch, std::vector<uint32_t> &shapeScratch) {
+		scratch.resize(size());
+		for (auto *n: {&x, &y, &r, &spd, &dir, &px, &py, &angle}) {
+			for (size_t i = 0; i < size(); ++i) {
+				scratch[i] = (*n)[order[i]];
+			}
+			std::swap(*n, scratch);
+		}
+		shapeScratch.resize(size());
+		for (size_t i = 0; i < size(); ++i) {
+			shapeScratch[i] = shape[order[i]];
 		}
-		if (_y < 0.0f || _y > HEIGHT_FLOAT) {
-			_dir += PI;
-			_y = std::max(std::min(_y, HEIGHT_FLOAT), 0.0f);
+		std::swap(shape, shapeScratch);
+	}
+	/// 物体をワールドworldの中で動かす関数
+	///
+	/// ワールドの端に達した物体は跳ね返る。
+	inline void update(const WorldBounds &world) {
+		update(0, size(), world);
+	}
+	/// [begin, end)の物体だけを動かす関数
+	///
+	/// 物体ごとに独立なため、区間に分けて並列に呼べる。
+	inline void update(size_t begin, size_t end, const WorldBounds &world) {
+		for (size_t i = begin; i < end; ++i) {
+			px[i] = x[i];
+			py[i] = y[i];
+			x[i] += spd[i] * std::cos(dir[i]);
+			y[i] += spd[i] * std::sin(dir[i]);
+			if (x[i] < 0.0f || x[i] > world.width) {
+				dir[i] = PI - dir[i];
+				x[i] = std::max(std::min(x[i], world.width), 0.0f);
+			}
+			if (y[i] < 0.0f || y[i] > world.height) {
+				dir[i] += PI;
+				y[i] = std::max(std::min(y[i], world.height), 0.0f);
+			}
 		}
 	}
 };
 
-template<typename T>
+/// 物体の識別子
+///
+/// 上位8bitが物体群の番号、下位24bitが物体群の中での生成順の番号。
+/// 物体群の並びを入れ替えても変わらない。現在の位置はSceneBase::getSlotOf()で求める。
+using EntityId = uint32_t;
+
+inline EntityId makeEntityId(unsigned int group, size_t index) {
+	return (static_cast<EntityId>(group) << 24) | static_cast<EntityId>(index);
+}
+inline unsigned int getGroupOf(EntityId id) {
+	return id >> 24;
+}
+inline uint32_t getIndexOf(EntityId id) {
+	return id & 0x00ffffff;
+}
+
+/// かすり判定の設定
+///
+/// querier群の物体がtarget群の物体に重ならずにmargin以内まで近づいたとき、かすりとして数える。
+struct GrazeDesc {
+	unsigned int querier;
+	unsigned int target;
+	float margin;
+};
+
+/// descの物体を、ワールドworldのg番目の物体群としてgroupの末尾に生成する関数
+///
+/// 物体はワールドの横幅に等間隔に並び、向きは10度ずつずれる。
+inline void spawnGroup(EntityGroup &group, const GroupDesc &desc, unsigned int g, const WorldBounds &world) {
+	const auto dx = world.width / static_cast<float>(std::max(desc.count, static_cast<size_t>(1)));
+	for (size_t i = 0; i < desc.count; ++i) {
+		const auto fi = static_cast<float>(i);
+		auto r = desc.r;
+		if (desc.rMax > desc.r) {
+			// 黄金比の小数部による低食い違い列で、物体の並びと半径とが相関しないようにする
+			const auto u = std::fmod(static_cast<float>(i) * 0.618034f, 1.0f);
+			r = desc.r * std::pow(desc.rMax / desc.r, u);
+		}
+		auto y = desc.y;
+		if (desc.spread > 0.0f) {
+			// 半径とは別の無理数(プラスチック数の逆数)を用い、同じ設定の物体群どうしが重ならないよう物体群ごとにずらす
+			y += desc.spread * std::fmod(static_cast<float>(i) * 0.754878f + static_cast<float>(g) * 0.5f, 1.0f);
+		}
+		group.push(fi * dx + dx / 2.0f, y, r, desc.spd, (fi * 10.0f) * PI / 180.0f, desc.shape);
+	}
+}
+
 class SceneBase {
 protected:
 	unsigned long long _hitCount;
-	std::vector<T> _entities1;
-	std::vector<T> _entities2;
+	unsigned long long _grazeCount;
+	std::optional<GrazeDesc> _graze;
+	std::vector<EntityGroup> _groups;
+	InteractionMatrix _matrix;
+	ContactBuffer *_contacts;
+	HitBitset *_hits;
+
+	/// 物体群ごとの、並びの位置から物体の番号(EntityIdの下位24bit)への表
+	std::vector<std::vector<uint32_t>> _handles;
+	/// 物体群ごとの、物体の番号から並びの位置への表
+	std::vector<std::vector<uint32_t>> _slots;
+	std::vector<float> _permuteScratch;
+	std::vector<uint32_t> _shapeScratch;
+	const MaskAtlas *_atlas;
+	const DiskFootprints *_footprints;
+	Coverage _coverage;
+	WorldBounds _world;
+
+	/// 物体群gのslot番目の物体の衝突フラグを立てる関数
+	inline void emitHit(unsigned int g, size_t slot) {
+		if (_hits) {
+			_hits[g].set(_handles[g][slot]);
+		}
+	}
+
+	/// emitHit()と同じだが、複数のスレッドから同時に呼べる関数
+	inline void emitHitConcurrent(unsigned int g, size_t slot) {
+		if (_hits) {
+			_hits[g].setConcurrent(_handles[g][slot]);
+		}
+	}
+
+	/// 物体群aのi番目の物体と物体群bのj番目の物体との衝突を書き出す関数
+	///
+	/// 同じ物体群どうしの組は番号の小さい物体を先にし、並びの入れ替えによらず同じ組を書き出す。
+	inline void emitContact(unsigned int a, size_t i, unsigned int b, size_t j) {
+		if (_contacts) {
+			const auto ida = makeEntityId(a, _handles[a][i]);
+			const auto idb = makeEntityId(b, _handles[b][j]);
+			_contacts->push(std::min(ida, idb), std::max(ida, idb));
+		}
+		emitHit(a, i);
+		emitHit(b, j);
+	}
+
+	/// 物体の状態と、番号と位置との表と、累計の衝突数・かすり数とをsnapshotに書き込む関数
+	void saveState(Snapshot &snapshot) const {
+		snapshot.write(_hitCount);
+		snapshot.write(_grazeCount);
+		for (size_t g = 0; g < _groups.size(); ++g) {
+			const auto &group = _groups[g];
+			for (const auto *n: {&group.x, &group.y, &group.r, &group.spd, &group.dir, &group.px, &group.py, &group.angle}) {
+				snapshot.write(*n);
+			}
+			snapshot.write(group.shape);
+			snapshot.write(_handles[g]);
+			snapshot.write(_slots[g]);
+		}
+	}
+
+	/// saveState()で書き込んだ状態を読み出す関数
+	void restoreState(Snapshot &snapshot) {
+		snapshot.read(_hitCount);
+		snapshot.read(_grazeCount);
+		for (size_t g = 0; g < _groups.size(); ++g) {
+			auto &group = _groups[g];
+			for (auto *n: {&group.x, &group.y, &group.r, &group.spd, &group.dir, &group.px, &group.py, &group.angle}) {
+				snapshot.read(*n);
+			}
+			snapshot.read(group.shape);
+			snapshot.read(_handles[g]);
+			snapshot.read(_slots[g]);
+		}
+	}
+
+	/// 物体群gの並びを入れ替え、番号と位置との表を更新する関数
+	///
+	/// order[i]は新しい並びでi番目になる物体の、元の並びでの位置。
+	void permuteGroup(unsigned int g, const uint32_t *order) {
+		auto &handles = _handles[g];
+		auto &slots = _slots[g];
+		_groups[g].permute(order, _permuteScratch, _shapeScratch);
+		for (size_t i = 0; i < handles.size(); ++i) {
+			slots[i] = handles[order[i]];
+		}
+		std::swap(handles, slots);
+		for (size_t i = 0; i < handles.size(); ++i) {
+			slots[handles[i]] = static_cast<uint32_t>(i);
+		}
+	}
+
+	/// 衝突結果の出力先が一つでも設定されているか
+	inline bool hasContactOutput() const {
+		return _contacts || _hits;
+	}
+
+	/// フレームの開始時に衝突結果の出力先を空にする関数
+	inline void clearContactOutput() {
+		if (_contacts) {
+			_contacts->clear();
+		}
+		if (_hits) {
+			for (size_t i = 0; i < _groups.size(); ++i) {
+				_hits[i].clear();
+			}
+		}
+	}
 
 public:
-	explicit SceneBase(size_t entityCount): _hitCount(0) {
-		_entities1.reserve(entityCount);
-		_entities2.reserve(entityCount);
-		const auto dx = WIDTH_FLOAT / static_cast<float>(entityCount);
-		for (int i = 0; i < entityCount; ++i) {
-			_entities1.emplace_back(i * dx + dx / 2.0f,          10.0f, 5.0f, 2.5f, (i * 10.0f) * PI / 180.0f);
-			_entities2.emplace_back(i * dx + dx / 2.0f, HEIGHT - 10.0f, 5.0f, 2.5f, (i * 10.0f) * PI / 180.0f);
+	/// ワールドworldの上端と下端とに並んだ二つの物体群が互いに衝突判定を行うシーンを作る
+	explicit SceneBase(size_t entityCount, const WorldBounds &world = getDefaultWorld()):
+		SceneBase(
+			{
+				GroupDesc{entityCount,                  10.0f, 5.0f, 2.5f},
+				GroupDesc{entityCount, world.height - 10.0f, 5.0f, 2.5f},
+			},
+			[]() {
+				InteractionMatrix matrix;
+				matrix.set(0, 1);
+				return matrix;
+			}(),
+			world
+		)
+	{}
+	/// 物体群をdescsのとおりにワールドworldの中に生成したシーンを作る
+	explicit SceneBase(const std::vector<GroupDesc> &descs, const InteractionMatrix &matrix, const WorldBounds &world = getDefaultWorld()):
+		_hitCount(0),
+		_grazeCount(0),
+		_graze(std::nullopt),
+		_groups(descs.size()),
+		_matrix(matrix),
+		_contacts(nullptr),
+		_hits(nullptr),
+		_handles(descs.size()),
+		_slots(descs.size()),
+		_atlas(nullptr),
+		_footprints(nullptr),
+		_coverage(Coverage::center()),
+		_world(world)
+	{
+		if (descs.size() > MAX_GROUP_COUNT) {
+			throw "too many groups.";
+		}
+		if (world.width <= 0.0f || world.height <= 0.0f) {
+			throw "the world must have a positive size.";
+		}
+		for (size_t g = 0; g < descs.size(); ++g) {
+			const auto &desc = descs[g];
+			_groups[g].reserve(desc.count);
+			spawnGroup(_groups[g], desc, static_cast<unsigned int>(g), _world);
+			for (size_t i = 0; i < desc.count; ++i) {
+				_handles[g].push_back(static_cast<uint32_t>(i));
+				_slots[g].push_back(static_cast<uint32_t>(i));
+			}
 		}
 	}
 	virtual ~SceneBase() = default;
@@ -54,4 +359,91 @@ public:
 	inline unsigned long long getHitCount() const {
 		return _hitCount;
 	}
+	inline unsigned long long getGrazeCount() const {
+		return _grazeCount;
+	}
+	inline size_t getGroupCount() const {
+		return _groups.size();
+	}
+	inline size_t getEntityCount() const {
+		size_t count = 0;
+		for (const auto &n: _groups) {
+			count += n.size();
+		}
+		return count;
+	}
+	inline const EntityGroup &getGroup(unsigned int group) const {
+		return _groups[group];
+	}
+	inline const WorldBounds &getWorld() const {
+		return _world;
+	}
+
+	/// 物体idの、物体群の中での現在の位置を返す関数
+	///
+	/// 物体群の並びは入れ替わることがあるため、EntityIdは位置ではなく生成順の番号を持つ。
+	inline size_t getSlotOf(EntityId id) const {
+		return _slots[getGroupOf(id)][getIndexOf(id)];
+	}
+
+	/// 物体群groupのslot番目の物体の識別子を返す関数
+	inline EntityId getEntityIdAt(unsigned int group, size_t slot) const {
+		return makeEntityId(group, _handles[group][slot]);
+	}
+
+	/// 衝突結果の出力先を設定する関数
+	///
+	/// contactsには衝突ペア(EntityIdの組、小さい方が先)が、
+	/// hitsには衝突した物体の(生成順の番号の位置の)ビットが毎フレーム書き込まれる。
+	/// すべてnullptrならば衝突数を数えるだけの経路で更新される。
+	///
+	/// WARN: hitsには物体群の数だけHitBitsetを並べた配列を渡し、それぞれ物体群の物体数以上の大きさにしておくこと。
+	inline void setContactOutput(ContactBuffer *contacts, HitBitset *hits) {
+		_contacts = contacts;
+		_hits = hits;
+	}
+
+	/// 衝突判定の形のアトラスを設定する関数
+	///
+	/// 設定すると、ビットマップでの判定で物体の形(EntityGroup::shape)が用いられる。
+	/// nullptrならばすべての物体を円として扱う。
+	///
+	/// WARN: アトラスはシーンより長く生存させ、物体の形の番号はアトラスの形の数より小さくすること。
+	inline void setMaskAtlas(const MaskAtlas *atlas) {
+		_atlas = atlas;
+	}
+
+	/// 円の描画と照合とに用いる足跡の表を設定する関数
+	///
+	/// 設定すると、ビットマップでの判定で表の範囲の半径の円を表引きで描画・照合する。
+	/// 中心と半径とが1/4pxに丸められるため、解析的に求める場合と衝突数がわずかに変わる。
+	///
+	/// WARN: 表はシーンより長く生存させること。
+	inline void setFootprints(const DiskFootprints *footprints) {
+		_footprints = footprints;
+	}
+
+	/// 衝突判定ビットマップで画素を覆っているとみなす規則を設定する関数
+	///
+	/// 描画と照合とに同じ規則が用いられる。既定は画素の中心で判定する規則。
+	inline void setCoverage(const Coverage &coverage) {
+		_coverage = coverage;
+	}
+
+	/// 物体idの衝突判定の形を設定する関数
+	inline void setShape(EntityId id, uint32_t shape) {
+		_groups[getGroupOf(id)].shape[getSlotOf(id)] = shape;
+	}
+
+	/// 物体idの衝突判定の形の回転角を設定する関数
+	inline void setAngle(EntityId id, float angle) {
+		_groups[getGroupOf(id)].angle[getSlotOf(id)] = angle;
+	}
+
+	/// かすり判定を設定する関数
+	///
+	/// std::nulloptを渡すとかすり判定を行わない。
+	inline void setGraze(std::optional<GrazeDesc> graze) {
+		_graze = graze;
+	}
 };
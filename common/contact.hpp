@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+/// 衝突した物体の組
+///
+/// a, bは物体の識別子(EntityId)。
+struct ContactPair {
+	uint32_t a;
+	uint32_t b;
+};
+
+/// 衝突ペアの書き込み先となるバッファ
+///
+/// 領域は呼び出し側が確保する。容量を超えたペアは書き込まれず、その数だけが数えられる。
+class ContactBuffer final {
+private:
+	ContactPair *const _pairs;
+	const size_t _capacity;
+	size_t _count;
+	size_t _overflowCount;
+
+public:
+	explicit ContactBuffer(ContactPair *pairs, size_t capacity):
+		_pairs(pairs),
+		_capacity(capacity),
+		_count(0),
+		_overflowCount(0)
+	{}
+	ContactBuffer() = delete;
+	ContactBuffer(const ContactBuffer &) = delete;
+	ContactBuffer(const ContactBuffer &&) = delete;
+	ContactBuffer &operator=(const ContactBuffer &) = delete;
+	ContactBuffer &&operator=(const ContactBuffer &&) = delete;
+	~ContactBuffer() = default;
+
+	inline void clear() {
+		_count = 0;
+		_overflowCount = 0;
+	}
+	inline void push(uint32_t a, uint32_t b) {
+		if (_count < _capacity) {
+			_pairs[_count] = {a, b};
+			_count += 1;
+		} else {
+			_overflowCount += 1;
+		}
+	}
+	inline const ContactPair *data() const {
+		return _pairs;
+	}
+	inline size_t size() const {
+		return _count;
+	}
+	inline size_t getOverflowCount() const {
+		return _overflowCount;
+	}
+	inline bool isOverflowed() const {
+		return _overflowCount > 0;
+	}
+};
+
+/// 物体ごとに「衝突したか」を保持するビット集合
+class HitBitset final {
+private:
+	std::vector<uint64_t> _words;
+
+public:
+	explicit HitBitset(size_t count = 0): _words((count + 63) / 64, 0) {}
+
+	inline void resize(size_t count) {
+		_words.assign((count + 63) / 64, 0);
+	}
+	inline void clear() {
+		std::fill(_words.begin(), _words.end(), 0);
+	}
+	inline void set(size_t index) {
+		_words[index / 64] |= 1ull << (index % 64);
+	}
+	/// set()と同じだが、複数のスレッドから同時に呼べる関数
+	inline void setConcurrent(size_t index) {
+		std::atomic_ref<uint64_t>(_words[index / 64]).fetch_or(1ull << (index % 64), std::memory_order_relaxed);
+	}
+	inline bool test(size_t index) const {
+		return (_words[index / 64] >> (index % 64)) & 1;
+	}
+	inline size_t count() const {
+		size_t n = 0;
+		for (const auto w: _words) {
+			n += std::popcount(w);
+		}
+		return n;
+	}
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+/// 画素を図形が覆っているとみなす規則の種類
+enum class CoverageMode {
+	/// 画素の中心が図形の内側にあれば覆う (既定)
+	Center,
+	/// 画素の面積のうち図形が覆う割合の見積もりがしきい値以上ならば覆う
+	///
+	/// 円では縁を1px幅でぼかした値、形ではテクセルを双線形補間した値を割合とみなす(GPU版の線形サンプラーと同じ)。
+	Threshold,
+	/// 画素と図形とが少しでも重なれば覆う
+	///
+	/// 取りこぼしはないが、図形が大きく見積もられる。
+	Conservative,
+};
+
+/// 衝突判定ビットマップの描画と照合とに共通する、画素の覆い方の規則
+///
+/// 描画と照合とに同じ規則を用いるため、照合で見つかる重なりの多寡はこの規則で決まる。
+struct Coverage {
+	CoverageMode mode;
+	/// CoverageMode::Thresholdでのしきい値 (0, 1]
+	float threshold;
+
+	static constexpr Coverage center() {
+		return Coverage{CoverageMode::Center, 0.5f};
+	}
+	static constexpr Coverage hard(float threshold) {
+		return Coverage{CoverageMode::Threshold, threshold};
+	}
+	static constexpr Coverage conservative() {
+		return Coverage{CoverageMode::Conservative, 0.0f};
+	}
+};
+
+/// 中心の規則で円を扱うときの半径を求める関数
+///
+/// しきい値の規則は、縁を1px幅でぼかした円の値が中心でしきい値以上となる範囲なので、半径をr + 0.5 - thresholdとした円と同じ。
+/// 保守的な規則では、画素の中心から角までの距離だけ太らせた円の範囲を返す(それ以外の図形のための近似)。
+inline float getCoveredRadius(float r, const Coverage &coverage) {
+	switch (coverage.mode) {
+		case CoverageMode::Threshold:
+			return r + 0.5f - coverage.threshold;
+		case CoverageMode::Conservative:
+			return r + 0.70710678f;
+		default:
+			return r;
+	}
+}
+
+/// 中心が円(cx, cy, r)の内側にある画素の行の範囲[y0, y1)を求める関数
+inline void getCenterDiskRows(float cy, float r, int &y0, int &y1) {
+	y0 = static_cast<int>(std::ceil(cy - r - 0.5f));
+	y1 = static_cast<int>(std::floor(cy + r - 0.5f)) + 1;
+}
+
+/// 中心が円(cx, cy, r)の内側にある、行yの画素の範囲[x0, x1)を求める関数
+///
+/// 範囲が空ならばfalseを返す。
+inline bool getCenterDiskSpan(float cx, float cy, float r, int y, int &x0, int &x1) {
+	const auto dy = static_cast<float>(y) + 0.5f - cy;
+	const auto hh = r * r - dy * dy;
+	if (hh < 0.0f) {
+		return false;
+	}
+	const auto half = std::sqrt(hh);
+	x0 = static_cast<int>(std::ceil(cx - half - 0.5f));
+	x1 = static_cast<int>(std::floor(cx + half - 0.5f)) + 1;
+	return x0 < x1;
+}
+
+/// 円(cx, cy, r)と少しでも重なる画素の行の範囲[y0, y1)を求める関数
+inline void getConservativeDiskRows(float cy, float r, int &y0, int &y1) {
+	y0 = static_cast<int>(std::floor(cy - r));
+	y1 = static_cast<int>(std::ceil(cy + r));
+}
+
+/// 円(cx, cy, r)と少しでも重なる、行yの画素の範囲[x0, x1)を求める関数
+///
+/// 行の帯[y, y + 1]のうち中心に最も近い高さで、円の幅が最大となる。範囲が空ならばfalseを返す。
+inline bool getConservativeDiskSpan(float cx, float cy, float r, int y, int &x0, int &x1) {
+	const auto top = static_cast<float>(y);
+	const auto dy = std::max({top - cy, cy - (top + 1.0f), 0.0f});
+	const auto hh = r * r - dy * dy;
+	if (hh < 0.0f) {
+		return false;
+	}
+	const auto half = std::sqrt(hh);
+	x0 = static_cast<int>(std::floor(cx - half));
+	x1 = static_cast<int>(std::ceil(cx + half));
+	return x0 < x1;
+}
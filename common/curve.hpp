@@ -0,0 +1,75 @@
+#pragma once
+
+#include "world.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+/// 空間充填曲線の各軸の量子化に用いるbit数
+constexpr unsigned int CURVE_AXIS_BITS = 15;
+
+/// ワールドworld上の点(x, y)を各軸CURVE_AXIS_BITS bitの格子に量子化する関数
+///
+/// ワールドの外の点は端に寄せる。
+inline std::pair<uint32_t, uint32_t> quantizeToCurveGrid(float x, float y, const WorldBounds &world) {
+	constexpr auto SCALE = static_cast<float>((1u << CURVE_AXIS_BITS) - 1);
+	return {
+		static_cast<uint32_t>(std::clamp(x / world.width, 0.0f, 1.0f) * SCALE),
+		static_cast<uint32_t>(std::clamp(y / world.height, 0.0f, 1.0f) * SCALE),
+	};
+}
+
+/// 値の下位16bitを1bitおきに広げる関数
+inline uint32_t spreadBits(uint32_t v) {
+	v &= 0x0000ffff;
+	v = (v | (v << 8)) & 0x00ff00ff;
+	v = (v | (v << 4)) & 0x0f0f0f0f;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
+
+/// ワールドworld上の点(x, y)の30bitのMortonコード
+///
+/// 各軸15bitに量子化し、xを偶数bit、yを奇数bitに交互に並べる。
+inline uint32_t getMortonCode(float x, float y, const WorldBounds &world) {
+	const auto [qx, qy] = quantizeToCurveGrid(x, y, world);
+	return spreadBits(qx) | (spreadBits(qy) << 1);
+}
+
+/// ワールドworld上の点(x, y)の30bitのHilbertコード
+///
+/// 各軸15bitに量子化し、上位bitから象限を選ぶたびに座標を回転・反転させる。
+/// Mortonコードと異なり曲線上で隣り合う点は必ず空間でも隣り合う。
+inline uint32_t getHilbertCode(float x, float y, const WorldBounds &world) {
+	constexpr uint32_t N = 1u << CURVE_AXIS_BITS;
+	auto [qx, qy] = quantizeToCurveGrid(x, y, world);
+	uint32_t code = 0;
+	for (auto s = N / 2; s > 0; s /= 2) {
+		const uint32_t rx = (qx & s) != 0 ? 1 : 0;
+		const uint32_t ry = (qy & s) != 0 ? 1 : 0;
+		code += s * s * ((3 * rx) ^ ry);
+		if (ry == 0) {
+			if (rx == 1) {
+				qx = N - 1 - qx;
+				qy = N - 1 - qy;
+			}
+			std::swap(qx, qy);
+		}
+	}
+	return code;
+}
+
+/// 物体の並べ替えに用いる空間充填曲線
+enum class SpatialOrder {
+	/// 並べ替えない
+	None,
+	Morton,
+	Hilbert,
+};
+
+/// ワールドworld上の点(x, y)の、orderの曲線上での位置
+inline uint32_t getCurveCode(SpatialOrder order, float x, float y, const WorldBounds &world) {
+	return order == SpatialOrder::Hilbert ? getHilbertCode(x, y, world) : getMortonCode(x, y, world);
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "bitmap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/// 円と物体群との近さ
+enum class Proximity {
+	/// 離れている
+	Clear,
+	/// 重なってはいないが、余白の内側にある (かすり)
+	Graze,
+	/// 重なっている
+	Hit,
+};
+
+/// 衝突判定ビットマップの面から求めた距離場
+///
+/// 各画素に、最も近い塗られた画素までの距離を3-4チャンファー距離(縦横3、斜め4)で持つ。
+/// 真のユークリッド距離との誤差は高々8%程度。
+class DistanceField final {
+private:
+	static constexpr uint32_t ORTHO = 3;
+	static constexpr uint32_t DIAG = 4;
+	static constexpr uint16_t INF = 0xffff;
+
+	const int _width;
+	const int _height;
+	std::vector<uint16_t> _dist;
+
+	inline uint16_t *row(int y) {
+		return &_dist[static_cast<size_t>(y) * _width];
+	}
+
+	/// 隣の行から縦と斜めとの距離を伝播させる関数
+	///
+	/// 行内の依存がないため自動ベクトル化される。
+	inline void relaxFromRow(uint16_t *cur, const uint16_t *adj) const {
+		const auto relax = [](uint16_t d, uint16_t v, uint32_t w) {
+			const auto n = static_cast<uint32_t>(v) + w;
+			return n < d ? static_cast<uint16_t>(n) : d;
+		};
+		cur[0] = relax(relax(cur[0], adj[0], ORTHO), adj[1], DIAG);
+		for (int x = 1; x + 1 < _width; ++x) {
+			cur[x] = relax(relax(relax(cur[x], adj[x], ORTHO), adj[x - 1], DIAG), adj[x + 1], DIAG);
+		}
+		const auto last = _width - 1;
+		cur[last] = relax(relax(cur[last], adj[last], ORTHO), adj[last - 1], DIAG);
+	}
+
+	/// 前向きと後ろ向きとの二回の走査で距離を伝播させる関数
+	///
+	/// 各行で隣の行からの伝播を済ませてから、行内の横方向の伝播を行う。
+	void propagate() {
+		for (int y = 0; y < _height; ++y) {
+			auto *cur = row(y);
+			if (y > 0) {
+				relaxFromRow(cur, row(y - 1));
+			}
+			for (int x = 1; x < _width; ++x) {
+				cur[x] = static_cast<uint16_t>(std::min<uint32_t>(cur[x], cur[x - 1] + ORTHO));
+			}
+		}
+		for (int y = _height - 1; y >= 0; --y) {
+			auto *cur = row(y);
+			if (y + 1 < _height) {
+				relaxFromRow(cur, row(y + 1));
+			}
+			for (int x = _width - 2; x >= 0; --x) {
+				cur[x] = static_cast<uint16_t>(std::min<uint32_t>(cur[x], cur[x + 1] + ORTHO));
+			}
+		}
+	}
+
+public:
+	explicit DistanceField(int width, int height):
+		_width(width),
+		_height(height),
+		_dist(static_cast<size_t>(width) * height, INF)
+	{}
+	DistanceField() = delete;
+	DistanceField(const DistanceField &) = delete;
+	DistanceField(const DistanceField &&) = delete;
+	DistanceField &operator=(const DistanceField &) = delete;
+	DistanceField &&operator=(const DistanceField &&) = delete;
+	~DistanceField() = default;
+
+	/// 衝突判定ビットマップの物体群groupの面から距離場を求める関数
+	void build(const SoftwareBitmap &bitmap, unsigned int group) {
+		for (int y = 0; y < _height; ++y) {
+			const auto *src = bitmap.getRow(group, y);
+			auto *dst = row(y);
+			for (int x = 0; x < _width; ++x) {
+				dst[x] = (src[x / 64] >> (x % 64)) & 1 ? 0 : INF;
+			}
+		}
+		propagate();
+	}
+
+	/// 画素(x, y)が塗られているかを返す関数occupiedから距離場を求める関数
+	template<typename F>
+	void build(F occupied) {
+		for (int y = 0; y < _height; ++y) {
+			auto *dst = row(y);
+			for (int x = 0; x < _width; ++x) {
+				dst[x] = occupied(x, y) ? 0 : INF;
+			}
+		}
+		propagate();
+	}
+
+	/// 画素(x, y)から最も近い塗られた画素までの距離を返す関数
+	///
+	/// 塗られた画素が一つもなければ非常に大きな値を返す。
+	inline float getDistance(int x, int y) const {
+		x = std::clamp(x, 0, _width - 1);
+		y = std::clamp(y, 0, _height - 1);
+		const auto d = _dist[static_cast<size_t>(y) * _width + x];
+		return d == INF ? HUGE_VALF : static_cast<float>(d) / static_cast<float>(ORTHO);
+	}
+
+	/// 円(x, y, r)が塗られた画素とどれだけ近いかを判定する関数
+	///
+	/// 円の中心の画素の距離だけを参照する。margin以内に近づいていればかすりとする。
+	inline Proximity classify(float x, float y, float r, float margin) const {
+		const auto d = getDistance(static_cast<int>(std::floor(x)), static_cast<int>(std::floor(y)));
+		if (d <= r) {
+			return Proximity::Hit;
+		} else if (d <= r + margin) {
+			return Proximity::Graze;
+		} else {
+			return Proximity::Clear;
+		}
+	}
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/// Q16.16の固定小数点数
+using Fixed = int32_t;
+
+constexpr int FIXED_SHIFT = 16;
+constexpr Fixed FIXED_ONE = Fixed{1} << FIXED_SHIFT;
+
+/// 衝突判定で座標から落とす下位bit数
+///
+/// 判定は1/16px単位の32bit整数で行い、ワールドの対角線の長さの二乗も32bitに収める(FIXED_MAX_DIAGONALを参照)。
+constexpr int FIXED_COLLISION_SHIFT = 12;
+
+/// 固定小数点数で扱えるワールドの対角線の長さの上限(px)
+///
+/// 1/16px単位の対角線の長さの二乗が32bitの符号付き整数に収まる長さ(画面の対角線は1600px)。
+constexpr float FIXED_MAX_DIAGONAL = 2896.0f;
+
+/// 一周を表す角度の単位数
+constexpr uint32_t ANGLE_TURN = 4096;
+constexpr uint32_t ANGLE_MASK = ANGLE_TURN - 1;
+constexpr uint32_t ANGLE_HALF_TURN = ANGLE_TURN / 2;
+constexpr uint32_t ANGLE_QUARTER_TURN = ANGLE_TURN / 4;
+
+/// 浮動小数点数を最も近い固定小数点数に変換する関数
+///
+/// 2のべき乗倍と丸めとはどの環境でも同じ結果になるため、設定値の変換にだけ用いる。
+inline Fixed toFixed(float value) {
+	return static_cast<Fixed>(std::lround(value * static_cast<float>(FIXED_ONE)));
+}
+inline float fromFixed(Fixed value) {
+	return static_cast<float>(value) / static_cast<float>(FIXED_ONE);
+}
+
+/// 固定小数点数で表したワールドの大きさ
+struct FixedBounds {
+	Fixed width;
+	Fixed height;
+};
+
+/// ワールドの大きさを固定小数点数に変換する関数
+///
+/// 対角線の長さがFIXED_MAX_DIAGONALを超えるワールドは、衝突判定の距離の二乗が32bitに収まらないため例外を投げる。
+inline FixedBounds toFixedBounds(const WorldBounds &world) {
+	if (std::hypot(world.width, world.height) > FIXED_MAX_DIAGONAL) {
+		throw "the world is too large for fixed-point collision.";
+	}
+	return FixedBounds{toFixed(world.width), toFixed(world.height)};
+}
+
+/// 0から1/4周までのsinの表(Q16.16)
+///
+/// 整数演算だけのTaylor展開(Q30)で求めるため、コンパイラやISAによらず同じ表になる。
+constexpr std::array<Fixed, ANGLE_QUARTER_TURN + 1> SINE_TABLE = []() {
+	// πのQ30表現
+	constexpr int64_t PI_Q30 = 3373259426;
+	std::array<Fixed, ANGLE_QUARTER_TURN + 1> table{};
+	for (uint32_t k = 0; k <= ANGLE_QUARTER_TURN; ++k) {
+		const auto x = static_cast<int64_t>(k) * 2 * PI_Q30 / ANGLE_TURN;
+		const auto x2 = (x * x) >> 30;
+		auto term = x;
+		auto sum = x;
+		for (int64_t n = 1; n <= 7; ++n) {
+			term = -((term * x2) >> 30) / ((2 * n) * (2 * n + 1));
+			sum += term;
+		}
+		table[k] = static_cast<Fixed>((sum + (int64_t{1} << 13)) >> 14);
+	}
+	return table;
+}();
+
+/// 角度angle(一周がANGLE_TURN)のsinを返す関数
+inline Fixed fixedSin(uint32_t angle) {
+	angle &= ANGLE_MASK;
+	const auto quadrant = angle / ANGLE_QUARTER_TURN;
+	const auto offset = angle % ANGLE_QUARTER_TURN;
+	const auto value = SINE_TABLE[quadrant % 2 == 0 ? offset : ANGLE_QUARTER_TURN - offset];
+	return quadrant < 2 ? value : -value;
+}
+inline Fixed fixedCos(uint32_t angle) {
+	return fixedSin(angle + ANGLE_QUARTER_TURN);
+}
+
+/// 固定小数点数どうしの積
+inline Fixed fixedMul(Fixed a, Fixed b) {
+	return static_cast<Fixed>((static_cast<int64_t>(a) * b) >> FIXED_SHIFT);
+}
+
+/// 固定小数点数の位置と速さとを持つ物体群
+///
+/// EntityGroupと同じく要素ごとの配列(SoA)で持ち、向きは角度の単位数で持つ。
+/// 移動は整数演算と表引きとだけで行うため、どの環境でも同じ位置になる。
+/// cx, cy, crは衝突判定に用いる1/16px単位の位置と半径で、update()で求め直す。
+struct FixedGroup {
+	std::vector<Fixed> x;
+	std::vector<Fixed> y;
+	std::vector<Fixed> r;
+	std::vector<Fixed> spd;
+	std::vector<uint32_t> angle;
+	std::vector<Fixed> px;
+	std::vector<Fixed> py;
+	std::vector<int32_t> cx;
+	std::vector<int32_t> cy;
+	std::vector<int32_t> cr;
+
+	inline size_t size() const {
+		return x.size();
+	}
+	inline void push(Fixed x_, Fixed y_, Fixed r_, Fixed spd_, uint32_t angle_) {
+		x.push_back(x_);
+		y.push_back(y_);
+		r.push_back(r_);
+		spd.push_back(spd_);
+		angle.push_back(angle_ & ANGLE_MASK);
+		px.push_back(x_);
+		py.push_back(y_);
+		cx.push_back(x_ >> FIXED_COLLISION_SHIFT);
+		cy.push_back(y_ >> FIXED_COLLISION_SHIFT);
+		cr.push_back(r_ >> FIXED_COLLISION_SHIFT);
+	}
+	/// 物体を移動させ、大きさboundsのワールドの端で跳ね返す関数
+	inline void update(const FixedBounds &bounds) {
+		for (size_t i = 0; i < size(); ++i) {
+			px[i] = x[i];
+			py[i] = y[i];
+			x[i] += fixedMul(spd[i], fixedCos(angle[i]));
+			y[i] += fixedMul(spd[i], fixedSin(angle[i]));
+			if (x[i] < 0 || x[i] > bounds.width) {
+				angle[i] = (ANGLE_HALF_TURN - angle[i]) & ANGLE_MASK;
+				x[i] = std::max(std::min(x[i], bounds.width), 0);
+			}
+			if (y[i] < 0 || y[i] > bounds.height) {
+				angle[i] = (angle[i] + ANGLE_HALF_TURN) & ANGLE_MASK;
+				y[i] = std::max(std::min(y[i], bounds.height), 0);
+			}
+			cx[i] = x[i] >> FIXED_COLLISION_SHIFT;
+			cy[i] = y[i] >> FIXED_COLLISION_SHIFT;
+		}
+	}
+};
+
+/// descの物体を、大きさboundsのワールドのg番目の物体群として固定小数点数でgroupの末尾に生成する関数
+///
+/// spawnGroup()と同じ配置を整数演算で求める。向きは10度ずつずれる。
+/// NOTE: rMaxによる半径の散らばりは、対数が一様になる分布の代わりに小さい半径に偏った二次の分布で近似する。
+inline void spawnFixedGroup(FixedGroup &group, const GroupDesc &desc, unsigned int g, const FixedBounds &bounds) {
+	const auto count = static_cast<int64_t>(std::max(desc.count, static_cast<size_t>(1)));
+	const auto dx = static_cast<int64_t>(bounds.width) / count;
+	const auto y0 = toFixed(desc.y);
+	const auto r0 = toFixed(desc.r);
+	const auto rMax = toFixed(desc.rMax);
+	const auto spread = toFixed(desc.spread);
+	const auto spd = toFixed(desc.spd);
+	for (size_t i = 0; i < desc.count; ++i) {
+		const auto n = static_cast<int64_t>(i);
+		auto r = r0;
+		if (rMax > r0) {
+			// 黄金比の小数部(Q16)による低食い違い列
+			const auto u = (n * 40503) & 0xffff;
+			r += static_cast<Fixed>((static_cast<int64_t>(rMax - r0) * ((u * u) >> 16)) >> 16);
+		}
+		auto y = y0;
+		if (spread > 0) {
+			// プラスチック数の逆数の小数部(Q16)による低食い違い列を物体群ごとに半周期ずらす
+			const auto u = (n * 49472 + static_cast<int64_t>(g) * 32768) & 0xffff;
+			y += static_cast<Fixed>((static_cast<int64_t>(spread) * u) >> 16);
+		}
+		const auto angle = static_cast<uint32_t>(n * 10 * ANGLE_TURN / 360);
+		group.push(static_cast<Fixed>(n * dx + dx / 2), y, r, spd, angle);
+	}
+}
+
+/// 1/16px単位の物体(x, y, r)と物体群groupの[begin, end)の物体との衝突数を整数演算で数える関数
+///
+/// 32bit整数の比較で判定する。分岐を含まないため、32bit幅で自動ベクトル化される。
+inline unsigned long long countFixedHits(const FixedGroup &group, size_t begin, size_t end, int32_t x, int32_t y, int32_t r) {
+	const auto *gx = group.cx.data();
+	const auto *gy = group.cy.data();
+	const auto *gr = group.cr.data();
+	uint32_t count = 0;
+	for (size_t i = begin; i < end; ++i) {
+		const auto dx = x - gx[i];
+		const auto dy = y - gy[i];
+		const auto rr = r + gr[i];
+		count += dx * dx + dy * dy < rr * rr ? 1 : 0;
+	}
+	return count;
+}
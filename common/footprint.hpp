@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// 円の足跡で、中心の端数と半径とを丸める単位の逆数のlog2
+///
+/// 1/4pxに丸めるため、足跡は解析的に求めた円と最大1/8pxずれる。
+constexpr int FOOTPRINT_SUBPIXEL_SHIFT = 2;
+constexpr int FOOTPRINT_SUBPIXEL = 1 << FOOTPRINT_SUBPIXEL_SHIFT;
+
+/// 足跡を持つ最大の半径
+///
+/// 足跡の1行は中心の画素の左右FOOTPRINT_MAX_RADIUS + 1画素ずつの範囲で、64bitの語一つに収まる。
+constexpr int FOOTPRINT_MAX_RADIUS = 30;
+
+/// 円の足跡
+///
+/// 中心を含む画素(x, y)を基準に、行y + top + kの画素x + left + bのビットを、行kの語のbビット目に持つ。
+/// 縁の画素はrimCount個の(x, y)からのずれとして持つ。
+struct DiskFootprint {
+	int left;
+	int top;
+	uint32_t rowCount;
+	uint32_t offset;
+	uint32_t rimOffset;
+	uint32_t rimCount;
+};
+
+/// 足跡の縁の画素の、基準の画素からのずれ
+struct FootprintPoint {
+	int8_t x;
+	int8_t y;
+};
+
+/// 半径と中心の端数とごとに、円が覆う画素のビットを行ごとに前もって求めた表
+///
+/// 同じ大きさの円を何度も描画・照合する場合に、画素の範囲の計算を表引きとシフトとで置き換えるために用いる。
+/// 画素は中心(x + 0.5, y + 0.5)が円の内側(円周を含む)にあるときに覆われる(SoftwareBitmapと同じ)。
+/// 行ごとの円の画素のビット(fill)と、円の画素のうち上下左右のいずれかが円の外側である縁の画素の並び(rim)とを持つ。
+/// 縁の画素は、円周を辿る中点円アルゴリズムと同じく円の8つの部分を交互に巡る順に並べる。
+/// 縁を調べて早く打ち切れるよう、重なりの見つかりやすい離れた画素から調べるためである。
+class DiskFootprints final {
+private:
+	int _maxSteps;
+	std::vector<DiskFootprint> _entries;
+	std::vector<uint64_t> _fill;
+	std::vector<FootprintPoint> _rim;
+
+	/// 半径step / FOOTPRINT_SUBPIXELの、中心の端数が(qx, qy) / FOOTPRINT_SUBPIXELの足跡を作る関数
+	void build(int step, int qx, int qy) {
+		const auto r = static_cast<float>(step) / FOOTPRINT_SUBPIXEL;
+		const auto fx = static_cast<float>(qx) / FOOTPRINT_SUBPIXEL;
+		const auto fy = static_cast<float>(qy) / FOOTPRINT_SUBPIXEL;
+		const auto extent = static_cast<int>(std::ceil(r + 0.5f));
+		const auto inside = [&](int x, int y) {
+			const auto dx = static_cast<float>(x) + 0.5f - fx;
+			const auto dy = static_cast<float>(y) + 0.5f - fy;
+			return dx * dx + dy * dy <= r * r;
+		};
+		// 上下に1行ずつ余分に作り、縁を求めてから空の行を落とす
+		std::vector<uint64_t> rows(static_cast<size_t>(2 * extent + 3), 0);
+		for (int y = -extent - 1; y <= extent + 1; ++y) {
+			for (int x = -extent; x <= extent; ++x) {
+				if (inside(x, y)) {
+					rows[static_cast<size_t>(y + extent + 1)] |= 1ull << (x + extent);
+				}
+			}
+		}
+		DiskFootprint footprint{-extent, 0, 0, static_cast<uint32_t>(_fill.size()), static_cast<uint32_t>(_rim.size()), 0};
+		// 縁の画素と、中心からの向きを8分の1の円に折り返した角度
+		std::vector<std::pair<float, FootprintPoint>> rim;
+		for (size_t k = 1; k + 1 < rows.size(); ++k) {
+			if (rows[k] == 0) {
+				continue;
+			}
+			if (footprint.rowCount == 0) {
+				footprint.top = static_cast<int>(k) - extent - 1;
+			}
+			const auto interior = rows[k] & rows[k - 1] & rows[k + 1] & (rows[k] << 1) & (rows[k] >> 1);
+			const auto y = static_cast<int>(k) - extent - 1;
+			for (auto bits = rows[k] & ~interior; bits != 0; bits &= bits - 1) {
+				const auto x = std::countr_zero(bits) - extent;
+				const auto ux = std::abs(static_cast<float>(x) + 0.5f - fx);
+				const auto uy = std::abs(static_cast<float>(y) + 0.5f - fy);
+				rim.emplace_back(std::atan2(std::min(ux, uy), std::max(ux, uy)), FootprintPoint{static_cast<int8_t>(x), static_cast<int8_t>(y)});
+			}
+			_fill.push_back(rows[k]);
+			footprint.rowCount += 1;
+		}
+		std::stable_sort(rim.begin(), rim.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+		for (const auto &[angle, point]: rim) {
+			_rim.push_back(point);
+		}
+		footprint.rimCount = static_cast<uint32_t>(rim.size());
+		_entries.push_back(footprint);
+	}
+
+public:
+	/// 半径maxRadiusまでの足跡を作る
+	explicit DiskFootprints(int maxRadius = FOOTPRINT_MAX_RADIUS):
+		_maxSteps(std::clamp(maxRadius, 0, FOOTPRINT_MAX_RADIUS) * FOOTPRINT_SUBPIXEL),
+		_entries(),
+		_fill(),
+		_rim()
+	{
+		_entries.reserve(static_cast<size_t>(_maxSteps) * FOOTPRINT_SUBPIXEL * FOOTPRINT_SUBPIXEL);
+		for (int step = 1; step <= _maxSteps; ++step) {
+			for (int qy = 0; qy < FOOTPRINT_SUBPIXEL; ++qy) {
+				for (int qx = 0; qx < FOOTPRINT_SUBPIXEL; ++qx) {
+					build(step, qx, qy);
+				}
+			}
+		}
+	}
+	DiskFootprints(const DiskFootprints &) = delete;
+	DiskFootprints(const DiskFootprints &&) = delete;
+	DiskFootprints &operator=(const DiskFootprints &) = delete;
+	DiskFootprints &&operator=(const DiskFootprints &&) = delete;
+	~DiskFootprints() = default;
+
+	/// 円(cx, cy, r)の足跡を探す関数
+	///
+	/// 足跡の基準の画素を(x, y)に書き込む。半径が表の範囲外ならばnullptrを返す。
+	inline const DiskFootprint *find(float cx, float cy, float r, int &x, int &y) const {
+		const auto step = static_cast<int>(std::lround(r * FOOTPRINT_SUBPIXEL));
+		if (step < 1 || step > _maxSteps) {
+			return nullptr;
+		}
+		const auto qx = static_cast<int>(std::lround(cx * FOOTPRINT_SUBPIXEL));
+		const auto qy = static_cast<int>(std::lround(cy * FOOTPRINT_SUBPIXEL));
+		// NOTE: 右シフトは負の数では切り下げになるため、画面の外側の中心でも基準の画素が求まる。
+		x = qx >> FOOTPRINT_SUBPIXEL_SHIFT;
+		y = qy >> FOOTPRINT_SUBPIXEL_SHIFT;
+		const auto fx = qx & (FOOTPRINT_SUBPIXEL - 1);
+		const auto fy = qy & (FOOTPRINT_SUBPIXEL - 1);
+		const auto index = (static_cast<size_t>(step - 1) * FOOTPRINT_SUBPIXEL + fy) * FOOTPRINT_SUBPIXEL + fx;
+		return &_entries[index];
+	}
+
+	inline const uint64_t *getFill(const DiskFootprint &footprint) const {
+		return &_fill[footprint.offset];
+	}
+	inline const FootprintPoint *getRim(const DiskFootprint &footprint) const {
+		return &_rim[footprint.rimOffset];
+	}
+
+	/// 表の大きさ(バイト数)
+	inline size_t getBytes() const {
+		return _entries.size() * sizeof(DiskFootprint) + _fill.size() * sizeof(uint64_t) + _rim.size() * sizeof(FootprintPoint);
+	}
+};
@@ -0,0 +1,486 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// ジョブに埋め込める関数オブジェクトの大きさ
+constexpr size_t JOB_PAYLOAD_SIZE = 64;
+
+/// ワーカーごとのジョブの両端キューの容量
+constexpr size_t JOB_QUEUE_CAPACITY = 4096;
+
+/// ワーカーごとに使い回すジョブの数
+///
+/// WARN: 一つのワーカーが作ったジョブのうち、同時に終わっていないものはこの数未満であること。
+constexpr size_t JOB_POOL_SIZE = 4096;
+
+/// ジョブ
+///
+/// unfinishedは自身と、終わっていない子の数。0になったときに親のunfinishedを減らす。
+struct Job {
+	void (*function)(Job &);
+	Job *parent;
+	std::atomic<int32_t> unfinished;
+	alignas(std::max_align_t) std::array<std::byte, JOB_PAYLOAD_SIZE> payload;
+};
+
+/// Chase-Levのワークスティーリング両端キュー
+///
+/// 持ち主のワーカーだけが末尾に積み(push)末尾から取り出し(pop)、他のワーカーは先頭から盗む(steal)。
+/// 容量は固定で、満杯ならばpush()はfalseを返す。
+class WorkStealingDeque final {
+private:
+	static constexpr size_t MASK = JOB_QUEUE_CAPACITY - 1;
+	static_assert((JOB_QUEUE_CAPACITY & MASK) == 0, "capacity must be a power of two.");
+
+	alignas(64) std::atomic<int64_t> _top;
+	alignas(64) std::atomic<int64_t> _bottom;
+	std::array<std::atomic<Job *>, JOB_QUEUE_CAPACITY> _buffer;
+
+public:
+	WorkStealingDeque(): _top(0), _bottom(0), _buffer{} {}
+	WorkStealingDeque(const WorkStealingDeque &) = delete;
+	WorkStealingDeque(const WorkStealingDeque &&) = delete;
+	WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+	WorkStealingDeque &&operator=(const WorkStealingDeque &&) = delete;
+	~WorkStealingDeque() = default;
+
+	bool push(Job *job) {
+		const auto b = _bottom.load(std::memory_order_relaxed);
+		const auto t = _top.load(std::memory_order_acquire);
+		if (b - t >= static_cast<int64_t>(JOB_QUEUE_CAPACITY)) {
+			return false;
+		}
+		_buffer[b & MASK].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		_bottom.store(b + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	Job *pop() {
+		const auto b = _bottom.load(std::memory_order_relaxed) - 1;
+		_bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto t = _top.load(std::memory_order_relaxed);
+		if (t > b) {
+			_bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		auto *job = _buffer[b & MASK].load(std::memory_order_relaxed);
+		if (t == b) {
+			// 最後の一つは盗みと競合するため、topを進められた方が取る
+			if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				job = nullptr;
+			}
+			_bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job *steal() {
+		auto t = _top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const auto b = _bottom.load(std::memory_order_acquire);
+		if (t >= b) {
+			return nullptr;
+		}
+		auto *job = _buffer[t & MASK].load(std::memory_order_relaxed);
+		if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+		return job;
+	}
+};
+
+/// ワークスティーリングによるジョブシステム
+///
+/// ワーカーごとにChase-Levの両端キューを持ち、自身のキューが空になると他のワーカーのキューから盗む。
+/// 作成したスレッドがワーカー0となり、wait()の間は自身もジョブを処理する。同じスレッドで入れ子に作れば、破棄したときに外側のものに戻る。
+/// 仕事がない間、ワーカーは少し回ってから眠り、ジョブが積まれると起こされる。
+///
+/// WARN: create()、run()、wait()は作成したスレッドか、ジョブの中から呼ぶこと。それ以外のスレッドから呼ぶと例外を投げる。
+class JobSystem final {
+public:
+	/// ワーカーごとの統計
+	struct WorkerStats {
+		/// ジョブを処理していた時間の割合
+		double utilization;
+		uint64_t jobCount;
+		uint64_t stealCount;
+	};
+
+private:
+	/// 眠る前に仕事を探す回数
+	static constexpr int SPIN_COUNT = 256;
+
+	struct alignas(64) Worker {
+		WorkStealingDeque queue;
+		std::unique_ptr<Job[]> pool;
+		size_t allocated;
+		uint32_t random;
+		std::atomic<uint64_t> busyNs;
+		std::atomic<uint64_t> jobCount;
+		std::atomic<uint64_t> stealCount;
+
+		explicit Worker(uint32_t seed):
+			queue(),
+			pool(std::make_unique<Job[]>(JOB_POOL_SIZE)),
+			allocated(0),
+			random(seed),
+			busyNs(0),
+			jobCount(0),
+			stealCount(0)
+		{}
+	};
+
+	/// parallelFor()の範囲を二分しながら処理するジョブの中身
+	template<typename F>
+	struct RangeTask {
+		JobSystem *system;
+		const F *f;
+		size_t begin;
+		size_t end;
+		size_t grain;
+
+		void operator()() const {
+			// 右半分をジョブとして積み、左半分を自身で続けて分ける。
+			// 盗まれるのは先に積んだ大きい範囲からになる。
+			auto e = end;
+			while (e - begin > grain) {
+				const auto mid = begin + (e - begin) / 2;
+				auto *job = system->create(RangeTask{system, f, mid, e, grain}, system->getCurrentJob());
+				system->run(job);
+				e = mid;
+			}
+			(*f)(begin, e);
+		}
+	};
+
+	static inline thread_local JobSystem *_currentSystem = nullptr;
+	static inline thread_local unsigned int _currentWorker = 0;
+	static inline thread_local Job *_currentJob = nullptr;
+	static inline thread_local unsigned int _depth = 0;
+
+	std::vector<std::unique_ptr<Worker>> _workers;
+	std::vector<std::thread> _threads;
+	std::atomic<bool> _running;
+	std::atomic<uint32_t> _signal;
+	std::atomic<uint32_t> _sleeping;
+	std::chrono::steady_clock::time_point _statsBegin;
+	/// 作成したスレッドで、作成する前に使われていたジョブシステムとワーカー (破棄するときに戻す)
+	JobSystem *const _previousSystem;
+	const unsigned int _previousWorker;
+
+	/// 呼び出したスレッドのワーカーを返す関数
+	///
+	/// ワーカーのキューとジョブの領域とは持ち主のスレッドしか触れないため、ワーカーでないスレッドからは例外を投げる。
+	inline Worker &getWorker() {
+		if (_currentSystem != this) {
+			throw "the job system must be used from its own thread or from within a job.";
+		}
+		return *_workers[_currentWorker];
+	}
+
+	Job *findJob() {
+		auto &self = getWorker();
+		if (auto *job = self.queue.pop()) {
+			return job;
+		}
+		const auto count = static_cast<uint32_t>(_workers.size());
+		if (count <= 1) {
+			return nullptr;
+		}
+		// xorshiftで選んだワーカーから順に盗む
+		self.random ^= self.random << 13;
+		self.random ^= self.random >> 17;
+		self.random ^= self.random << 5;
+		const auto first = self.random % count;
+		for (uint32_t i = 0; i < count; ++i) {
+			auto &victim = *_workers[(first + i) % count];
+			if (&victim == &self) {
+				continue;
+			}
+			if (auto *job = victim.queue.steal()) {
+				self.stealCount.fetch_add(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	void finish(Job *job) {
+		while (job && job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			job = job->parent;
+		}
+	}
+
+	/// ジョブを実行する関数
+	///
+	/// ジョブの中でwait()して他のジョブを実行した時間は、外側のジョブの時間として一度だけ数える。
+	void execute(Job *job) {
+		auto &self = getWorker();
+		const auto begin = _depth == 0 ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+		auto *previous = _currentJob;
+		_currentJob = job;
+		_depth += 1;
+		job->function(*job);
+		_depth -= 1;
+		_currentJob = previous;
+		finish(job);
+		if (_depth == 0) {
+			const auto elapsed = std::chrono::steady_clock::now() - begin;
+			self.busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+		}
+		self.jobCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void workerMain(unsigned int index) {
+		_currentSystem = this;
+		_currentWorker = index;
+		int idle = 0;
+		while (_running.load(std::memory_order_acquire)) {
+			const auto signal = _signal.load(std::memory_order_seq_cst);
+			if (auto *job = findJob()) {
+				execute(job);
+				idle = 0;
+				continue;
+			}
+			if (++idle < SPIN_COUNT) {
+				std::this_thread::yield();
+				continue;
+			}
+			// 見つからなかった後にsignalが変わっていれば、wait()はすぐに戻る
+			_sleeping.fetch_add(1, std::memory_order_seq_cst);
+			_signal.wait(signal, std::memory_order_seq_cst);
+			_sleeping.fetch_sub(1, std::memory_order_seq_cst);
+			idle = 0;
+		}
+	}
+
+	inline void wake() {
+		_signal.fetch_add(1, std::memory_order_seq_cst);
+		if (_sleeping.load(std::memory_order_seq_cst) > 0) {
+			_signal.notify_all();
+		}
+	}
+
+public:
+	explicit JobSystem(unsigned int workerCount):
+		_workers(),
+		_threads(),
+		_running(true),
+		_signal(0),
+		_sleeping(0),
+		_statsBegin(std::chrono::steady_clock::now()),
+		_previousSystem(_currentSystem),
+		_previousWorker(_currentWorker)
+	{
+		workerCount = std::max(workerCount, 1u);
+		for (unsigned int i = 0; i < workerCount; ++i) {
+			_workers.push_back(std::make_unique<Worker>(0x9e3779b9u * (i + 1)));
+		}
+		_currentSystem = this;
+		_currentWorker = 0;
+		for (unsigned int i = 1; i < workerCount; ++i) {
+			_threads.emplace_back([this, i]() { workerMain(i); });
+		}
+	}
+	JobSystem() = delete;
+	JobSystem(const JobSystem &) = delete;
+	JobSystem(const JobSystem &&) = delete;
+	JobSystem &operator=(const JobSystem &) = delete;
+	JobSystem &&operator=(const JobSystem &&) = delete;
+	~JobSystem() {
+		_running.store(false, std::memory_order_release);
+		_signal.fetch_add(1, std::memory_order_seq_cst);
+		_signal.notify_all();
+		for (auto &n: _threads) {
+			n.join();
+		}
+		if (_currentSystem == this) {
+			_currentSystem = _previousSystem;
+			_currentWorker = _previousWorker;
+		}
+	}
+
+	inline unsigned int getWorkerCount() const {
+		return static_cast<unsigned int>(_workers.size());
+	}
+
+	/// 処理中のジョブ(ジョブの外ではnullptr)
+	inline Job *getCurrentJob() const {
+		return _currentJob;
+	}
+
+	/// 関数オブジェクトfを実行するジョブを作る関数
+	///
+	/// parentを渡すと、このジョブが終わるまでparentも終わらない。
+	///
+	/// WARN: fはJOB_PAYLOAD_SIZE以下で、自明に破棄できること(参照を捕捉するラムダなど)。
+	template<typename F>
+	Job *create(F f, Job *parent = nullptr) {
+		static_assert(sizeof(F) <= JOB_PAYLOAD_SIZE, "job payload is too large.");
+		static_assert(std::is_trivially_destructible_v<F>, "job payload must be trivially destructible.");
+		auto &self = getWorker();
+		auto *job = &self.pool[self.allocated % JOB_POOL_SIZE];
+		self.allocated += 1;
+		job->function = [](Job &n) {
+			(*std::launder(reinterpret_cast<F *>(n.payload.data())))();
+		};
+		job->parent = parent;
+		job->unfinished.store(1, std::memory_order_relaxed);
+		new (job->payload.data()) F(f);
+		if (parent) {
+			parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	/// ジョブを自身のキューに積む関数
+	///
+	/// キューが満杯ならばその場で実行する。
+	void run(Job *job) {
+		if (!getWorker().queue.push(job)) {
+			execute(job);
+			return;
+		}
+		wake();
+	}
+
+	/// ジョブ(と子)が終わるまで、他のジョブを処理しながら待つ関数
+	void wait(const Job *job) {
+		while (job->unfinished.load(std::memory_order_acquire) > 0) {
+			if (auto *n = findJob()) {
+				execute(n);
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	/// [0, count)を区間に分けてf(begin, end)を並列に呼ぶ関数
+	///
+	/// 区間の大きさはワーカーあたり8区間程度になるよう要素数から決め、minGrain未満にはしない。
+	/// 範囲は二分しながらジョブとして積まれ、暇なワーカーが大きい範囲から盗む。すべての区間が終わるまで戻らない。
+	template<typename F>
+	void parallelFor(size_t count, const F &f, size_t minGrain = 1) {
+		if (count == 0) {
+			return;
+		}
+		const auto grain = std::max<size_t>(std::max<size_t>(minGrain, 1), count / (getWorkerCount() * 8));
+		if (count <= grain) {
+			f(size_t{0}, count);
+			return;
+		}
+		auto *root = create([]() {});
+		run(create(RangeTask<F>{this, &f, 0, count, grain}, root));
+		finish(root);
+		wait(root);
+	}
+
+	/// 統計を0に戻し、計測を始め直す関数
+	void resetStats() {
+		for (auto &n: _workers) {
+			n->busyNs.store(0, std::memory_order_relaxed);
+			n->jobCount.store(0, std::memory_order_relaxed);
+			n->stealCount.store(0, std::memory_order_relaxed);
+		}
+		_statsBegin = std::chrono::steady_clock::now();
+	}
+
+	/// resetStats()からのワーカーごとの統計を返す関数
+	std::vector<WorkerStats> getStats() const {
+		const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - _statsBegin).count();
+		std::vector<WorkerStats> stats;
+		for (const auto &n: _workers) {
+			stats.push_back({
+				elapsed > 0.0 ? static_cast<double>(n->busyNs.load(std::memory_order_relaxed)) / elapsed : 0.0,
+				n->jobCount.load(std::memory_order_relaxed),
+				n->stealCount.load(std::memory_order_relaxed),
+			});
+		}
+		return stats;
+	}
+};
+
+/// 依存関係つきのタスクの集まり
+///
+/// 一度組み立てれば、毎フレームrun()で繰り返し実行できる。
+/// 先行するタスクがすべて終わったタスクから順にジョブとして積まれる。
+class TaskGraph final {
+private:
+	struct Node {
+		std::function<void()> work;
+		std::vector<size_t> successors;
+		size_t predecessorCount;
+	};
+
+	std::vector<Node> _nodes;
+	std::unique_ptr<std::atomic<size_t>[]> _remaining;
+	size_t _remainingSize;
+
+	/// ノードindexを実行するジョブを積む関数
+	void spawn(JobSystem &system, Job *root, size_t index) {
+		system.run(system.create([this, &system, root, index]() {
+			_nodes[index].work();
+			for (const auto n: _nodes[index].successors) {
+				if (_remaining[n].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					spawn(system, root, n);
+				}
+			}
+		}, root));
+	}
+
+public:
+	TaskGraph(): _nodes(), _remaining(), _remainingSize(0) {}
+	TaskGraph(const TaskGraph &) = delete;
+	TaskGraph(const TaskGraph &&) = delete;
+	TaskGraph &operator=(const TaskGraph &) = delete;
+	TaskGraph &&operator=(const TaskGraph &&) = delete;
+	~TaskGraph() = default;
+
+	/// タスクを加え、その番号を返す関数
+	size_t add(std::function<void()> work) {
+		_nodes.push_back({std::move(work), {}, 0});
+		return _nodes.size() - 1;
+	}
+
+	/// タスクbeforeが終わってからタスクafterを始めるよう設定する関数
+	void precede(size_t before, size_t after) {
+		_nodes[before].successors.push_back(after);
+		_nodes[after].predecessorCount += 1;
+	}
+
+	inline size_t size() const {
+		return _nodes.size();
+	}
+
+	/// すべてのタスクを依存関係に従って実行し、終わるまで待つ関数
+	void run(JobSystem &system) {
+		if (_remainingSize < _nodes.size()) {
+			_remaining = std::make_unique<std::atomic<size_t>[]>(_nodes.size());
+			_remainingSize = _nodes.size();
+		}
+		for (size_t i = 0; i < _nodes.size(); ++i) {
+			_remaining[i].store(_nodes[i].predecessorCount, std::memory_order_relaxed);
+		}
+		auto *root = system.create([]() {});
+		for (size_t i = 0; i < _nodes.size(); ++i) {
+			if (_nodes[i].predecessorCount == 0) {
+				spawn(system, root, i);
+			}
+		}
+		system.run(root);
+		system.wait(root);
+	}
+};
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "aabbtree.hpp"
+#include "curve.hpp"
+#include "parallel.hpp"
+#include "radixsort.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+/// 毎フレーム作り直す線形BVH(LBVH)
+///
+/// 箱の中心のMortonコードを基数ソートし、Karrasの方法で内部節を互いに独立に求める。
+/// 箱は葉から根に向かって、二つの子が揃った節から順に求める。どの段も要素ごとに並列に行う。
+/// N個の葉に対して内部節はN - 1個で、0番目の内部節が根。
+class Lbvh final {
+private:
+	/// 子の番号
+	///
+	/// 0以上ならば内部節、負ならば~子の値が葉(並べ替え後の順序での番号)。
+	using Child = int32_t;
+
+	static constexpr size_t MIN_CHUNK = 8192;
+
+	/// 問い合わせで用いるスタックの深さ
+	///
+	/// NOTE: 木の深さは高々キーの64bit(Mortonコードと、同じコードを区別する葉の番号)で抑えられる。
+	static constexpr size_t STACK_SIZE = 128;
+
+	size_t _count;
+	RadixSorter<11> _sorter;
+	std::vector<uint32_t> _codes;
+	std::vector<uint32_t> _order;
+	std::vector<Aabb> _leafBoxes;
+	std::vector<Aabb> _boxes;
+	std::vector<Child> _left;
+	std::vector<Child> _right;
+	std::vector<int32_t> _parents;
+	std::vector<int32_t> _leafParents;
+	std::vector<uint32_t> _visits;
+
+	/// 並べ替え後のi番目とj番目との葉のキーの共通の上位bit数
+	///
+	/// 範囲外なら-1。コードが等しい葉は番号を続けて比べ、すべての葉のキーを異なるものとして扱う。
+	inline int delta(int64_t i, int64_t j) const {
+		if (j < 0 || j >= static_cast<int64_t>(_count)) {
+			return -1;
+		}
+		const auto a = _codes[i];
+		const auto b = _codes[j];
+		if (a == b) {
+			return 32 + std::countl_zero(static_cast<uint32_t>(i ^ j));
+		}
+		return std::countl_zero(a ^ b);
+	}
+
+	/// i番目の内部節が受け持つ葉の範囲と分割位置とを求め、子を決める関数
+	void buildNode(int64_t i) {
+		const auto d = delta(i, i + 1) - delta(i, i - 1) > 0 ? 1 : -1;
+		// 範囲の反対側の端を、倍々で上限を求めてから二分探索で求める
+		const auto deltaMin = delta(i, i - d);
+		int64_t lengthMax = 2;
+		while (delta(i, i + lengthMax * d) > deltaMin) {
+			lengthMax *= 2;
+		}
+		int64_t length = 0;
+		for (auto t = lengthMax / 2; t >= 1; t /= 2) {
+			if (delta(i, i + (length + t) * d) > deltaMin) {
+				length += t;
+			}
+		}
+		const auto j = i + length * d;
+		// 範囲の中で共通の上位bitが変わる位置を二分探索で求める
+		const auto deltaNode = delta(i, j);
+		int64_t split = 0;
+		auto t = length;
+		do {
+			t = (t + 1) / 2;
+			if (delta(i, i + (split + t) * d) > deltaNode) {
+				split += t;
+			}
+		} while (t > 1);
+		const auto gamma = i + split * d + std::min(d, 0);
+		const auto left = std::min(i, j) == gamma ? ~static_cast<Child>(gamma) : static_cast<Child>(gamma);
+		const auto right = std::max(i, j) == gamma + 1 ? ~static_cast<Child>(gamma + 1) : static_cast<Child>(gamma + 1);
+		_left[i] = left;
+		_right[i] = right;
+		(left < 0 ? _leafParents[~left] : _parents[left]) = static_cast<int32_t>(i);
+		(right < 0 ? _leafParents[~right] : _parents[right]) = static_cast<int32_t>(i);
+	}
+
+	inline const Aabb &getBox(Child child) const {
+		return child < 0 ? _leafBoxes[~child] : _boxes[child];
+	}
+
+public:
+	Lbvh(): _count(0) {}
+	Lbvh(const Lbvh &) = delete;
+	Lbvh(const Lbvh &&) = delete;
+	Lbvh &operator=(const Lbvh &) = delete;
+	Lbvh &&operator=(const Lbvh &&) = delete;
+	~Lbvh() = default;
+
+	/// ワールドworldのcount個の物体から木を作り直す関数
+	///
+	/// boxOf(i)はi番目の物体の箱を返す関数。並列に呼ばれる。
+	/// Mortonコードはワールド全体を量子化して求めるため、worldは物体の動く範囲に合わせること。
+	template<typename F>
+	void build(size_t count, F boxOf, const WorldBounds &world) {
+		_count = count;
+		if (_codes.size() < count) {
+			_codes.resize(count);
+			_order.resize(count);
+			_leafBoxes.resize(count);
+			_leafParents.resize(count);
+			_boxes.resize(count);
+			_left.resize(count);
+			_right.resize(count);
+			_parents.resize(count);
+			_visits.resize(count);
+		}
+		if (count == 0) {
+			return;
+		}
+
+		parallelFor(count, [&](size_t begin, size_t end, size_t) {
+			for (size_t i = begin; i < end; ++i) {
+				const auto box = boxOf(i);
+				_codes[i] = getMortonCode((box.x0 + box.x1) / 2.0f, (box.y0 + box.y1) / 2.0f, world);
+				_order[i] = static_cast<uint32_t>(i);
+			}
+		}, MIN_CHUNK);
+		_sorter.sort(_codes.data(), _order.data(), count);
+
+		const auto internalCount = count - 1;
+		parallelFor(count, [&](size_t begin, size_t end, size_t) {
+			for (size_t i = begin; i < end; ++i) {
+				_leafBoxes[i] = boxOf(_order[i]);
+				if (i < internalCount) {
+					_visits[i] = 0;
+				}
+			}
+		}, MIN_CHUNK);
+		_leafParents[0] = -1;
+		if (internalCount == 0) {
+			return;
+		}
+		_parents[0] = -1;
+		parallelFor(internalCount, [&](size_t begin, size_t end, size_t) {
+			for (size_t i = begin; i < end; ++i) {
+				buildNode(static_cast<int64_t>(i));
+			}
+		}, MIN_CHUNK);
+
+		// 各葉から根へ辿り、二番目に到着したスレッドだけが節の箱を求めて先に進む
+		parallelFor(count, [&](size_t begin, size_t end, size_t) {
+			for (size_t i = begin; i < end; ++i) {
+				auto node = _leafParents[i];
+				while (node >= 0) {
+					if (std::atomic_ref<uint32_t>(_visits[node]).fetch_add(1, std::memory_order_acq_rel) == 0) {
+						break;
+					}
+					_boxes[node] = Aabb::merge(getBox(_left[node]), getBox(_right[node]));
+					node = _parents[node];
+				}
+			}
+		}, MIN_CHUNK);
+	}
+
+	/// 箱boxと重なる箱を持つ物体の番号を順にfに渡す関数
+	///
+	/// WARN: 箱で判定するため、実際の形状との判定は呼び出し側で行うこと。
+	template<typename F>
+	void query(const Aabb &box, F f) const {
+		if (_count == 0) {
+			return;
+		}
+		if (_count == 1) {
+			if (_leafBoxes[0].overlaps(box)) {
+				f(_order[0]);
+			}
+			return;
+		}
+		std::array<Child, STACK_SIZE> stack;
+		size_t top = 0;
+		stack[top++] = 0;
+		while (top > 0) {
+			const auto node = stack[--top];
+			for (const auto child: {_left[node], _right[node]}) {
+				if (!getBox(child).overlaps(box)) {
+					continue;
+				}
+				if (child < 0) {
+					f(_order[~child]);
+				} else {
+					stack[top++] = child;
+				}
+			}
+		}
+	}
+
+	inline size_t size() const {
+		return _count;
+	}
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "aabbtree.hpp"
+#include "common.hpp"
+#include "world.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/// 関心点 (自機など、正確な衝突判定が要る場所)
+struct InterestPoint {
+	float x;
+	float y;
+};
+
+/// 詳細度(LOD)つきの衝突判定の設定
+///
+/// 関心点のどれかからradius以内に中心がある物体は方式どおりに詳細に判定し、
+/// それ以外の物体は一辺cellSizeの粗い格子で判定する。
+struct LodDesc {
+	float radius;
+	float cellSize;
+};
+
+/// 物体を囲む箱が覆う升目に物体群のビットを立てた、ワールド全体を覆う粗い格子
+///
+/// 升目ごとに、物体群の物体が一つ以上あるビットと、二つ以上あるビットとを持つ。
+/// 照合は、箱が覆う升目に相手の物体群のビット(自身の物体群ならば二つ以上あるビット)があれば重なっているとみなす。
+/// 重なる箱どうしは必ず同じ升目を覆うため、箱の重なりを取りこぼすことはないが、升目が粗いほど離れた物体どうしを重なっているとみなす。
+class CoarseGrid final {
+private:
+	const float _cellSize;
+	const int _cellsX;
+	const int _cellsY;
+	std::vector<uint32_t> _cells;
+	std::vector<uint32_t> _multiple;
+
+	/// 箱boxが覆う升目の範囲[cx0, cx1] x [cy0, cy1]を、格子の内側に切り詰めて求める関数
+	inline void getCellRange(const Aabb &box, int &cx0, int &cy0, int &cx1, int &cy1) const {
+		cx0 = std::max(static_cast<int>(std::floor(box.x0 / _cellSize)), 0);
+		cy0 = std::max(static_cast<int>(std::floor(box.y0 / _cellSize)), 0);
+		cx1 = std::min(static_cast<int>(std::floor(box.x1 / _cellSize)), _cellsX - 1);
+		cy1 = std::min(static_cast<int>(std::floor(box.y1 / _cellSize)), _cellsY - 1);
+	}
+
+public:
+	explicit CoarseGrid(const WorldBounds &world, float cellSize):
+		_cellSize(cellSize),
+		_cellsX(std::max(static_cast<int>(std::ceil(world.width / cellSize)), 1)),
+		_cellsY(std::max(static_cast<int>(std::ceil(world.height / cellSize)), 1)),
+		_cells(static_cast<size_t>(_cellsX) * _cellsY, 0),
+		_multiple(static_cast<size_t>(_cellsX) * _cellsY, 0)
+	{}
+	CoarseGrid() = delete;
+	CoarseGrid(const CoarseGrid &) = delete;
+	CoarseGrid(const CoarseGrid &&) = delete;
+	CoarseGrid &operator=(const CoarseGrid &) = delete;
+	CoarseGrid &&operator=(const CoarseGrid &&) = delete;
+	~CoarseGrid() = default;
+
+	inline float getCellSize() const {
+		return _cellSize;
+	}
+	inline int getCellsX() const {
+		return _cellsX;
+	}
+	inline int getCellsY() const {
+		return _cellsY;
+	}
+
+	inline void clear() {
+		std::fill(_cells.begin(), _cells.end(), 0);
+		std::fill(_multiple.begin(), _multiple.end(), 0);
+	}
+
+	/// 物体群groupの物体一つの箱boxが覆う升目に、groupのビットを立てる関数
+	///
+	/// 既にgroupのビットがある升目には、二つ以上あるビットも立てる。
+	inline void mark(unsigned int group, const Aabb &box) {
+		const auto bit = 1u << group;
+		int cx0, cy0, cx1, cy1;
+		getCellRange(box, cx0, cy0, cx1, cy1);
+		for (auto cy = cy0; cy <= cy1; ++cy) {
+			for (auto cx = cx0; cx <= cx1; ++cx) {
+				const auto n = static_cast<size_t>(cy) * _cellsX + cx;
+				_multiple[n] |= _cells[n] & bit;
+				_cells[n] |= bit;
+			}
+		}
+	}
+
+	/// 箱boxが覆う升目にある物体群のビットを返す関数
+	///
+	/// othersの物体群は一つ以上あれば、selfの物体群(照合する物体自身の物体群)は二つ以上あれば見つかったとする。
+	inline uint32_t overlap(const Aabb &box, uint32_t others, uint32_t self) const {
+		int cx0, cy0, cx1, cy1;
+		getCellRange(box, cx0, cy0, cx1, cy1);
+		uint32_t found = 0;
+		uint32_t multiple = 0;
+		for (auto cy = cy0; cy <= cy1; ++cy) {
+			for (auto cx = cx0; cx <= cx1; ++cx) {
+				const auto n = static_cast<size_t>(cy) * _cellsX + cx;
+				found |= _cells[n];
+				multiple |= _multiple[n];
+			}
+		}
+		return (found & others) | (multiple & self);
+	}
+};
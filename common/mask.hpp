@@ -0,0 +1,422 @@
+#pragma once
+
+#include "constant.hpp"
+#include "coverage.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// 衝突判定の形(マスク)の一辺の画素数
+///
+/// 1行を32bitの語一つで持つ。
+constexpr int MASK_SIZE = 32;
+
+/// 円を表す形の番号
+///
+/// どのアトラスでも0番は円で、ビットマップへは形を参照せずに解析的に描画する。
+constexpr uint32_t SHAPE_CIRCLE = 0;
+
+/// 形の行ごとのビット
+///
+/// 行は画面の下向き(yの増える向き)に並び、行のxビット目が列xの画素。
+using MaskRows = std::array<uint32_t, MASK_SIZE>;
+
+/// 列(行)の番号の画素の中心の、[-1, 1]での座標
+constexpr float toMaskUnit(int texel) {
+	return (static_cast<float>(texel) + 0.5f) / static_cast<float>(MASK_SIZE) * 2.0f - 1.0f;
+}
+
+/// 定数式で使えるsin
+///
+/// [-π, π]に折り返してからTaylor展開で求める。形の生成にだけ用いる。
+constexpr float maskSin(float x) {
+	const auto turns = x / (2.0f * PI);
+	x -= 2.0f * PI * static_cast<float>(static_cast<long long>(turns < 0.0f ? turns - 0.5f : turns + 0.5f));
+	const auto x2 = x * x;
+	auto term = x;
+	auto sum = x;
+	for (int n = 1; n <= 8; ++n) {
+		term *= -x2 / static_cast<float>((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+	return sum;
+}
+constexpr float maskCos(float x) {
+	return maskSin(x + PI / 2.0f);
+}
+
+/// 画素の中心(u, v) ∈ [-1, 1]^2が内側ならばtrueを返すinsideから形を作る関数
+///
+/// insideが定数式で呼べれば、形はコンパイル時に作られる。
+template<typename F>
+constexpr MaskRows makeMask(F inside) {
+	MaskRows rows{};
+	for (int y = 0; y < MASK_SIZE; ++y) {
+		for (int x = 0; x < MASK_SIZE; ++x) {
+			if (inside(toMaskUnit(x), toMaskUnit(y))) {
+				rows[y] |= 1u << x;
+			}
+		}
+	}
+	return rows;
+}
+
+/// 半径(rx, ry)の楕円(米粒弾など)の形を作る関数
+constexpr MaskRows makeEllipseMask(float rx, float ry) {
+	return makeMask([=](float u, float v) { return (u * u) / (rx * rx) + (v * v) / (ry * ry) < 1.0f; });
+}
+
+/// 半分の幅と高さとが(hx, hy)の長方形(レーザーなど)の形を作る関数
+///
+/// 角が円からはみ出さないよう、hx * hx + hy * hy <= 1にすること。
+constexpr MaskRows makeBoxMask(float hx, float hy) {
+	return makeMask([=](float u, float v) { return -hx < u && u < hx && -hy < v && v < hy; });
+}
+
+/// points個の頂点を持ち、へこみの半径がinnerの星形を作る関数
+///
+/// 頂点は上向きから始まる。外側と内側とに交互に並ぶ2 * points個の頂点の多角形の内外を、交差数で判定する。
+constexpr MaskRows makeStarMask(int points, float inner) {
+	const auto vertex = [=](int k, float &x, float &y) {
+		const auto angle = PI * static_cast<float>(k) / static_cast<float>(points);
+		const auto radius = k % 2 == 0 ? 1.0f : inner;
+		x = radius * maskSin(angle);
+		y = -radius * maskCos(angle);
+	};
+	return makeMask([=](float u, float v) {
+		auto inside = false;
+		for (int k = 0; k < 2 * points; ++k) {
+			float ax = 0.0f, ay = 0.0f, bx = 0.0f, by = 0.0f;
+			vertex(k, ax, ay);
+			vertex(k + 1, bx, by);
+			if ((ay > v) != (by > v) && u < ax + (v - ay) * (bx - ax) / (by - ay)) {
+				inside = !inside;
+			}
+		}
+		return inside;
+	});
+}
+
+/// 組み込みの形
+///
+/// コンパイル時に作られて実行ファイルに埋め込まれるため、起動時に画像を読み込む必要がない。
+constexpr MaskRows CIRCLE_MASK = makeEllipseMask(1.0f, 1.0f);
+constexpr MaskRows RICE_MASK = makeEllipseMask(1.0f, 0.35f);
+constexpr MaskRows STAR_MASK = makeStarMask(5, 0.45f);
+constexpr MaskRows LASER_MASK = makeBoxMask(0.95f, 0.15f);
+
+/// 衝突判定の形をまとめて持つアトラス
+///
+/// 形はMASK_SIZE x MASK_SIZEの1bitの画像で、物体の半径rの円に外接する正方形[-r, r]^2に拡大縮小して用いる。
+/// 形は起動時に加え、以後は物体の持つ番号だけで参照する。
+///
+/// NOTE: 形は円の内側に収めること。ビットマップ以外の判定では外接する円で判定する。
+class MaskAtlas final {
+private:
+	/// 形ごとにMASK_SIZE行
+	std::vector<uint32_t> _rows;
+
+public:
+	/// 0番の円だけを持つアトラスを作る
+	MaskAtlas(): _rows(CIRCLE_MASK.begin(), CIRCLE_MASK.end()) {}
+	MaskAtlas(const MaskAtlas &) = delete;
+	MaskAtlas(const MaskAtlas &&) = delete;
+	MaskAtlas &operator=(const MaskAtlas &) = delete;
+	MaskAtlas &&operator=(const MaskAtlas &&) = delete;
+	~MaskAtlas() = default;
+
+	/// 形rowsを加え、その番号を返す関数
+	inline uint32_t add(const MaskRows &rows) {
+		const auto shape = static_cast<uint32_t>(size());
+		_rows.insert(_rows.end(), rows.begin(), rows.end());
+		return shape;
+	}
+
+	/// 画素の中心(u, v) ∈ [-1, 1]^2が内側ならばtrueを返すinsideから形を作り、その番号を返す関数
+	template<typename F>
+	uint32_t add(F inside) {
+		return add(makeMask(inside));
+	}
+
+	/// 半径(rx, ry)の楕円を加える関数
+	inline uint32_t addEllipse(float rx, float ry) {
+		return add(makeEllipseMask(rx, ry));
+	}
+
+	/// 半分の幅と高さとが(hx, hy)の長方形を加える関数
+	inline uint32_t addBox(float hx, float hy) {
+		return add(makeBoxMask(hx, hy));
+	}
+
+	/// points個の頂点を持ち、へこみの半径がinnerの星形を加える関数
+	inline uint32_t addStar(int points, float inner) {
+		return add(makeStarMask(points, inner));
+	}
+
+	/// RGBAの画像の不透明な画素(アルファが0でない画素)を形として加える関数
+	///
+	/// 画像は最近傍でMASK_SIZE x MASK_SIZEに縮める。独自の絵を形にするときに用いる。
+	inline uint32_t addImage(const unsigned char *rgba, int width, int height) {
+		return add([=](float u, float v) {
+			const auto x = std::clamp(static_cast<int>((u + 1.0f) / 2.0f * static_cast<float>(width)), 0, width - 1);
+			const auto y = std::clamp(static_cast<int>((v + 1.0f) / 2.0f * static_cast<float>(height)), 0, height - 1);
+			return rgba[(static_cast<size_t>(y) * width + x) * 4 + 3] != 0;
+		});
+	}
+
+	/// 形の数
+	inline size_t size() const {
+		return _rows.size() / MASK_SIZE;
+	}
+
+	/// 形shapeのy行目
+	inline uint32_t getRow(uint32_t shape, int y) const {
+		return _rows[static_cast<size_t>(shape) * MASK_SIZE + y];
+	}
+
+	/// 形shapeの(u, v) ∈ [-1, 1]^2の点が内側にあるか
+	inline bool test(uint32_t shape, float u, float v) const {
+		const auto x = static_cast<int>(std::floor((u + 1.0f) / 2.0f * static_cast<float>(MASK_SIZE)));
+		const auto y = static_cast<int>(std::floor((v + 1.0f) / 2.0f * static_cast<float>(MASK_SIZE)));
+		if (x < 0 || x >= MASK_SIZE || y < 0 || y >= MASK_SIZE) {
+			return false;
+		}
+		return (getRow(shape, y) >> x) & 1;
+	}
+
+	/// 形shapeを、テクセル(tu, tv)の中心を整数の座標として双線形補間した値
+	///
+	/// 形の外側のテクセルは0とみなす。GPU版の線形サンプラーでの値と同じ。
+	inline float sample(uint32_t shape, float tu, float tv) const {
+		const auto fu = std::floor(tu);
+		const auto fv = std::floor(tv);
+		const auto wu = tu - fu;
+		const auto wv = tv - fv;
+		const auto x = static_cast<int>(fu);
+		const auto y = static_cast<int>(fv);
+		const auto texel = [&](int tx, int ty) {
+			if (tx < 0 || tx >= MASK_SIZE || ty < 0 || ty >= MASK_SIZE) {
+				return 0.0f;
+			}
+			return static_cast<float>((getRow(shape, ty) >> tx) & 1);
+		};
+		return
+			  (texel(x, y) * (1.0f - wu) + texel(x + 1, y) * wu) * (1.0f - wv)
+			+ (texel(x, y + 1) * (1.0f - wu) + texel(x + 1, y + 1) * wu) * wv;
+	}
+
+	/// 形shapeのテクセルの範囲[tu0, tu1) x [tv0, tv1)に、内側のテクセルがあるか
+	///
+	/// 範囲は形の内側に切り詰められる。
+	inline bool any(uint32_t shape, int tu0, int tv0, int tu1, int tv1) const {
+		tu0 = std::max(tu0, 0);
+		tv0 = std::max(tv0, 0);
+		tu1 = std::min(tu1, MASK_SIZE);
+		tv1 = std::min(tv1, MASK_SIZE);
+		if (tu0 >= tu1) {
+			return false;
+		}
+		const auto bits = (tu1 - tu0 == 32 ? ~0u : ((1u << (tu1 - tu0)) - 1)) << tu0;
+		for (auto ty = tv0; ty < tv1; ++ty) {
+			if ((getRow(shape, ty) & bits) != 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+/// (cx, cy)に半径rで置いた形shapeが覆う画素を、行ごとの連続した範囲としてf(y, x0, x1)に渡す関数
+///
+/// 画素(x, y)は中心(x + 0.5, y + 0.5)が形の内側にあるときに覆われる。範囲はwidth x heightの内側に切り詰められる。
+/// 形の行の連続したビットの区間を画素の範囲に直すため、画素ごとには形を参照しない。
+template<typename F>
+void forEachMaskSpan(const MaskAtlas &atlas, uint32_t shape, float cx, float cy, float r, int width, int height, F f) {
+	if (r <= 0.0f) {
+		return;
+	}
+	const auto y0 = std::max(static_cast<int>(std::ceil(cy - r - 0.5f)), 0);
+	const auto y1 = std::min(static_cast<int>(std::floor(cy + r - 0.5f)) + 1, height);
+	// 形の画素1つあたりの画素数と、形の左端の画素の中心が一致する位置
+	const auto pitch = 2.0f * r / static_cast<float>(MASK_SIZE);
+	const auto origin = cx - r - 0.5f;
+	for (int y = y0; y < y1; ++y) {
+		const auto ty = static_cast<int>(std::floor((static_cast<float>(y) + 0.5f - cy + r) / pitch));
+		if (ty < 0 || ty >= MASK_SIZE) {
+			continue;
+		}
+		auto row = atlas.getRow(shape, ty);
+		while (row != 0) {
+			// 立っているビットの区間[ta, tb)
+			const auto ta = std::countr_zero(row);
+			const auto tb = ta + std::countr_one(row >> ta);
+			row = tb < 32 ? row & (~0u << tb) : 0;
+			const auto x0 = std::max(static_cast<int>(std::ceil(origin + static_cast<float>(ta) * pitch)), 0);
+			const auto x1 = std::min(static_cast<int>(std::ceil(origin + static_cast<float>(tb) * pitch)), width);
+			if (x0 < x1) {
+				f(y, x0, x1);
+			}
+		}
+	}
+}
+
+/// (cx, cy)に半径rで角度angleだけ回して置いた形shapeが覆う画素を、行ごとの連続した範囲としてf(y, x0, x1)に渡す関数
+///
+/// 画素の中心を形の座標へ逆に写して形を参照する。行ごとに形の正方形と交わる画素の範囲を先に求め、
+/// その中を32画素ずつ分岐のない固定長のループで調べてビット列にし、連続したビットの区間を範囲として渡す。
+/// そのため区間は32画素の境界で分かれることがある。angleが0ならば回転しない場合と同じ経路を通る。
+template<typename F>
+void forEachMaskSpan(const MaskAtlas &atlas, uint32_t shape, float cx, float cy, float r, float angle, int width, int height, F f) {
+	if (angle == 0.0f) {
+		forEachMaskSpan(atlas, shape, cx, cy, r, width, height, f);
+		return;
+	}
+	if (r <= 0.0f) {
+		return;
+	}
+	std::array<uint32_t, MASK_SIZE> rows;
+	for (int ty = 0; ty < MASK_SIZE; ++ty) {
+		rows[ty] = atlas.getRow(shape, ty);
+	}
+	const auto c = std::cos(angle);
+	const auto s = std::sin(angle);
+	// 回した正方形に外接する正方形の半分の大きさ
+	const auto extent = r * (std::abs(c) + std::abs(s));
+	const auto y0 = std::max(static_cast<int>(std::ceil(cy - extent - 0.5f)), 0);
+	const auto y1 = std::min(static_cast<int>(std::floor(cy + extent - 0.5f)) + 1, height);
+	// 画素のずれ(dx, dy)は形の座標で(dx * c + dy * s, -dx * s + dy * c) * scaleだけ中心からずれる
+	const auto scale = static_cast<float>(MASK_SIZE) / (2.0f * r);
+	const auto half = static_cast<float>(MASK_SIZE) / 2.0f;
+	const auto du = c * scale;
+	const auto dv = -s * scale;
+	// 形の座標での値がvalue + step * xとなる量が[0, MASK_SIZE)に入るxの範囲を[lo, hi)に狭める関数
+	const auto clip = [](float value, float step, float &lo, float &hi) {
+		if (step == 0.0f) {
+			if (value < 0.0f || value >= static_cast<float>(MASK_SIZE)) {
+				hi = lo;
+			}
+			return;
+		}
+		const auto a = -value / step;
+		const auto b = (static_cast<float>(MASK_SIZE) - value) / step;
+		lo = std::max(lo, std::min(a, b));
+		hi = std::min(hi, std::max(a, b));
+	};
+	for (int y = y0; y < y1; ++y) {
+		const auto dy = static_cast<float>(y) + 0.5f - cy;
+		// 画素xの中心での形の座標は(uo + du * x, vo + dv * x)
+		const auto dx = 0.5f - cx;
+		const auto uo = dx * du + dy * s * scale + half;
+		const auto vo = dx * dv + dy * c * scale + half;
+		auto lo = 0.0f;
+		auto hi = static_cast<float>(width);
+		clip(uo, du, lo, hi);
+		clip(vo, dv, lo, hi);
+		const auto x0 = std::max(static_cast<int>(std::ceil(lo)), 0);
+		const auto x1 = std::min(static_cast<int>(std::ceil(hi)), width);
+		for (int xb = x0; xb < x1; xb += 32) {
+			const auto n = std::min(x1 - xb, 32);
+			const auto u0 = uo + du * static_cast<float>(xb);
+			const auto v0 = vo + dv * static_cast<float>(xb);
+			uint32_t bits = 0;
+			for (int k = 0; k < n; ++k) {
+				// NOTE: 範囲の端では丸めで形の外へわずかにはみ出すことがあるため、形の内側に切り詰める。
+				const auto tu = std::clamp(static_cast<int>(u0 + du * static_cast<float>(k)), 0, MASK_SIZE - 1);
+				const auto tv = std::clamp(static_cast<int>(v0 + dv * static_cast<float>(k)), 0, MASK_SIZE - 1);
+				bits |= ((rows[tv] >> tu) & 1) << k;
+			}
+			while (bits != 0) {
+				const auto a = std::countr_zero(bits);
+				const auto b = a + std::countr_one(bits >> a);
+				bits = b < 32 ? bits & (~0u << b) : 0;
+				f(y, xb + a, xb + b);
+			}
+		}
+	}
+}
+
+/// (cx, cy)に半径rで角度angleだけ回して置いた形shapeが、規則coverageで覆う画素を行ごとの連続した範囲としてf(y, x0, x1)に渡す関数
+///
+/// 中心の規則ならば規則を指定しない場合と同じ経路を通る。
+/// それ以外の規則では画素ごとに形を参照する。しきい値の規則では画素の中心で双線形補間した値をしきい値と比べ、
+/// 保守的な規則では画素の正方形を形の座標へ写したものに外接する長方形のテクセルのいずれかが内側かを調べる。
+/// NOTE: 画素ごとに形を参照するため、中心の規則より描画・照合が遅い。
+template<typename F>
+void forEachMaskSpan(const MaskAtlas &atlas, uint32_t shape, float cx, float cy, float r, float angle, const Coverage &coverage, int width, int height, F f) {
+	if (coverage.mode == CoverageMode::Center) {
+		forEachMaskSpan(atlas, shape, cx, cy, r, angle, width, height, f);
+		return;
+	}
+	if (r <= 0.0f) {
+		return;
+	}
+	const auto c = std::cos(angle);
+	const auto s = std::sin(angle);
+	// 回した正方形に外接する正方形の半分の大きさに、画素1つ分の余白を加えたもの
+	const auto extent = r * (std::abs(c) + std::abs(s)) + 1.0f;
+	const auto y0 = std::max(static_cast<int>(std::floor(cy - extent)), 0);
+	const auto y1 = std::min(static_cast<int>(std::ceil(cy + extent)), height);
+	const auto scale = static_cast<float>(MASK_SIZE) / (2.0f * r);
+	const auto half = static_cast<float>(MASK_SIZE) / 2.0f;
+	const auto du = c * scale;
+	const auto dv = -s * scale;
+	// 画素の正方形を形の座標へ写したものに外接する正方形の半分の大きさ
+	const auto reach = 0.5f * (std::abs(c) + std::abs(s)) * scale;
+	// 画素の中心の形の座標がこの幅だけ形の正方形の外側にあれば、内側のテクセルを参照しない
+	const auto margin = coverage.mode == CoverageMode::Threshold ? 0.5f : reach;
+	const auto clip = [margin](float value, float step, float &lo, float &hi) {
+		if (step == 0.0f) {
+			if (value <= -margin || value >= static_cast<float>(MASK_SIZE) + margin) {
+				hi = lo;
+			}
+			return;
+		}
+		const auto a = (-margin - value) / step;
+		const auto b = (static_cast<float>(MASK_SIZE) + margin - value) / step;
+		lo = std::max(lo, std::min(a, b));
+		hi = std::min(hi, std::max(a, b));
+	};
+	const auto covered = [&](float u, float v) {
+		if (coverage.mode == CoverageMode::Threshold) {
+			return atlas.sample(shape, u - 0.5f, v - 0.5f) >= coverage.threshold;
+		}
+		return atlas.any(
+			shape,
+			static_cast<int>(std::floor(u - reach)),
+			static_cast<int>(std::floor(v - reach)),
+			static_cast<int>(std::ceil(u + reach)),
+			static_cast<int>(std::ceil(v + reach))
+		);
+	};
+	for (int y = y0; y < y1; ++y) {
+		const auto dy = static_cast<float>(y) + 0.5f - cy;
+		const auto dx = 0.5f - cx;
+		const auto uo = dx * du + dy * s * scale + half;
+		const auto vo = dx * dv + dy * c * scale + half;
+		auto lo = 0.0f;
+		auto hi = static_cast<float>(width);
+		clip(uo, du, lo, hi);
+		clip(vo, dv, lo, hi);
+		const auto x0 = std::max(static_cast<int>(std::floor(lo)), 0);
+		const auto x1 = std::min(static_cast<int>(std::ceil(hi)), width);
+		auto start = -1;
+		for (int x = x0; x < x1; ++x) {
+			if (covered(uo + du * static_cast<float>(x), vo + dv * static_cast<float>(x))) {
+				if (start < 0) {
+					start = x;
+				}
+			} else if (start >= 0) {
+				f(y, start, x);
+				start = -1;
+			}
+		}
+		if (start >= 0) {
+			f(y, start, x1);
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "jobsystem.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/// parallelFor()などが用いるジョブシステムを保持する変数
+inline JobSystem *&getJobSystemSlot() {
+	static JobSystem *system = nullptr;
+	return system;
+}
+
+/// parallelFor()などが用いるジョブシステム(設定されていなければnullptr)
+inline JobSystem *getJobSystem() {
+	return getJobSystemSlot();
+}
+
+/// parallelFor()などが用いるジョブシステムを設定する関数
+///
+/// nullptrならば、parallelFor()は呼ぶたびにスレッドを作る。
+///
+/// WARN: ジョブシステムを作ったスレッドから呼ぶこと。
+inline void setJobSystem(JobSystem *system) {
+	getJobSystemSlot() = system;
+}
+
+/// 並列処理に用いるワーカー数
+///
+/// ジョブシステムが設定されていればそのワーカー数、そうでなければハードウェアのスレッド数。
+/// 呼び出し元のスレッドも1つのワーカーとして数える。
+inline unsigned int getWorkerCount() {
+	static const unsigned int count = std::max(std::thread::hardware_concurrency(), 1u);
+	if (const auto *system = getJobSystem()) {
+		return system->getWorkerCount();
+	}
+	return count;
+}
+
+/// parallelFor()が[0, count)を分ける区間の数
+///
+/// 区間ごとの作業領域を確保するときに用いる。
+inline size_t getChunkCount(size_t count, size_t minChunk = 4096) {
+	return std::max<size_t>(std::min<size_t>(getWorkerCount(), count / std::max<size_t>(minChunk, 1)), 1);
+}
+
+/// [0, count)を連続した区間に分け、f(begin, end, chunk)を並列に呼ぶ関数
+///
+/// 区間の数はワーカー数以下で、各区間はminChunk個以上の要素を持つ。chunkは区間の番号。
+/// ジョブシステムが設定されていれば区間ごとのジョブとして積む。
+/// そうでなければ最初の区間は呼び出し元のスレッドで処理する。どちらもすべての区間が終わるまで戻らない。
+///
+/// NOTE: ジョブシステムがなければ呼ぶたびにスレッドを作るため、数千要素以下の処理では分けない方が速い。
+template<typename F>
+void parallelFor(size_t count, F f, size_t minChunk = 4096) {
+	const auto chunkCount = getChunkCount(count, minChunk);
+	const auto boundary = [&](size_t chunk) {
+		return count * chunk / chunkCount;
+	};
+	if (chunkCount == 1) {
+		f(0, count, 0);
+		return;
+	}
+	if (auto *system = getJobSystem()) {
+		system->parallelFor(chunkCount, [&](size_t begin, size_t end) {
+			for (auto chunk = begin; chunk < end; ++chunk) {
+				f(boundary(chunk), boundary(chunk + 1), chunk);
+			}
+		});
+		return;
+	}
+	std::vector<std::thread> threads;
+	threads.reserve(chunkCount - 1);
+	for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+		threads.emplace_back([&, chunk]() { f(boundary(chunk), boundary(chunk + 1), chunk); });
+	}
+	f(boundary(0), boundary(1), 0);
+	for (auto &n: threads) {
+		n.join();
+	}
+}
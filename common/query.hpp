@@ -0,0 +1,81 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+/// k近傍の問い合わせで求められる近傍の数の上限
+constexpr size_t QUERY_NEAREST_MAX = 64;
+
+/// 問い合わせの円
+struct QueryCircle {
+	float x;
+	float y;
+	float r;
+};
+
+/// 問い合わせの点
+struct QueryPoint {
+	float x;
+	float y;
+};
+
+/// 一括問い合わせの結果の書き出し先
+///
+/// 領域は呼び出し側が用意し、問い合わせの中で確保は起こらない。
+/// i番目の問い合わせの結果はids[offset, offset + counts[i])に書かれる。offsetはcounts[0, i)の和。
+/// idsが満杯になった後の結果は捨てられ、isTruncated()がtrueになる(countsは書かれた数だけを数える)。
+class QueryResults final {
+private:
+	EntityId *_ids;
+	size_t _capacity;
+	uint32_t *_counts;
+	size_t _size;
+	bool _truncated;
+
+public:
+	/// idsはcapacity個、countsは一括で行う問い合わせの数以上の大きさにしておくこと
+	explicit QueryResults(EntityId *ids, size_t capacity, uint32_t *counts):
+		_ids(ids),
+		_capacity(capacity),
+		_counts(counts),
+		_size(0),
+		_truncated(false)
+	{}
+
+	inline void clear() {
+		_size = 0;
+		_truncated = false;
+	}
+
+	/// query番目の問い合わせの結果を書き始める関数
+	inline void begin(size_t query) {
+		_counts[query] = 0;
+	}
+
+	/// query番目の問い合わせの結果にidを加える関数
+	///
+	/// WARN: 問い合わせごとに結果を続けて加えること。
+	inline void push(size_t query, EntityId id) {
+		if (_size == _capacity) {
+			_truncated = true;
+			return;
+		}
+		_ids[_size++] = id;
+		_counts[query] += 1;
+	}
+
+	inline const EntityId *getIds() const {
+		return _ids;
+	}
+	inline const uint32_t *getCounts() const {
+		return _counts;
+	}
+	inline size_t size() const {
+		return _size;
+	}
+	inline bool isTruncated() const {
+		return _truncated;
+	}
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// 32bitのキーと値との組を、キーの昇順に並べ替えるLSD基数ソート
+///
+/// DIGIT_BITSは一回の振り分けで扱う桁の幅で、8bitならば4回、11bitならば3回振り分ける。
+/// 振り分けは安定で、区間ごとの度数表と、その(桁, 区間)順の累積和から求めた書き込み位置とで並列に行う。
+/// すべてのキーで同じ値を持つ桁(上位の0など)の振り分けは省く。
+/// 度数表はワーカー数分を作成時に確保し(ジョブシステムの設定でワーカー数が増えたときだけ確保し直す)、
+/// 振り分け先の作業領域は保持して使い回すか呼び出し側が与える。
+template<unsigned int DIGIT_BITS = 8>
+class RadixSorter final {
+	static_assert(DIGIT_BITS == 8 || DIGIT_BITS == 11, "digit must be 8 or 11 bits.");
+
+private:
+	static constexpr size_t RADIX = size_t{1} << DIGIT_BITS;
+	static constexpr size_t MIN_CHUNK = 16384;
+
+	std::vector<uint32_t> _keys;
+	std::vector<uint32_t> _values;
+	std::vector<uint32_t> _histograms;
+
+public:
+	RadixSorter(): _keys(), _values(), _histograms(getWorkerCount() * RADIX) {}
+	RadixSorter(const RadixSorter &) = delete;
+	RadixSorter(const RadixSorter &&) = delete;
+	RadixSorter &operator=(const RadixSorter &) = delete;
+	RadixSorter &&operator=(const RadixSorter &&) = delete;
+	~RadixSorter() = default;
+
+	/// count個までの並べ替えで確保が起こらないよう、作業領域を確保しておく関数
+	void reserve(size_t count) {
+		if (_keys.size() < count) {
+			_keys.resize(count);
+			_values.resize(count);
+		}
+	}
+
+	/// keysとvaluesとの[0, count)を、keysの昇順に並べ替える関数
+	///
+	/// 作業領域が足りなければ確保する。
+	void sort(uint32_t *keys, uint32_t *values, size_t count) {
+		reserve(count);
+		sort(keys, values, _keys.data(), _values.data(), count);
+	}
+
+	/// keysとvaluesとの[0, count)を、tmpKeysとtmpValuesとを作業領域として並べ替える関数
+	///
+	/// 確保は起こらない。
+	///
+	/// WARN: tmpKeysとtmpValuesとはcount個以上の大きさにしておくこと。
+	void sort(uint32_t *keys, uint32_t *values, uint32_t *tmpKeys, uint32_t *tmpValues, size_t count) {
+		const auto chunkCount = getChunkCount(count, MIN_CHUNK);
+		if (_histograms.size() < chunkCount * RADIX) {
+			_histograms.resize(chunkCount * RADIX);
+		}
+		auto *srcKeys = keys;
+		auto *srcValues = values;
+		auto *dstKeys = tmpKeys;
+		auto *dstValues = tmpValues;
+		for (unsigned int shift = 0; shift < 32; shift += DIGIT_BITS) {
+			const auto digit = [shift](uint32_t key) {
+				return (key >> shift) & (RADIX - 1);
+			};
+			parallelFor(count, [&](size_t begin, size_t end, size_t chunk) {
+				auto *histogram = &_histograms[chunk * RADIX];
+				std::fill(histogram, histogram + RADIX, 0);
+				for (size_t i = begin; i < end; ++i) {
+					histogram[digit(srcKeys[i])] += 1;
+				}
+			}, MIN_CHUNK);
+			uint32_t offset = 0;
+			auto skip = false;
+			for (size_t d = 0; d < RADIX; ++d) {
+				const auto start = offset;
+				for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+					auto &n = _histograms[chunk * RADIX + d];
+					const auto bucket = n;
+					n = offset;
+					offset += bucket;
+				}
+				skip |= offset - start == count;
+			}
+			if (skip) {
+				continue;
+			}
+			parallelFor(count, [&](size_t begin, size_t end, size_t chunk) {
+				auto *position = &_histograms[chunk * RADIX];
+				for (size_t i = begin; i < end; ++i) {
+					const auto p = position[digit(srcKeys[i])]++;
+					dstKeys[p] = srcKeys[i];
+					dstValues[p] = srcValues[i];
+				}
+			}, MIN_CHUNK);
+			std::swap(srcKeys, dstKeys);
+			std::swap(srcValues, dstValues);
+		}
+		if (srcKeys != keys) {
+			parallelFor(count, [&](size_t begin, size_t end, size_t) {
+				std::copy(srcKeys + begin, srcKeys + end, keys + begin);
+				std::copy(srcValues + begin, srcValues + end, values + begin);
+			}, MIN_CHUNK);
+		}
+	}
+};
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+/// 粗い占有格子の一辺の画素数のlog2
+///
+/// 8x8画素ごとに、その中に存在する物体群のビットを持つ。
+constexpr int OCCUPANCY_CELL_SHIFT = 3;
+constexpr int OCCUPANCY_CELL_SIZE = 1 << OCCUPANCY_CELL_SHIFT;
+
+/// 光線
+///
+/// (x, y)から向き(dx, dy)へlengthだけ進む。距離は向きの長さを単位とするため、向きは正規化しておくこと。
+struct Ray {
+	float x;
+	float y;
+	float dx;
+	float dy;
+	float length;
+
+	/// 線分(ax, ay)-(bx, by)を光線にする関数
+	static inline Ray ofSegment(float ax, float ay, float bx, float by) {
+		const auto dx = bx - ax;
+		const auto dy = by - ay;
+		const auto length = std::sqrt(dx * dx + dy * dy);
+		if (length <= 0.0f) {
+			return {ax, ay, 0.0f, 0.0f, 0.0f};
+		}
+		return {ax, ay, dx / length, dy / length, length};
+	}
+};
+
+/// 衝突判定ビットマップの粗い占有格子
+///
+/// 升目ごとに、その中の画素に存在する物体群のビットの論理和を持つ。
+/// 光線の走査で、調べる物体群の存在しない升目を画素ごとに辿らずに飛ばすために用いる。
+class OccupancyGrid final {
+private:
+	int _width;
+	int _height;
+	int _cellsX;
+	int _cellsY;
+	std::vector<uint32_t> _cells;
+
+public:
+	explicit OccupancyGrid(int width, int height):
+		_width(width),
+		_height(height),
+		_cellsX((width + OCCUPANCY_CELL_SIZE - 1) >> OCCUPANCY_CELL_SHIFT),
+		_cellsY((height + OCCUPANCY_CELL_SIZE - 1) >> OCCUPANCY_CELL_SHIFT),
+		_cells(static_cast<size_t>(_cellsX) * _cellsY, 0)
+	{}
+	OccupancyGrid(const OccupancyGrid &) = delete;
+	OccupancyGrid(const OccupancyGrid &&) = delete;
+	OccupancyGrid &operator=(const OccupancyGrid &) = delete;
+	OccupancyGrid &&operator=(const OccupancyGrid &&) = delete;
+	~OccupancyGrid() = default;
+
+	inline int getWidth() const {
+		return _width;
+	}
+	inline int getHeight() const {
+		return _height;
+	}
+	inline int getCellsX() const {
+		return _cellsX;
+	}
+	inline int getCellsY() const {
+		return _cellsY;
+	}
+
+	/// すべての升目をbitsにする関数
+	///
+	/// ~0uを渡すと升目を飛ばさない走査になる。
+	inline void fill(uint32_t bits) {
+		std::fill(_cells.begin(), _cells.end(), bits);
+	}
+
+	/// 升目(cx, cy)にbitsを加える関数
+	inline void mark(int cx, int cy, uint32_t bits) {
+		_cells[static_cast<size_t>(cy) * _cellsX + cx] |= bits;
+	}
+	inline uint32_t get(int cx, int cy) const {
+		return _cells[static_cast<size_t>(cy) * _cellsX + cx];
+	}
+
+	/// 画素(x, y)に存在する物体群のビットを返すpixelから作り直す関数
+	///
+	/// 画素ごとの配列しか持たないビットマップ(GPU版など)向け。
+	template<typename F>
+	void build(F pixel) {
+		fill(0);
+		for (int y = 0; y < _height; ++y) {
+			auto *row = &_cells[static_cast<size_t>(y >> OCCUPANCY_CELL_SHIFT) * _cellsX];
+			for (int x = 0; x < _width; ++x) {
+				row[x >> OCCUPANCY_CELL_SHIFT] |= pixel(x, y);
+			}
+		}
+	}
+};
+
+/// 格子を光線に沿って一升ずつ辿る走査(DDA)の状態
+///
+/// 升目(x, y)に入ったときの距離をtに持ち、step()で次に光線が通る升目へ進む。
+struct GridWalker {
+	int x;
+	int y;
+	int sx;
+	int sy;
+	float t;
+	float tMaxX;
+	float tMaxY;
+	float tDeltaX;
+	float tDeltaY;
+
+	/// 一辺sizeの格子の升目(x, y)に距離tで入った状態を作る関数
+	static inline GridWalker start(const Ray &ray, float size, int x, int y, float t) {
+		GridWalker walker{x, y, ray.dx < 0.0f ? -1 : 1, ray.dy < 0.0f ? -1 : 1, t, HUGE_VALF, HUGE_VALF, HUGE_VALF, HUGE_VALF};
+		if (ray.dx != 0.0f) {
+			const auto boundary = static_cast<float>(ray.dx < 0.0f ? x : x + 1) * size;
+			walker.tMaxX = (boundary - ray.x) / ray.dx;
+			walker.tDeltaX = size / std::abs(ray.dx);
+		}
+		if (ray.dy != 0.0f) {
+			const auto boundary = static_cast<float>(ray.dy < 0.0f ? y : y + 1) * size;
+			walker.tMaxY = (boundary - ray.y) / ray.dy;
+			walker.tDeltaY = size / std::abs(ray.dy);
+		}
+		return walker;
+	}
+
+	inline void step() {
+		if (tMaxX < tMaxY) {
+			t = tMaxX;
+			x += sx;
+			tMaxX += tDeltaX;
+		} else {
+			t = tMaxY;
+			y += sy;
+			tMaxY += tDeltaY;
+		}
+	}
+};
+
+/// 光線がwidth x heightの範囲に入る距離と出る距離とを求める関数
+///
+/// 範囲と交わらなければfalseを返す。距離は[0, length]に切り詰められる。
+inline bool clipRay(const Ray &ray, int width, int height, float &t0, float &t1) {
+	t0 = 0.0f;
+	t1 = ray.length;
+	for (const auto &[origin, direction, extent]: {
+		std::tuple{ray.x, ray.dx, static_cast<float>(width)},
+		std::tuple{ray.y, ray.dy, static_cast<float>(height)},
+	}) {
+		if (direction == 0.0f) {
+			if (origin < 0.0f || origin >= extent) {
+				return false;
+			}
+			continue;
+		}
+		const auto a = (0.0f - origin) / direction;
+		const auto b = (extent - origin) / direction;
+		t0 = std::max(t0, std::min(a, b));
+		t1 = std::min(t1, std::max(a, b));
+	}
+	return t0 <= t1;
+}
+
+/// 光線rayが最初に通るmaskの物体群の画素までの距離を、物体群ごとにdistances[g]に書き込む関数
+///
+/// 占有格子の升目をDDAで辿り、maskの物体群が存在する升目の中だけを画素ごとにDDAで辿る。
+/// 画素までの距離は光線がその画素に入るときの距離(始点が画素の中ならば0)。
+/// maskのすべての物体群が見つかった時点で打ち切る。見つからなかった物体群にはHUGE_VALFを書き込む。
+/// checkは画素(x, y)に存在するmaskの物体群のビットを返す関数(SoftwareBitmap::check()など)。
+template<typename F>
+void castRay(const OccupancyGrid &grid, const Ray &ray, uint32_t mask, float *distances, F check) {
+	for (auto bits = mask; bits != 0; bits &= bits - 1) {
+		distances[std::countr_zero(bits)] = HUGE_VALF;
+	}
+	float t0, t1;
+	if (mask == 0 || !clipRay(ray, grid.getWidth(), grid.getHeight(), t0, t1)) {
+		return;
+	}
+	const auto toPixel = [&](float t, int &x, int &y) {
+		x = std::clamp(static_cast<int>(std::floor(ray.x + ray.dx * t)), 0, grid.getWidth() - 1);
+		y = std::clamp(static_cast<int>(std::floor(ray.y + ray.dy * t)), 0, grid.getHeight() - 1);
+	};
+	int px, py;
+	toPixel(t0, px, py);
+	auto remaining = mask;
+	auto cell = GridWalker::start(
+		ray,
+		static_cast<float>(OCCUPANCY_CELL_SIZE),
+		px >> OCCUPANCY_CELL_SHIFT,
+		py >> OCCUPANCY_CELL_SHIFT,
+		t0
+	);
+	while (cell.t <= t1 && cell.x >= 0 && cell.x < grid.getCellsX() && cell.y >= 0 && cell.y < grid.getCellsY()) {
+		if ((grid.get(cell.x, cell.y) & remaining) != 0) {
+			// 升目に入る点の画素から、升目を出るまで画素ごとに辿る
+			const auto x0 = cell.x << OCCUPANCY_CELL_SHIFT;
+			const auto y0 = cell.y << OCCUPANCY_CELL_SHIFT;
+			toPixel(cell.t, px, py);
+			px = std::clamp(px, x0, x0 + OCCUPANCY_CELL_SIZE - 1);
+			py = std::clamp(py, y0, y0 + OCCUPANCY_CELL_SIZE - 1);
+			auto pixel = GridWalker::start(ray, 1.0f, px, py, cell.t);
+			while (pixel.t <= t1 && (pixel.x >> OCCUPANCY_CELL_SHIFT) == cell.x && (pixel.y >> OCCUPANCY_CELL_SHIFT) == cell.y) {
+				const auto found = check(pixel.x, pixel.y, remaining);
+				for (auto bits = found; bits != 0; bits &= bits - 1) {
+					distances[std::countr_zero(bits)] = pixel.t;
+				}
+				remaining &= ~found;
+				if (remaining == 0) {
+					return;
+				}
+				pixel.step();
+			}
+		}
+		cell.step();
+	}
+}
+
+/// count本の光線raysについてcastRay()を行う関数
+///
+/// q本目の光線の結果はdistances[q * groupCount + g]に書かれる。確保は起こらない。
+/// WARN: maskのビットはgroupCount未満であること。
+template<typename F>
+void castRays(const OccupancyGrid &grid, const Ray *rays, size_t count, uint32_t mask, float *distances, size_t groupCount, F check) {
+	for (size_t q = 0; q < count; ++q) {
+		castRay(grid, rays[q], mask, distances + q * groupCount, check);
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+/// 衝突判定ビットマップの倍率scale(ワールドの1単位あたりの画素数)で、ワールドの1辺の長さsizeを覆う画素数を求める関数
+///
+/// 倍率はワールドの大きさ(WorldBounds)と独立に選べる。1ならば画面と同じ解像度、0.5ならば半分、2ならば2倍の解像度。
+inline int toBitmapSize(float size, float scale) {
+	return std::max(static_cast<int>(std::ceil(size * scale)), 1);
+}
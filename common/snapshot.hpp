@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// シーンの状態を平坦なバイト列として保持する領域
+///
+/// 状態は書き込んだ順にmemcpyで詰め、同じ順に読み出す。領域は作成時に確保し、足りなくなったときだけ確保し直す。
+class Snapshot final {
+private:
+	std::vector<std::byte> _data;
+	size_t _size;
+	size_t _cursor;
+	unsigned long long _frame;
+	bool _valid;
+
+public:
+	explicit Snapshot(size_t capacity = 0): _data(capacity), _size(0), _cursor(0), _frame(0), _valid(false) {}
+	Snapshot(const Snapshot &) = delete;
+	Snapshot(const Snapshot &&) = delete;
+	Snapshot &operator=(const Snapshot &) = delete;
+	Snapshot &&operator=(const Snapshot &&) = delete;
+	~Snapshot() = default;
+
+	/// frame番目のフレームの状態の書き込みを始める関数
+	inline void beginWrite(unsigned long long frame) {
+		_size = 0;
+		_frame = frame;
+		_valid = true;
+	}
+
+	/// 状態の読み出しを始める関数
+	inline void beginRead() {
+		if (!_valid) {
+			throw "snapshot is empty.";
+		}
+		_cursor = 0;
+	}
+
+	/// count個の要素を末尾に書き込む関数
+	template<typename T>
+	void write(const T *values, size_t count) {
+		static_assert(std::is_trivially_copyable_v<T>, "snapshot values must be trivially copyable.");
+		const auto bytes = sizeof(T) * count;
+		if (_data.size() < _size + bytes) {
+			_data.resize(std::max(_size + bytes, _data.size() * 2));
+		}
+		if (bytes > 0) {
+			std::memcpy(_data.data() + _size, values, bytes);
+		}
+		_size += bytes;
+	}
+	template<typename T>
+	inline void write(const T &value) {
+		write(&value, 1);
+	}
+	template<typename T>
+	inline void write(const std::vector<T> &values) {
+		write(values.size());
+		write(values.data(), values.size());
+	}
+
+	/// count個の要素を読み出す関数
+	template<typename T>
+	void read(T *values, size_t count) {
+		static_assert(std::is_trivially_copyable_v<T>, "snapshot values must be trivially copyable.");
+		const auto bytes = sizeof(T) * count;
+		if (_cursor + bytes > _size) {
+			throw "snapshot is too short.";
+		}
+		if (bytes > 0) {
+			std::memcpy(values, _data.data() + _cursor, bytes);
+		}
+		_cursor += bytes;
+	}
+	template<typename T>
+	inline void read(T &value) {
+		read(&value, 1);
+	}
+
+	/// write(const std::vector<T> &)で書き込んだ配列を読み出す関数
+	///
+	/// 要素数が同じならば確保は起こらない。
+	template<typename T>
+	void read(std::vector<T> &values) {
+		size_t count = 0;
+		read(count);
+		values.resize(count);
+		read(values.data(), count);
+	}
+
+	inline const std::byte *data() const {
+		return _data.data();
+	}
+	inline size_t size() const {
+		return _size;
+	}
+	inline size_t getCapacity() const {
+		return _data.size();
+	}
+	inline unsigned long long getFrame() const {
+		return _frame;
+	}
+	inline bool isValid() const {
+		return _valid;
+	}
+};
+
+/// 直近のフレームの状態を保持するSnapshotのリング
+///
+/// frame番目のフレームの状態はframe % slotCount番目の領域に書き込まれ、
+/// slotCountフレーム前の状態を上書きする。巻き戻しで遡るフレーム数より多くの領域を持たせること。
+class SnapshotRing final {
+private:
+	std::vector<std::unique_ptr<Snapshot>> _slots;
+
+public:
+	/// slotCount個の領域を、それぞれcapacityバイトずつ確保する
+	explicit SnapshotRing(size_t slotCount, size_t capacity): _slots() {
+		if (slotCount == 0) {
+			throw "snapshot ring needs at least one slot.";
+		}
+		for (size_t i = 0; i < slotCount; ++i) {
+			_slots.push_back(std::make_unique<Snapshot>(capacity));
+		}
+	}
+	SnapshotRing(const SnapshotRing &) = delete;
+	SnapshotRing(const SnapshotRing &&) = delete;
+	SnapshotRing &operator=(const SnapshotRing &) = delete;
+	SnapshotRing &&operator=(const SnapshotRing &&) = delete;
+	~SnapshotRing() = default;
+
+	/// frame番目のフレームの状態を書き込む領域を返す関数
+	inline Snapshot &acquire(unsigned long long frame) {
+		auto &slot = *_slots[frame % _slots.size()];
+		slot.beginWrite(frame);
+		return slot;
+	}
+
+	/// frame番目のフレームの状態を返す関数
+	///
+	/// すでに上書きされているか、書き込まれていなければ例外を投げる。
+	inline Snapshot &get(unsigned long long frame) {
+		auto &slot = *_slots[frame % _slots.size()];
+		if (!slot.isValid() || slot.getFrame() != frame) {
+			throw "snapshot of the frame is not in the ring.";
+		}
+		return slot;
+	}
+
+	inline size_t getSlotCount() const {
+		return _slots.size();
+	}
+};
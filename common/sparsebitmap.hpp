@@ -0,0 +1,305 @@
+#pragma once
+
+#include "common.hpp"
+#include "coverage.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/// 疎な衝突判定ビットマップの区画の一辺の画素数のlog2
+///
+/// 区画の1行は32bitの語一つに収まる。
+constexpr int SPARSE_TILE_SHIFT = 5;
+constexpr int SPARSE_TILE_SIZE = 1 << SPARSE_TILE_SHIFT;
+
+/// 物体のいる所だけ画素を持つ、CPU上の衝突判定ビットマップ
+///
+/// 物体群ごとの面をSPARSE_TILE_SIZE四方の区画に分け、円の画素がかかった区画だけをプールから確保する。
+/// 区画の表(ディレクトリ)は面ごと・区画ごとにプールの番号を持ち、確保していない区画の照合は表を引くだけで終わる。
+/// 消去は確保した区画をプールに返すだけなので、メモリと消去・描画・照合の時間とは物体の覆う面積に比例する。
+/// 物体がまばらなシーンではSoftwareBitmapより速く小さいが、画面を覆うほど物体が多いと表を引く分だけ遅い(sparse-bitmapの計測を参照)。
+/// 画素の格子と覆い方の規則とはSoftwareBitmapと同じで、同じ円を描画・照合すれば同じ結果となる。
+///
+/// NOTE: 円だけを扱う。形・カプセル・距離場・光線はSoftwareBitmapを用いること。
+/// NOTE: プールは確保した区画の数の最大値まで伸び、縮めない。
+class SparseBitmap final {
+private:
+	/// 区画を確保していないことを表す、ディレクトリの値
+	static constexpr uint32_t NO_BLOCK = ~0u;
+
+	const int _width;
+	const int _height;
+	const int _tilesX;
+	const int _tilesY;
+	const unsigned int _groupCount;
+	/// ワールドの1単位あたりの画素数
+	const float _scale;
+	/// 面ごと・区画ごとの、プールでの区画の番号
+	std::vector<uint32_t> _directory;
+	/// 区画の画素 (区画ごとにSPARSE_TILE_SIZE行の32bitの語)
+	std::vector<uint32_t> _pool;
+	/// プールの空いている区画の番号
+	std::vector<uint32_t> _free;
+	/// 面ごとの、確保した区画のディレクトリでの位置
+	std::vector<std::vector<uint32_t>> _allocated;
+	Coverage _coverage;
+
+	inline size_t getDirectoryIndex(unsigned int group, int tx, int ty) const {
+		return (static_cast<size_t>(group) * _tilesY + ty) * _tilesX + tx;
+	}
+
+	/// 区画の行の[x0, x1)のビットを求める関数
+	///
+	/// WARN: 0 <= x0 < x1 <= SPARSE_TILE_SIZEであること。
+	static inline uint32_t getSpanBits(int x0, int x1) {
+		return (~0u >> (SPARSE_TILE_SIZE - (x1 - x0))) << x0;
+	}
+
+	/// 物体群groupの面の区画(tx, ty)を、なければプールから確保して返す関数
+	inline uint32_t *allocate(unsigned int group, int tx, int ty) {
+		const auto index = getDirectoryIndex(group, tx, ty);
+		auto block = _directory[index];
+		if (block == NO_BLOCK) {
+			if (_free.empty()) {
+				block = static_cast<uint32_t>(_pool.size() / SPARSE_TILE_SIZE);
+				_pool.resize(_pool.size() + SPARSE_TILE_SIZE, 0);
+			} else {
+				block = _free.back();
+				_free.pop_back();
+				std::memset(&_pool[static_cast<size_t>(block) * SPARSE_TILE_SIZE], 0, SPARSE_TILE_SIZE * sizeof(uint32_t));
+			}
+			_directory[index] = block;
+			_allocated[group].push_back(static_cast<uint32_t>(index));
+		}
+		return &_pool[static_cast<size_t>(block) * SPARSE_TILE_SIZE];
+	}
+
+	/// 物体群groupの面の区画(tx, ty)を返す関数
+	///
+	/// 確保していなければnullptrを返す。
+	inline const uint32_t *find(unsigned int group, int tx, int ty) const {
+		const auto block = _directory[getDirectoryIndex(group, tx, ty)];
+		return block == NO_BLOCK ? nullptr : &_pool[static_cast<size_t>(block) * SPARSE_TILE_SIZE];
+	}
+
+	/// 区画の1行ぶんの、画素の範囲[x0, x1)
+	struct Span {
+		int x0;
+		int x1;
+	};
+
+	/// 円(cx, cy, r)を区画の行ごとの帯に分け、帯ごとにf(ty, y0, spans, x0, x1)を呼ぶ関数
+	///
+	/// 円はビットマップの画素の座標で与える。spans[k]は行y0 + kの画素の範囲で、空ならばx0 >= x1となる。
+	/// [x0, x1)は帯の範囲すべてを合わせた範囲。範囲はビットマップの内側に切り詰められる。fがfalseを返せば打ち切る。
+	template<typename F>
+	inline void forEachDiskBand(float cx, float cy, float r, F f) const {
+		const auto conservative = _coverage.mode == CoverageMode::Conservative;
+		int y0, y1;
+		if (conservative) {
+			getConservativeDiskRows(cy, r, y0, y1);
+		} else {
+			r = getCoveredRadius(r, _coverage);
+			getCenterDiskRows(cy, r, y0, y1);
+		}
+		y0 = std::max(y0, 0);
+		y1 = std::min(y1, _height);
+		std::array<Span, SPARSE_TILE_SIZE> spans;
+		for (auto top = y0; top < y1; top = (top | (SPARSE_TILE_SIZE - 1)) + 1) {
+			const auto bottom = std::min((top | (SPARSE_TILE_SIZE - 1)) + 1, y1);
+			auto bandX0 = _width;
+			auto bandX1 = 0;
+			for (auto y = top; y < bottom; ++y) {
+				auto &span = spans[y - top];
+				const auto found = conservative
+					? getConservativeDiskSpan(cx, cy, r, y, span.x0, span.x1)
+					: getCenterDiskSpan(cx, cy, r, y, span.x0, span.x1);
+				if (!found) {
+					span = Span{0, 0};
+					continue;
+				}
+				span.x0 = std::max(span.x0, 0);
+				span.x1 = std::min(span.x1, _width);
+				if (span.x0 < span.x1) {
+					bandX0 = std::min(bandX0, span.x0);
+					bandX1 = std::max(bandX1, span.x1);
+				}
+			}
+			if (bandX0 < bandX1 && !f(top >> SPARSE_TILE_SHIFT, top, spans.data(), bottom - top, bandX0, bandX1)) {
+				return;
+			}
+		}
+	}
+
+	/// 帯の範囲spansの、区画の列txにかかる部分について、f(区画の行, 区画の行のビット)を呼ぶ関数
+	///
+	/// fがfalseを返せば打ち切り、falseを返す。
+	template<typename F>
+	static inline bool forEachTileRow(int tx, int y0, const Span *spans, int count, F f) {
+		const auto left = tx << SPARSE_TILE_SHIFT;
+		const auto right = left + SPARSE_TILE_SIZE;
+		const auto row0 = y0 & (SPARSE_TILE_SIZE - 1);
+		for (int k = 0; k < count; ++k) {
+			const auto x0 = std::max(spans[k].x0, left);
+			const auto x1 = std::min(spans[k].x1, right);
+			if (x0 < x1 && !f(row0 + k, getSpanBits(x0 - left, x1 - left))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+public:
+	explicit SparseBitmap(int width, int height, unsigned int groupCount, float scale = 1.0f):
+		_width(width),
+		_height(height),
+		_tilesX((width + SPARSE_TILE_SIZE - 1) / SPARSE_TILE_SIZE),
+		_tilesY((height + SPARSE_TILE_SIZE - 1) / SPARSE_TILE_SIZE),
+		_groupCount(groupCount),
+		_scale(scale),
+		_directory(static_cast<size_t>(_tilesX) * _tilesY * groupCount, NO_BLOCK),
+		_pool(),
+		_free(),
+		_allocated(groupCount),
+		_coverage(Coverage::center())
+	{}
+	SparseBitmap() = delete;
+	SparseBitmap(const SparseBitmap &) = delete;
+	SparseBitmap(const SparseBitmap &&) = delete;
+	SparseBitmap &operator=(const SparseBitmap &) = delete;
+	SparseBitmap &&operator=(const SparseBitmap &&) = delete;
+	~SparseBitmap() = default;
+
+	inline int getWidth() const {
+		return _width;
+	}
+	inline int getHeight() const {
+		return _height;
+	}
+	inline unsigned int getGroupCount() const {
+		return _groupCount;
+	}
+	inline float getScale() const {
+		return _scale;
+	}
+	/// すべての面の区画の数
+	inline size_t getTileCount() const {
+		return _directory.size();
+	}
+	/// すべての面で確保している区画の数
+	inline size_t getAllocatedTileCount() const {
+		size_t count = 0;
+		for (const auto &allocated: _allocated) {
+			count += allocated.size();
+		}
+		return count;
+	}
+	/// ディレクトリとプールとが占めるバイト数
+	inline size_t getAllocatedBytes() const {
+		return (_directory.size() + _pool.size()) * sizeof(uint32_t);
+	}
+
+	inline void setCoverage(const Coverage &coverage) {
+		_coverage = coverage;
+	}
+	inline const Coverage &getCoverage() const {
+		return _coverage;
+	}
+
+	inline void clear() {
+		for (unsigned int g = 0; g < _groupCount; ++g) {
+			clear(g);
+		}
+	}
+	/// 物体群groupの面だけを消す関数
+	///
+	/// 確保した区画をプールに返す。
+	inline void clear(unsigned int group) {
+		for (auto index: _allocated[group]) {
+			_free.push_back(_directory[index]);
+			_directory[index] = NO_BLOCK;
+		}
+		_allocated[group].clear();
+	}
+
+	/// 物体群groupの面に円(cx, cy, r)を描画する関数
+	///
+	/// 画素のかかった区画だけを確保する。
+	inline void drawDisk(unsigned int group, float cx, float cy, float r) {
+		forEachDiskBand(cx * _scale, cy * _scale, r * _scale, [&](int ty, int y0, const Span *spans, int count, int x0, int x1) {
+			for (auto tx = x0 >> SPARSE_TILE_SHIFT; tx <= (x1 - 1) >> SPARSE_TILE_SHIFT; ++tx) {
+				uint32_t *tile = nullptr;
+				forEachTileRow(tx, y0, spans, count, [&](int row, uint32_t bits) {
+					if (!tile) {
+						tile = allocate(group, tx, ty);
+					}
+					tile[row] |= bits;
+					return true;
+				});
+			}
+			return true;
+		});
+	}
+
+	/// 物体群groupのすべての物体を円として描画する関数
+	inline void drawGroup(unsigned int group, const EntityGroup &entities) {
+		for (size_t i = 0; i < entities.size(); ++i) {
+			drawDisk(group, entities.x[i], entities.y[i], entities.r[i]);
+		}
+	}
+
+	/// 画素(x, y)にmaskの物体群のうちどれが存在するか調べる関数
+	///
+	/// 存在する物体群のビットを返す。ビットマップの外側では0を返す。
+	/// NOTE: (x, y)はワールドの座標ではなくビットマップの画素の番号。
+	inline uint32_t check(int x, int y, uint32_t mask) const {
+		if (x < 0 || x >= _width || y < 0 || y >= _height) {
+			return 0;
+		}
+		uint32_t found = 0;
+		for (auto bits = mask; bits != 0; bits &= bits - 1) {
+			const auto g = static_cast<unsigned int>(std::countr_zero(bits));
+			const auto *tile = find(g, x >> SPARSE_TILE_SHIFT, y >> SPARSE_TILE_SHIFT);
+			if (tile && ((tile[y & (SPARSE_TILE_SIZE - 1)] >> (x & (SPARSE_TILE_SIZE - 1))) & 1)) {
+				found |= 1u << g;
+			}
+		}
+		return found;
+	}
+
+	/// 円(cx, cy, r)と重なっているmaskの物体群を調べる関数
+	///
+	/// 円を区画ごとに分け、物体群の面の区画を一度だけ表で引いて行ごとに照合し、重なっている物体群のビットを返す。
+	/// 確保していない区画は行を見ずに飛ばす。maskのビットがすべて見つかった時点で打ち切る。
+	inline uint32_t overlapDisk(float cx, float cy, float r, uint32_t mask) const {
+		uint32_t found = 0;
+		forEachDiskBand(cx * _scale, cy * _scale, r * _scale, [&](int ty, int y0, const Span *spans, int count, int x0, int x1) {
+			for (auto tx = x0 >> SPARSE_TILE_SHIFT; tx <= (x1 - 1) >> SPARSE_TILE_SHIFT; ++tx) {
+				for (auto bits = mask & ~found; bits != 0; bits &= bits - 1) {
+					const auto g = static_cast<unsigned int>(std::countr_zero(bits));
+					const auto *tile = find(g, tx, ty);
+					if (!tile) {
+						continue;
+					}
+					forEachTileRow(tx, y0, spans, count, [&](int row, uint32_t spanBits) {
+						if ((tile[row] & spanBits) == 0) {
+							return true;
+						}
+						found |= 1u << g;
+						return false;
+					});
+				}
+				if (found == mask) {
+					return false;
+				}
+			}
+			return true;
+		});
+		return found;
+	}
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+
+/// 経過時間を計測するオブジェクト
+class Stopwatch final {
+private:
+	std::chrono::steady_clock::time_point _begin;
+
+public:
+	Stopwatch(): _begin(std::chrono::steady_clock::now()) {}
+
+	inline void reset() {
+		_begin = std::chrono::steady_clock::now();
+	}
+	inline double elapsedMs() const {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _begin).count();
+	}
+};
+
+/// cooldown()で待機する時間を保持する変数
+inline std::chrono::milliseconds &getCooldownSlot() {
+	static std::chrono::milliseconds duration(2000);
+	return duration;
+}
+
+/// cooldown()で待機する時間を設定する関数
+///
+/// 0ならば待機しない。計測が短い場合、既定の2秒は計測そのものより長くなる。
+inline void setCooldown(std::chrono::milliseconds duration) {
+	getCooldownSlot() = duration;
+}
+
+/// 計測の合間に待機する関数
+///
+/// NOTE: 念のため、CPU/GPUを冷ますために既定では2秒待つ。
+inline void cooldown() {
+	if (getCooldownSlot().count() > 0) {
+		std::this_thread::sleep_for(getCooldownSlot());
+	}
+}
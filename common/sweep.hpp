@@ -0,0 +1,173 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+/// 物体(x, y, r)と物体群groupの[begin, end)の物体との衝突数を数える関数
+///
+/// 分岐を含まないため、内側のループは自動ベクトル化される。
+inline unsigned long long countHits(const EntityGroup &group, size_t begin, size_t end, float x, float y, float r) {
+	const auto *gx = group.x.data();
+	const auto *gy = group.y.data();
+	const auto *gr = group.r.data();
+	uint32_t count = 0;
+	for (size_t i = begin; i < end; ++i) {
+		const auto dx = x - gx[i];
+		const auto dy = y - gy[i];
+		const auto rr = r + gr[i];
+		count += dx * dx + dy * dy < rr * rr ? 1 : 0;
+	}
+	return count;
+}
+
+/// (px, py)から(x, y)へ動いた半径rの円と、物体群groupの[begin, end)の物体とがフレームの途中で重なった数を数える関数
+///
+/// 相対運動 d(t) = d0 + t * dv (0 <= t <= 1) について |d(t)|^2 < R^2 となるtがあるかを、
+/// 二次式 f(t) = a t^2 + 2 b t + c (a = |dv|^2, b = d0・dv, c = |d0|^2 - R^2) の最小値の符号で判定する。
+/// 除算も分岐も含まないため、内側のループは自動ベクトル化される。
+inline unsigned long long countSweptHits(
+	const EntityGroup &group,
+	size_t begin,
+	size_t end,
+	float px,
+	float py,
+	float x,
+	float y,
+	float r
+) {
+	const auto *gx = group.x.data();
+	const auto *gy = group.y.data();
+	const auto *gpx = group.px.data();
+	const auto *gpy = group.py.data();
+	const auto *gr = group.r.data();
+	const auto vx = x - px;
+	const auto vy = y - py;
+	uint32_t count = 0;
+	for (size_t i = begin; i < end; ++i) {
+		const auto d0x = px - gpx[i];
+		const auto d0y = py - gpy[i];
+		const auto dvx = vx - (gx[i] - gpx[i]);
+		const auto dvy = vy - (gy[i] - gpy[i]);
+		const auto rr = r + gr[i];
+		const auto a = dvx * dvx + dvy * dvy;
+		const auto b = d0x * dvx + d0y * dvy;
+		const auto c = d0x * d0x + d0y * d0y - rr * rr;
+		const auto atStart = c < 0.0f;
+		const auto atEnd = a + 2.0f * b + c < 0.0f;
+		const auto between = (b < 0.0f) & (-b < a) & (b * b > a * c);
+		count += atStart | atEnd | between ? 1 : 0;
+	}
+	return count;
+}
+
+/// 問い合わせ側の4体それぞれについて、物体群targetsとの衝突数を数える関数
+///
+/// targetsを一度だけ走査し、各要素を4体すべてと比較する。
+inline void countHits4(const EntityGroup &targets, const float *qx, const float *qy, const float *qr, unsigned long long *counts) {
+	const auto *tx = targets.x.data();
+	const auto *ty = targets.y.data();
+	const auto *tr = targets.r.data();
+	const auto n = targets.size();
+	uint32_t c0 = 0;
+	uint32_t c1 = 0;
+	uint32_t c2 = 0;
+	uint32_t c3 = 0;
+	for (size_t i = 0; i < n; ++i) {
+		const auto x = tx[i];
+		const auto y = ty[i];
+		const auto r = tr[i];
+		const auto dx0 = qx[0] - x, dy0 = qy[0] - y, rr0 = qr[0] + r;
+		const auto dx1 = qx[1] - x, dy1 = qy[1] - y, rr1 = qr[1] + r;
+		const auto dx2 = qx[2] - x, dy2 = qy[2] - y, rr2 = qr[2] + r;
+		const auto dx3 = qx[3] - x, dy3 = qy[3] - y, rr3 = qr[3] + r;
+		c0 += dx0 * dx0 + dy0 * dy0 < rr0 * rr0 ? 1 : 0;
+		c1 += dx1 * dx1 + dy1 * dy1 < rr1 * rr1 ? 1 : 0;
+		c2 += dx2 * dx2 + dy2 * dy2 < rr2 * rr2 ? 1 : 0;
+		c3 += dx3 * dx3 + dy3 * dy3 < rr3 * rr3 ? 1 : 0;
+	}
+	counts[0] = c0;
+	counts[1] = c1;
+	counts[2] = c2;
+	counts[3] = c3;
+}
+
+/// 少数の物体群queriersと多数の物体群targetsとの衝突数を、queriersの物体ごとに数える関数
+///
+/// queriersを4体ずつまとめ、targetsの走査回数をqueriersの物体数の1/4に抑える。
+///
+/// WARN: countsはqueriersの物体数以上の大きさにしておくこと。
+inline void sweepCount(const EntityGroup &queriers, const EntityGroup &targets, unsigned long long *counts) {
+	const auto n = queriers.size();
+	size_t q = 0;
+	for (; q + 4 <= n; q += 4) {
+		countHits4(targets, &queriers.x[q], &queriers.y[q], &queriers.r[q], &counts[q]);
+	}
+	for (; q < n; ++q) {
+		counts[q] = countHits(targets, 0, targets.size(), queriers.x[q], queriers.y[q], queriers.r[q]);
+	}
+}
+
+/// 物体群groupの各物体の移動全体を囲む円を、boundsのx, y, rに求める関数
+///
+/// 中心は移動の中点、半径は半径と移動距離の半分との和。
+/// 二つの囲む円が重ならなければ、その組は掃引判定でも衝突しない。
+inline void computeSweptBounds(const EntityGroup &group, EntityGroup &bounds) {
+	const auto n = group.size();
+	bounds.x.resize(n);
+	bounds.y.resize(n);
+	bounds.r.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		const auto dx = group.x[i] - group.px[i];
+		const auto dy = group.y[i] - group.py[i];
+		bounds.x[i] = (group.x[i] + group.px[i]) / 2.0f;
+		bounds.y[i] = (group.y[i] + group.py[i]) / 2.0f;
+		bounds.r[i] = group.r[i] + std::sqrt(dx * dx + dy * dy) / 2.0f;
+	}
+}
+
+/// 少数の物体群queriersと多数の物体群targetsとの掃引判定による衝突数を、queriersの物体ごとに数える関数
+///
+/// まず移動全体を囲む円どうしで数え、候補のあった物体についてのみ掃引判定で数え直す。
+///
+/// WARN: countsはqueriersの物体数以上の大きさにしておくこと。
+inline void sweepCountSwept(
+	const EntityGroup &queriers,
+	const EntityGroup &targets,
+	const EntityGroup &queryBounds,
+	const EntityGroup &targetBounds,
+	unsigned long long *counts
+) {
+	sweepCount(queryBounds, targetBounds, counts);
+	for (size_t q = 0; q < queriers.size(); ++q) {
+		if (counts[q] != 0) {
+			counts[q] = countSweptHits(targets, 0, targets.size(), queriers.px[q], queriers.py[q], queriers.x[q], queriers.y[q], queriers.r[q]);
+		}
+	}
+}
+
+/// 物体(x, y, r)と衝突している物体群targetsの物体のインデックスを順にfに渡す関数
+///
+/// sweepCount()で衝突が見つかった問い合わせ側の物体についてのみ呼ぶことを想定している。
+template<typename F>
+inline void sweepEmit(const EntityGroup &targets, float x, float y, float r, F f) {
+	for (size_t i = 0; i < targets.size(); ++i) {
+		const auto dx = x - targets.x[i];
+		const auto dy = y - targets.y[i];
+		const auto rr = r + targets.r[i];
+		if (dx * dx + dy * dy < rr * rr) {
+			f(i);
+		}
+	}
+}
+
+/// 掃引判定で物体queriers[q]と衝突している物体群targetsの物体のインデックスを順にfに渡す関数
+template<typename F>
+inline void sweepEmitSwept(const EntityGroup &targets, const EntityGroup &queriers, size_t q, F f) {
+	for (size_t i = 0; i < targets.size(); ++i) {
+		if (countSweptHits(targets, i, i + 1, queriers.px[q], queriers.py[q], queriers.x[q], queriers.y[q], queriers.r[q]) != 0) {
+			f(i);
+		}
+	}
+}
@@ -0,0 +1,499 @@
+#pragma once
+
+#include "bitmap.hpp"
+#include "distance.hpp"
+#include "resolution.hpp"
+#include "world.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// 衝突判定ビットマップの区画の一辺の画素数のlog2
+///
+/// 画面と同じ大きさのワールドは、等倍ならば一つの区画に収まる。
+constexpr int BITMAP_TILE_SHIFT = 11;
+constexpr int BITMAP_TILE_SIZE = 1 << BITMAP_TILE_SHIFT;
+
+/// ワールド全体を覆う衝突判定ビットマップ
+///
+/// ワールドをBITMAP_TILE_SIZE四方の画素の区画に分け、区画ごとにSoftwareBitmapを持つ。
+/// 区画は物体の覆いうる範囲がかかったときに初めて確保し、1フレームの間どの物体群も描画しなかった区画はprepare()で解放する。
+/// そのため大きなワールドでも、メモリと消去・描画・照合の時間とは物体のいる区画の数に比例する。
+/// 区画の境界をまたぐ図形は、かかる区画すべてに描画・照合する。画素の格子はワールド全体で共通なので、結果は一枚のビットマップと同じ。
+/// ただし区画の中では座標が小さくなるため、ワールドの遠くでは丸め誤差が減り、図形の境界上の画素がわずかに異なることがある。
+/// ワールドが一つの区画に収まるならばその区画を常に持ち、物体ごとに区画を探さずにそのまま描画・照合する。
+///
+/// NOTE: 形は外接する円に収まるため、区画は円(掃引判定ならばカプセル)を囲む範囲で探す。
+class TiledBitmap final {
+private:
+	/// 図形を囲む範囲に加える余白(画素)
+	///
+	/// しきい値・保守的な規則で図形が太る分を含む。
+	static constexpr float TILE_MARGIN = 1.0f;
+
+	/// 距離場の状態
+	enum DistanceState: uint8_t {
+		/// まだ求めていない
+		DISTANCE_STALE,
+		/// 求めてある
+		DISTANCE_READY,
+		/// 範囲に物体群の画素がない
+		DISTANCE_EMPTY,
+	};
+
+	const float _scale;
+	const int _width;
+	const int _height;
+	const int _tilesX;
+	const int _tilesY;
+	const unsigned int _groupCount;
+	std::vector<std::unique_ptr<SoftwareBitmap>> _tiles;
+	/// 区画ごと・物体群ごとの、前回消してから描画したかの印
+	///
+	/// 物体群ごとに別々のバイトに書くため、物体群ごとの描画を並列に行える。
+	std::vector<uint8_t> _drawn;
+	std::vector<std::unique_ptr<DistanceField>> _distances;
+	std::vector<DistanceState> _distanceStates;
+	unsigned int _distanceGroup;
+	int _apron;
+	const DiskFootprints *_footprints;
+	Coverage _coverage;
+
+	inline size_t getTileIndex(int tx, int ty) const {
+		return static_cast<size_t>(ty) * _tilesX + tx;
+	}
+
+	/// 区画(tx, ty)の左上の画素と大きさとを求める関数
+	inline void getTileRect(int tx, int ty, int &x, int &y, int &width, int &height) const {
+		x = tx << BITMAP_TILE_SHIFT;
+		y = ty << BITMAP_TILE_SHIFT;
+		width = std::min(BITMAP_TILE_SIZE, _width - x);
+		height = std::min(BITMAP_TILE_SIZE, _height - y);
+	}
+
+	/// 区画(tx, ty)を、なければ確保して返す関数
+	///
+	/// WARN: 複数のスレッドから同時に呼ばないこと。
+	SoftwareBitmap &allocate(int tx, int ty) {
+		auto &tile = _tiles[getTileIndex(tx, ty)];
+		if (!tile) {
+			int x, y, width, height;
+			getTileRect(tx, ty, x, y, width, height);
+			tile = std::make_unique<SoftwareBitmap>(width, height, _groupCount, _scale, x, y);
+			tile->setFootprints(_footprints);
+			tile->setCoverage(_coverage);
+		}
+		return *tile;
+	}
+
+	/// 区画tにmaskの物体群のどれかが描画されているか
+	inline bool isDrawn(size_t t, uint32_t mask) const {
+		const auto *drawn = &_drawn[t * _groupCount];
+		for (auto bits = mask; bits != 0; bits &= bits - 1) {
+			if (drawn[std::countr_zero(bits)]) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// ワールドの座標の範囲[x0, x1] x [y0, y1]にかかる区画を(tx, ty, 区画の番号)としてfに渡す関数
+	template<typename F>
+	inline void forEachTileIn(float x0, float y0, float x1, float y1, F f) const {
+		const auto toTile = [this](float v, int count) {
+			const auto p = std::clamp(v * _scale, -TILE_MARGIN, static_cast<float>(count << BITMAP_TILE_SHIFT));
+			return std::clamp(static_cast<int>(std::floor(p)) >> BITMAP_TILE_SHIFT, 0, count - 1);
+		};
+		const auto tx0 = toTile(x0 - TILE_MARGIN / _scale, _tilesX);
+		const auto tx1 = toTile(x1 + TILE_MARGIN / _scale, _tilesX);
+		const auto ty0 = toTile(y0 - TILE_MARGIN / _scale, _tilesY);
+		const auto ty1 = toTile(y1 + TILE_MARGIN / _scale, _tilesY);
+		for (auto ty = ty0; ty <= ty1; ++ty) {
+			for (auto tx = tx0; tx <= tx1; ++tx) {
+				f(tx, ty, getTileIndex(tx, ty));
+			}
+		}
+	}
+
+	/// 物体群groupの面の、範囲[x0, x1] x [y0, y1]にかかる区画にdraw(区画)で描画する関数
+	template<typename F>
+	inline void drawTiles(unsigned int group, float x0, float y0, float x1, float y1, F draw) {
+		if (_tiles.size() == 1) {
+			_drawn[group] = 1;
+			draw(*_tiles[0]);
+			return;
+		}
+		forEachTileIn(x0, y0, x1, y1, [&](int tx, int ty, size_t t) {
+			draw(allocate(tx, ty));
+			_drawn[t * _groupCount + group] = 1;
+		});
+	}
+
+	/// 範囲[x0, x1] x [y0, y1]にかかる区画のうちmaskの物体群が描画されている区画で、overlap(区画, 残りのmask)の結果を合わせる関数
+	///
+	/// maskのビットがすべて見つかった時点で打ち切る。
+	template<typename F>
+	inline uint32_t overlapTiles(uint32_t mask, float x0, float y0, float x1, float y1, F overlap) const {
+		if (_tiles.size() == 1) {
+			return overlap(*_tiles[0], mask);
+		}
+		uint32_t found = 0;
+		forEachTileIn(x0, y0, x1, y1, [&](int, int, size_t t) {
+			const auto remaining = mask & ~found;
+			if (remaining != 0 && _tiles[t] && isDrawn(t, remaining)) {
+				found |= overlap(*_tiles[t], remaining);
+			}
+		});
+		return found;
+	}
+
+	/// 区画tの距離場を、区画の周りに_apron画素だけ広げた範囲で求める関数
+	///
+	/// 範囲の左上の画素を(x0, y0)に書き込む。範囲に物体群の画素がなければnullptrを返す。
+	const DistanceField *getDistance(int tx, int ty, int &x0, int &y0) {
+		int x, y, width, height;
+		getTileRect(tx, ty, x, y, width, height);
+		x0 = std::max(x - _apron, 0);
+		y0 = std::max(y - _apron, 0);
+		const auto x1 = std::min(x + width + _apron, _width);
+		const auto y1 = std::min(y + height + _apron, _height);
+		const auto t = getTileIndex(tx, ty);
+		if (_distanceStates[t] == DISTANCE_STALE) {
+			auto empty = true;
+			const auto groupBit = 1u << _distanceGroup;
+			forEachTileIn(
+				static_cast<float>(x0) / _scale,
+				static_cast<float>(y0) / _scale,
+				static_cast<float>(x1 - 1) / _scale,
+				static_cast<float>(y1 - 1) / _scale,
+				[&](int, int, size_t n) { empty = empty && !(_tiles[n] && isDrawn(n, groupBit)); }
+			);
+			_distanceStates[t] = empty ? DISTANCE_EMPTY : DISTANCE_READY;
+			if (!empty) {
+				auto &distance = _distances[t];
+				if (!distance) {
+					distance = std::make_unique<DistanceField>(x1 - x0, y1 - y0);
+				}
+				if (x0 == x && y0 == y && x1 == x + width && y1 == y + height) {
+					distance->build(*_tiles[t], _distanceGroup);
+				} else {
+					// 範囲の画素を、それを含む区画の面から読む
+					distance->build([&](int px, int py) {
+						const auto gx = x0 + px;
+						const auto gy = y0 + py;
+						const auto &tile = _tiles[getTileIndex(gx >> BITMAP_TILE_SHIFT, gy >> BITMAP_TILE_SHIFT)];
+						if (!tile) {
+							return false;
+						}
+						const auto lx = gx - tile->getOriginX();
+						return ((tile->getRow(_distanceGroup, gy - tile->getOriginY())[lx / 64] >> (lx % 64)) & 1) != 0;
+					});
+				}
+			}
+		}
+		return _distanceStates[t] == DISTANCE_READY ? _distances[t].get() : nullptr;
+	}
+
+public:
+	/// ワールドworldを、ワールドの1単位をscale画素として覆うビットマップを作る
+	explicit TiledBitmap(const WorldBounds &world, unsigned int groupCount, float scale = 1.0f):
+		_scale(scale),
+		_width(toBitmapSize(world.width, scale)),
+		_height(toBitmapSize(world.height, scale)),
+		_tilesX((_width + BITMAP_TILE_SIZE - 1) >> BITMAP_TILE_SHIFT),
+		_tilesY((_height + BITMAP_TILE_SIZE - 1) >> BITMAP_TILE_SHIFT),
+		_groupCount(groupCount),
+		_tiles(static_cast<size_t>(_tilesX) * _tilesY),
+		_drawn(_tiles.size() * groupCount, 0),
+		_distances(_tiles.size()),
+		_distanceStates(_tiles.size(), DISTANCE_STALE),
+		_distanceGroup(0),
+		_apron(0),
+		_footprints(nullptr),
+		_coverage(Coverage::center())
+	{
+		if (_tiles.size() == 1) {
+			allocate(0, 0);
+		}
+	}
+	TiledBitmap() = delete;
+	TiledBitmap(const TiledBitmap &) = delete;
+	TiledBitmap(const TiledBitmap &&) = delete;
+	TiledBitmap &operator=(const TiledBitmap &) = delete;
+	TiledBitmap &&operator=(const TiledBitmap &&) = delete;
+	~TiledBitmap() = default;
+
+	/// ワールド全体を覆う画素数
+	inline int getWidth() const {
+		return _width;
+	}
+	inline int getHeight() const {
+		return _height;
+	}
+	inline float getScale() const {
+		return _scale;
+	}
+	inline unsigned int getGroupCount() const {
+		return _groupCount;
+	}
+	/// ワールド全体の区画の数
+	inline size_t getTileCount() const {
+		return _tiles.size();
+	}
+	/// 確保している区画の数
+	inline size_t getAllocatedTileCount() const {
+		return static_cast<size_t>(std::count_if(_tiles.begin(), _tiles.end(), [](const auto &n) { return n != nullptr; }));
+	}
+	/// 確保している区画の面の合計のバイト数
+	inline size_t getAllocatedBytes() const {
+		size_t bytes = 0;
+		for (const auto &n: _tiles) {
+			if (n) {
+				bytes += n->getWordsPerRow() * sizeof(uint64_t) * n->getHeight() * _groupCount;
+			}
+		}
+		return bytes;
+	}
+
+	/// 区画(tx, ty)のビットマップ
+	///
+	/// 確保されていなければnullptrを返す。
+	inline const SoftwareBitmap *getTile(int tx, int ty) const {
+		return _tiles[getTileIndex(tx, ty)].get();
+	}
+
+	/// 円の描画と照合とに用いる足跡の表を設定する関数 (SoftwareBitmap::setFootprints()を参照)
+	inline void setFootprints(const DiskFootprints *footprints) {
+		_footprints = footprints;
+		for (auto &n: _tiles) {
+			if (n) {
+				n->setFootprints(footprints);
+			}
+		}
+	}
+
+	/// 描画と照合とで画素を覆っているとみなす規則を設定する関数 (SoftwareBitmap::setCoverage()を参照)
+	inline void setCoverage(const Coverage &coverage) {
+		_coverage = coverage;
+		for (auto &n: _tiles) {
+			if (n) {
+				n->setCoverage(coverage);
+			}
+		}
+	}
+
+	/// groupsのうちmaskの物体群の物体が覆いうる区画を確保し、前回のprepare()の後にどの物体群も描画しなかった区画を解放する関数
+	///
+	/// 描画しなかった区画は前回消した後の空の状態なので、そのまま捨てられる。
+	/// 掃引判定(swept)ならば直前の位置からの移動全体を含める。
+	/// WARN: 物体群ごとの描画を並列に行うならば、その前に呼んで区画を確保しておくこと。
+	void prepare(const std::vector<EntityGroup> &groups, bool swept, uint32_t mask = ~0u) {
+		if (_tiles.size() == 1) {
+			return;
+		}
+		for (size_t t = 0; t < _tiles.size(); ++t) {
+			const auto *drawn = &_drawn[t * _groupCount];
+			if (_tiles[t] && std::none_of(drawn, drawn + _groupCount, [](uint8_t n) { return n != 0; })) {
+				_tiles[t].reset();
+				_distances[t].reset();
+			}
+		}
+		for (unsigned int g = 0; g < groups.size(); ++g) {
+			if (((mask >> g) & 1) == 0) {
+				continue;
+			}
+			const auto &group = groups[g];
+			for (size_t i = 0; i < group.size(); ++i) {
+				auto x0 = group.x[i];
+				auto y0 = group.y[i];
+				auto x1 = x0;
+				auto y1 = y0;
+				if (swept) {
+					x0 = std::min(x0, group.px[i]);
+					y0 = std::min(y0, group.py[i]);
+					x1 = std::max(x1, group.px[i]);
+					y1 = std::max(y1, group.py[i]);
+				}
+				const auto r = group.r[i];
+				forEachTileIn(x0 - r, y0 - r, x1 + r, y1 + r, [&](int tx, int ty, size_t) { allocate(tx, ty); });
+			}
+		}
+	}
+
+	/// 描画した区画の面をすべて消す関数
+	inline void clear() {
+		for (unsigned int g = 0; g < _groupCount; ++g) {
+			clear(g);
+		}
+	}
+	/// 物体群groupの面のうち、描画した区画の面だけを消す関数
+	///
+	/// 物体群ごとに別々の面と印とを書き換えるため、物体群ごとに並列に呼べる。
+	inline void clear(unsigned int group) {
+		for (size_t t = 0; t < _tiles.size(); ++t) {
+			auto &drawn = _drawn[t * _groupCount + group];
+			if (drawn) {
+				_tiles[t]->clear(group);
+				drawn = 0;
+			}
+		}
+	}
+
+	/// 物体群groupの面に円(cx, cy, r)を描画する関数
+	inline void drawDisk(unsigned int group, float cx, float cy, float r) {
+		drawTiles(group, cx - r, cy - r, cx + r, cy + r, [&](SoftwareBitmap &tile) { tile.drawDisk(group, cx, cy, r); });
+	}
+
+	/// 物体群groupの面に線分(ax, ay)-(bx, by)を半径rだけ太らせたカプセルを描画する関数
+	inline void drawCapsule(unsigned int group, float ax, float ay, float bx, float by, float r) {
+		drawTiles(
+			group,
+			std::min(ax, bx) - r,
+			std::min(ay, by) - r,
+			std::max(ax, bx) + r,
+			std::max(ay, by) + r,
+			[&](SoftwareBitmap &tile) { tile.drawCapsule(group, ax, ay, bx, by, r); }
+		);
+	}
+
+	/// 物体群groupの面に、(cx, cy)に半径rで角度angleだけ回して置いたatlasの形shapeを描画する関数
+	inline void drawMask(unsigned int group, const MaskAtlas &atlas, uint32_t shape, float cx, float cy, float r, float angle = 0.0f) {
+		drawTiles(group, cx - r, cy - r, cx + r, cy + r, [&](SoftwareBitmap &tile) { tile.drawMask(group, atlas, shape, cx, cy, r, angle); });
+	}
+
+	/// 物体群groupのすべての物体を描画する関数 (SoftwareBitmap::drawGroup()を参照)
+	inline void drawGroup(unsigned int group, const EntityGroup &entities, const MaskAtlas *atlas = nullptr) {
+		if (_tiles.size() == 1) {
+			_drawn[group] = 1;
+			_tiles[0]->drawGroup(group, entities, atlas);
+			return;
+		}
+		for (size_t i = 0; i < entities.size(); ++i) {
+			if (atlas && entities.shape[i] != SHAPE_CIRCLE) {
+				drawMask(group, *atlas, entities.shape[i], entities.x[i], entities.y[i], entities.r[i], entities.angle[i]);
+			} else {
+				drawDisk(group, entities.x[i], entities.y[i], entities.r[i]);
+			}
+		}
+	}
+
+	/// 物体群groupのすべての物体を、直前の位置から現在の位置までのカプセルとして描画する関数
+	inline void drawGroupSwept(unsigned int group, const EntityGroup &entities) {
+		if (_tiles.size() == 1) {
+			_drawn[group] = 1;
+			_tiles[0]->drawGroupSwept(group, entities);
+			return;
+		}
+		for (size_t i = 0; i < entities.size(); ++i) {
+			drawCapsule(group, entities.px[i], entities.py[i], entities.x[i], entities.y[i], entities.r[i]);
+		}
+	}
+
+	/// 円(cx, cy, r)と重なっているmaskの物体群を調べる関数 (SoftwareBitmap::overlapDisk()を参照)
+	///
+	/// 確保されていない区画や、maskの物体群が描画されていない区画は調べない。
+	inline uint32_t overlapDisk(float cx, float cy, float r, uint32_t mask) const {
+		return overlapTiles(mask, cx - r, cy - r, cx + r, cy + r, [&](const SoftwareBitmap &tile, uint32_t m) {
+			return tile.overlapDisk(cx, cy, r, m);
+		});
+	}
+
+	/// (cx, cy)に半径rで角度angleだけ回して置いたatlasの形shapeと重なっているmaskの物体群を調べる関数
+	inline uint32_t overlapMask(const MaskAtlas &atlas, uint32_t shape, float cx, float cy, float r, float angle, uint32_t mask) const {
+		return overlapTiles(mask, cx - r, cy - r, cx + r, cy + r, [&](const SoftwareBitmap &tile, uint32_t m) {
+			return tile.overlapMask(atlas, shape, cx, cy, r, angle, m);
+		});
+	}
+
+	/// 線分(ax, ay)-(bx, by)を半径rだけ太らせたカプセルと重なっているmaskの物体群を調べる関数
+	inline uint32_t overlapCapsule(float ax, float ay, float bx, float by, float r, uint32_t mask) const {
+		return overlapTiles(
+			mask,
+			std::min(ax, bx) - r,
+			std::min(ay, by) - r,
+			std::max(ax, bx) + r,
+			std::max(ay, by) + r,
+			[&](const SoftwareBitmap &tile, uint32_t m) { return tile.overlapCapsule(ax, ay, bx, by, r, m); }
+		);
+	}
+
+	/// 確保している区画の粗い占有格子を作り直す関数
+	///
+	/// WARN: 描画した後、castRays()の前に呼ぶこと。
+	void updateOccupancy() {
+		for (auto &n: _tiles) {
+			if (n) {
+				n->updateOccupancy();
+			}
+		}
+	}
+
+	/// count本の光線raysが最初に通るmaskの物体群の画素までの距離を求める関数 (SoftwareBitmap::castRays()を参照)
+	///
+	/// 光線の通りうる区画のうち、maskの物体群が描画されている区画だけを辿り、区画ごとの距離の最小をとる。
+	/// WARN: updateOccupancy()で占有格子を作り直しておくこと。
+	void castRays(const Ray *rays, size_t count, uint32_t mask, float *distances) const {
+		if (_tiles.size() == 1) {
+			_tiles[0]->castRays(rays, count, mask, distances);
+			return;
+		}
+		std::array<float, MAX_GROUP_COUNT> scratch;
+		for (size_t q = 0; q < count; ++q) {
+			const auto &ray = rays[q];
+			auto *results = distances + q * _groupCount;
+			for (auto bits = mask; bits != 0; bits &= bits - 1) {
+				results[std::countr_zero(bits)] = HUGE_VALF;
+			}
+			const auto ex = ray.x + ray.dx * ray.length;
+			const auto ey = ray.y + ray.dy * ray.length;
+			forEachTileIn(std::min(ray.x, ex), std::min(ray.y, ey), std::max(ray.x, ex), std::max(ray.y, ey), [&](int, int, size_t t) {
+				if (!_tiles[t] || !isDrawn(t, mask)) {
+					return;
+				}
+				_tiles[t]->castRays(&ray, 1, mask, scratch.data());
+				for (auto bits = mask; bits != 0; bits &= bits - 1) {
+					const auto g = std::countr_zero(bits);
+					results[g] = std::min(results[g], scratch[g]);
+				}
+			});
+		}
+	}
+
+	/// 物体群groupの面から、classify()で参照する距離場を求め直すよう設定する関数
+	///
+	/// 距離場は区画ごとに、区画の周りにapron画素だけ広げた範囲で求める。classify()で調べる円の半径と余白との和(画素)が
+	/// apron以下ならば、区画の境界の近くでも一枚のビットマップで求めた場合と同じ判定になる。
+	/// 距離場は円の中心を含む区画について、初めて参照するときに求める。
+	/// WARN: 描画した後に呼ぶこと。
+	void buildDistance(unsigned int group, int apron) {
+		if (apron != _apron) {
+			for (auto &n: _distances) {
+				n.reset();
+			}
+			_apron = apron;
+		}
+		_distanceGroup = group;
+		std::fill(_distanceStates.begin(), _distanceStates.end(), DISTANCE_STALE);
+	}
+
+	/// 円(x, y, r)が、buildDistance()で設定した物体群の画素とどれだけ近いかを判定する関数 (DistanceField::classify()を参照)
+	///
+	/// 座標と長さとはワールドで表す。
+	Proximity classify(float x, float y, float r, float margin) {
+		const auto px = x * _scale;
+		const auto py = y * _scale;
+		const auto tx = std::clamp(static_cast<int>(std::floor(px)) >> BITMAP_TILE_SHIFT, 0, _tilesX - 1);
+		const auto ty = std::clamp(static_cast<int>(std::floor(py)) >> BITMAP_TILE_SHIFT, 0, _tilesY - 1);
+		int x0, y0;
+		const auto *distance = getDistance(tx, ty, x0, y0);
+		if (!distance) {
+			return Proximity::Clear;
+		}
+		return distance->classify(px - static_cast<float>(x0), py - static_cast<float>(y0), r * _scale, margin * _scale);
+	}
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "constant.hpp"
+
+#include <charconv>
+#include <string_view>
+
+/// ワールドの大きさ
+///
+/// 物体は[0, width] x [0, height]の中を動き、端で跳ね返る。画面の大きさ(WIDTH x HEIGHT)とは独立に実行時に決める。
+struct WorldBounds {
+	float width;
+	float height;
+
+	/// 画面と同じ大きさのワールド (既定)
+	static constexpr WorldBounds screen() {
+		return WorldBounds{WIDTH_FLOAT, HEIGHT_FLOAT};
+	}
+};
+
+/// 大きさを省略して作るシーンのワールドの大きさを保持する変数
+inline WorldBounds &getDefaultWorldSlot() {
+	static WorldBounds world = WorldBounds::screen();
+	return world;
+}
+
+/// 大きさを省略して作るシーンのワールドの大きさを設定する関数
+///
+/// 計測の`--world`で設定する。既定は画面と同じ大きさ。
+inline void setDefaultWorld(const WorldBounds &world) {
+	if (world.width <= 0.0f || world.height <= 0.0f) {
+		throw "the world must have a positive size.";
+	}
+	getDefaultWorldSlot() = world;
+}
+
+inline const WorldBounds &getDefaultWorld() {
+	return getDefaultWorldSlot();
+}
+
+/// "WxH"の形の文字列(例: "4096x4096")をワールドの大きさとして読む関数
+inline WorldBounds parseWorld(std::string_view text) {
+	const auto separator = text.find('x');
+	if (separator == std::string_view::npos) {
+		throw "the world must be given as WxH.";
+	}
+	WorldBounds world{0.0f, 0.0f};
+	const auto parse = [](std::string_view n, float &value) {
+		const auto [end, error] = std::from_chars(n.data(), n.data() + n.size(), value);
+		if (error != std::errc() || end != n.data() + n.size()) {
+			throw "the world must be given as WxH.";
+		}
+	};
+	parse(text.substr(0, separator), world.width);
+	parse(text.substr(separator + 1), world.height);
+	if (world.width <= 0.0f || world.height <= 0.0f) {
+		throw "the world must have a positive size.";
+	}
+	return world;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+/// 計測で用いる物体数
+constexpr std::array<size_t, 7> ENTITY_COUNTS{100, 500, 1000, 2000, 3000, 4000, 5000};
+
+/// 総当たりで衝突判定を行う計測
+void benchCollision();
+
+/// 衝突ペアの書き出しにかかる時間の計測
+void benchContacts();
+
+/// 複数の物体群と相互作用行列とを用いたゲーム風のシーンの計測
+void benchGroups();
+
+/// 少数の自機と多数の弾との衝突判定の計測
+void benchAsymmetric();
+
+/// 距離場を用いたかすり判定の計測
+void benchGraze();
+
+/// 移動の途中での衝突も判定する掃引判定の計測
+void benchSwept();
+
+/// 半径がまちまちなシーンでの動的AABB木の計測
+void benchAabbTree();
+
+/// 物体数の多いシーンでのLBVHの計測
+void benchLbvh();
+
+/// 基数ソートとstd::sortとの比較
+void benchRadixSort();
+
+/// 物体の並びを空間充填曲線の順に入れ替えたときの計測
+void benchReorder();
+
+/// ジョブシステムで並列に処理したときの計測
+void benchJobs();
+
+/// 移動・描画・問い合わせを1フレームずつずらして同時に行うパイプライン実行の計測
+void benchPipeline();
+
+/// 多数の小さなワールドを一つの領域にまとめて進めたときの計測
+void benchWorlds();
+
+/// 巻き戻しのための状態の保存・復元と、8フレームの進め直しの計測
+void benchRollback();
+
+/// 固定小数点数による決定的なシミュレーションの計測と、チェックサムによる一致の確認
+void benchFixed();
+
+/// 箱・円・点・k近傍の一括問い合わせの計測
+void benchQueries();
+
+/// 衝突判定ビットマップへの一括の光線判定の計測(1秒あたりの光線の数)
+void benchRays();
+
+/// 円以外の形(米粒・星・レーザー)を混ぜたときのビットマップでの判定の計測
+void benchMasks();
+
+/// 回した形と回さない形とのソフトウェアでの描画の計測
+void benchRotation();
+
+/// 円の足跡の表による描画・照合と、行ごとに解析的に求める方法との比較
+void benchFootprints();
+
+/// 画素の覆い方の規則(中心・しきい値・保守的)ごとの、描画・照合の時間と衝突数の偏りの計測
+void benchCoverage();
+
+/// 衝突判定ビットマップの解像度ごとの、1フレームの時間と衝突フラグの誤りの計測
+void benchResolution();
+
+/// 大きなワールドを区画に分けたビットマップと、ワールド全体を覆う一枚のビットマップとの比較
+void benchLargeWorld();
+
+/// 区画を必要な所だけ確保する疎なビットマップと、密なビットマップとの比較
+void benchSparseBitmap();
+
+/// 関心点の近くだけを詳細に判定する、詳細度つきの衝突判定の計測
+void benchLod();
@@ -0,0 +1,72 @@
+#include "../bench.hpp"
+
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+
+namespace {
+	constexpr std::array<size_t, 4> TREE_ENTITY_COUNTS{500, 1000, 2000, 5000};
+	constexpr int FRAME_COUNT_PER_RUN = 200;
+
+	struct RadiusRange {
+		const char *label;
+		float r;
+		float rMax;
+	};
+
+	/// 一様な半径と、1～200pxに散らばった半径
+	constexpr std::array<RadiusRange, 2> RADIUS_RANGES{
+		RadiusRange{"uniform", 5.0f, 0.0f},
+		RadiusRange{"mixed", 1.0f, 200.0f},
+	};
+
+	void run(const RadiusRange &range, size_t entityCount, Backend backend) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		Scene scene(
+			{
+				GroupDesc{entityCount,                  10.0f, range.r, 2.5f, range.rMax},
+				GroupDesc{entityCount, world.height - 10.0f, range.r, 2.5f, range.rMax},
+			},
+			matrix
+		);
+		scene.setBackend(backend);
+
+		size_t reinsertCount = 0;
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT_PER_RUN; ++i) {
+			scene.update();
+			reinsertCount += scene.getReinsertCount();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		std::cout
+			<< (backend == Backend::AabbTree ? "aabb-tree" : "brute-force")
+			<< " "
+			<< range.label
+			<< " "
+			<< entityCount
+			<< " "
+			<< elapsed
+			<< " "
+			<< scene.getHitCount();
+		if (const auto *tree = scene.getTree(0)) {
+			// 1フレームあたりに入れ直された物体の割合と、木の高さ
+			const auto total = static_cast<double>(scene.getEntityCount()) * FRAME_COUNT_PER_RUN;
+			std::cout << " " << static_cast<double>(reinsertCount) / total << " " << tree->getHeight();
+		}
+		std::cout << std::endl;
+	}
+}
+
+void benchAabbTree() {
+	for (const auto &range: RADIUS_RANGES) {
+		for (auto entityCount: TREE_ENTITY_COUNTS) {
+			run(range, entityCount, Backend::BruteForce);
+			run(range, entityCount, Backend::AabbTree);
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#include "../bench.hpp"
+
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+
+namespace {
+	constexpr size_t PLAYER_COUNT = 4;
+	constexpr std::array<size_t, 5> BULLET_COUNTS{10000, 25000, 50000, 100000, 200000};
+	constexpr int FRAME_COUNT_PER_RUN = 200;
+
+	/// interactがfalseならば衝突判定を行わず、移動のみの時間を計測する
+	void run(const char *label, size_t bulletCount, size_t sweepLimit, bool interact = true) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1, interact);
+		Scene scene(
+			{
+				GroupDesc{PLAYER_COUNT, world.height - 40.0f, 8.0f, 3.0f},
+				GroupDesc{bulletCount,  world.height / 2.0f,  4.0f, 2.5f},
+			},
+			matrix
+		);
+		scene.setSweepLimit(sweepLimit);
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT_PER_RUN; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		std::cout
+			<< label
+			<< " "
+			<< bulletCount
+			<< " "
+			<< elapsed
+			<< " "
+			<< elapsed * 1000.0 / static_cast<double>(FRAME_COUNT_PER_RUN)
+			<< " "
+			<< scene.getHitCount()
+			<< std::endl;
+	}
+}
+
+void benchAsymmetric() {
+	for (auto bulletCount: BULLET_COUNTS) {
+		run("update", bulletCount, 0, false);
+		run("symmetric", bulletCount, 0);
+		run("sweep", bulletCount, SWEEP_QUERIER_LIMIT);
+	}
+}
@@ -0,0 +1,28 @@
+#include "../bench.hpp"
+
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <iostream>
+
+void benchCollision() {
+	for (auto entityCount: ENTITY_COUNTS) {
+		Scene scene(entityCount);
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < 1000; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		std::cout
+			<< entityCount
+			<< " "
+			<< elapsed
+			<< " "
+			<< scene.getHitCount()
+			<< std::endl;
+
+		cooldown();
+	}
+}
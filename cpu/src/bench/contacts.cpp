@@ -0,0 +1,64 @@
+#include "../bench.hpp"
+
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+#include <vector>
+
+namespace {
+	/// 一フレームあたりの衝突ペアの容量
+	///
+	/// NOTE: 5000体でも数百ペア程度なので、溢れることはまずない。
+	constexpr size_t CONTACT_CAPACITY = 1 << 16;
+
+	/// 溢れを確認するための小さな容量
+	constexpr size_t SMALL_CONTACT_CAPACITY = 4;
+
+	void run(const char *label, size_t entityCount, ContactBuffer *contacts, HitBitset *hits) {
+		Scene scene(entityCount);
+		scene.setContactOutput(contacts, hits);
+
+		size_t pairCount = 0;
+		size_t overflowCount = 0;
+		const Stopwatch stopwatch;
+		for (int i = 0; i < 1000; ++i) {
+			scene.update();
+			if (contacts) {
+				pairCount += contacts->size();
+				overflowCount += contacts->getOverflowCount();
+			}
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		std::cout
+			<< label
+			<< " "
+			<< entityCount
+			<< " "
+			<< elapsed
+			<< " "
+			<< scene.getHitCount()
+			<< " "
+			<< pairCount
+			<< " "
+			<< overflowCount
+			<< std::endl;
+	}
+}
+
+void benchContacts() {
+	std::vector<ContactPair> pairs(CONTACT_CAPACITY);
+	for (auto entityCount: ENTITY_COUNTS) {
+		ContactBuffer contacts(pairs.data(), CONTACT_CAPACITY);
+		ContactBuffer smallContacts(pairs.data(), SMALL_CONTACT_CAPACITY);
+		std::array<HitBitset, 2> hits{HitBitset(entityCount), HitBitset(entityCount)};
+
+		run("count", entityCount, nullptr, nullptr);
+		run("pairs", entityCount, &contacts, nullptr);
+		run("flags", entityCount, nullptr, hits.data());
+		run("pairs+flags", entityCount, &contacts, hits.data());
+		run("overflow", entityCount, &smallContacts, nullptr);
+	}
+}
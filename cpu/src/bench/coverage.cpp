@@ -0,0 +1,182 @@
+#include "../bench.hpp"
+
+#include "../../../common/bitmap.hpp"
+#include "../../../common/coverage.hpp"
+#include "../../../common/mask.hpp"
+#include "../../../common/resolution.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../../../common/world.hpp"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace {
+	/// 1フレームに描画・照合する物体の数
+	constexpr size_t QUERIER_COUNT = 20000;
+
+	/// 照合の相手として描画する物体の数
+	constexpr size_t TARGET_COUNT = 400;
+
+	/// 物体の半径
+	constexpr std::array<float, 2> COVERAGE_RADII{2.5f, 10.0f};
+
+	/// 基準の重なりを求めるときの、画素あたりの細かさ
+	///
+	/// 中心の規則で8倍の解像度に描画して照合し、連続な図形どうしの重なりとみなす。
+	constexpr int REFERENCE_SCALE = 8;
+
+	constexpr int FRAME_COUNT = 20;
+
+	/// 比べる規則
+	constexpr std::array<std::pair<const char *, Coverage>, 5> POLICIES{
+		std::pair{"center", Coverage::center()},
+		std::pair{"threshold-0.01", Coverage::hard(0.01f)},
+		std::pair{"threshold-0.25", Coverage::hard(0.25f)},
+		std::pair{"threshold-0.75", Coverage::hard(0.75f)},
+		std::pair{"conservative", Coverage::conservative()},
+	};
+
+	struct Sprite {
+		float x;
+		float y;
+		float angle;
+	};
+
+	/// 物体の形
+	///
+	/// 円はSoftwareBitmap::drawDisk()で解析的に、星は形のアトラスから回して描画する。
+	struct Shape {
+		const char *name;
+		const MaskAtlas *atlas;
+		uint32_t shape;
+	};
+
+	void draw(SoftwareBitmap &bitmap, unsigned int group, const Shape &shape, const Sprite &n, float r, float scale) {
+		if (shape.atlas) {
+			bitmap.drawMask(group, *shape.atlas, shape.shape, n.x * scale, n.y * scale, r * scale, n.angle);
+		} else {
+			bitmap.drawDisk(group, n.x * scale, n.y * scale, r * scale);
+		}
+	}
+	uint32_t overlap(const SoftwareBitmap &bitmap, const Shape &shape, const Sprite &n, float r, float scale, uint32_t mask) {
+		if (shape.atlas) {
+			return bitmap.overlapMask(*shape.atlas, shape.shape, n.x * scale, n.y * scale, r * scale, n.angle, mask);
+		}
+		return bitmap.overlapDisk(n.x * scale, n.y * scale, r * scale, mask);
+	}
+
+	/// 相手と重なっている物体の数を、細かい解像度のビットマップで求める
+	size_t countReference(const Shape &shape, float r, const std::vector<Sprite> &queriers, const std::vector<Sprite> &targets) {
+		constexpr auto scale = static_cast<float>(REFERENCE_SCALE);
+		const auto &world = getDefaultWorld();
+		SoftwareBitmap bitmap(toBitmapSize(world.width, scale), toBitmapSize(world.height, scale), 1);
+		for (const auto &n: targets) {
+			draw(bitmap, 0, shape, n, r, scale);
+		}
+		size_t hits = 0;
+		for (const auto &n: queriers) {
+			hits += overlap(bitmap, shape, n, r, scale, 0b1) != 0;
+		}
+		return hits;
+	}
+
+	/// 規則coverageで、物体を描画する時間・照合する時間(1物体あたりのナノ秒)・覆った画素の数・重なっている物体の数と、
+	/// 基準との重なっている物体の数の差の割合(%)を出力する
+	void run(
+		const Shape &shape,
+		float r,
+		const char *policy,
+		const Coverage &coverage,
+		const std::vector<Sprite> &queriers,
+		const std::vector<Sprite> &targets,
+		size_t reference
+	) {
+		const auto &world = getDefaultWorld();
+		SoftwareBitmap bitmap(toBitmapSize(world.width, 1.0f), toBitmapSize(world.height, 1.0f), 2);
+		bitmap.setCoverage(coverage);
+
+		const Stopwatch drawStopwatch;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			bitmap.clear(0);
+			for (const auto &n: queriers) {
+				draw(bitmap, 0, shape, n, r, 1.0f);
+			}
+		}
+		const auto drawElapsed = drawStopwatch.elapsedMs();
+
+		// 覆った画素の数は、重ならない程度に少ない相手の面で数える
+		for (const auto &n: targets) {
+			draw(bitmap, 1, shape, n, r, 1.0f);
+		}
+		size_t pixels = 0;
+		for (int y = 0; y < bitmap.getHeight(); ++y) {
+			for (size_t w = 0; w < bitmap.getWordsPerRow(); ++w) {
+				pixels += std::popcount(bitmap.getRow(1, y)[w]);
+			}
+		}
+
+		const Stopwatch overlapStopwatch;
+		size_t hits = 0;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			hits = 0;
+			for (const auto &n: queriers) {
+				hits += overlap(bitmap, shape, n, r, 1.0f, 0b10) != 0;
+			}
+		}
+		const auto overlapElapsed = overlapStopwatch.elapsedMs();
+
+		const auto perSprite = 1000000.0 / (static_cast<double>(FRAME_COUNT) * QUERIER_COUNT);
+		std::cout
+			<< shape.name
+			<< " "
+			<< r
+			<< " "
+			<< policy
+			<< " "
+			<< drawElapsed * perSprite
+			<< " "
+			<< overlapElapsed * perSprite
+			<< " "
+			<< pixels
+			<< " "
+			<< hits
+			<< " "
+			<< (static_cast<double>(hits) - static_cast<double>(reference)) * 100.0 / static_cast<double>(reference)
+			<< std::endl;
+	}
+}
+
+void benchCoverage() {
+	MaskAtlas atlas;
+	const std::array<Shape, 2> shapes{
+		Shape{"disk", nullptr, SHAPE_CIRCLE},
+		Shape{"star", &atlas, atlas.add(STAR_MASK)},
+	};
+
+	// 位置はワールド全体に低食い違い列で散らばらせ、角度は黄金角ずつ変える
+	const auto &world = getDefaultWorld();
+	std::vector<Sprite> queriers(QUERIER_COUNT);
+	std::vector<Sprite> targets(TARGET_COUNT);
+	for (size_t i = 0; i < queriers.size(); ++i) {
+		const auto fi = static_cast<float>(i);
+		queriers[i] = Sprite{world.width * std::fmod(fi * 0.618034f, 1.0f), world.height * std::fmod(fi * 0.754878f, 1.0f), fi * 2.399963f};
+	}
+	for (size_t i = 0; i < targets.size(); ++i) {
+		const auto fi = static_cast<float>(i);
+		targets[i] = Sprite{world.width * std::fmod(fi * 0.569840f + 0.3f, 1.0f), world.height * std::fmod(fi * 0.324718f + 0.7f, 1.0f), fi * 1.3f};
+	}
+
+	for (const auto &shape: shapes) {
+		for (auto r: COVERAGE_RADII) {
+			const auto reference = countReference(shape, r, queriers, targets);
+			std::cout << "reference " << shape.name << " " << r << " " << reference << std::endl;
+			for (const auto &[policy, coverage]: POLICIES) {
+				run(shape, r, policy, coverage, queriers, targets, reference);
+			}
+		}
+	}
+}
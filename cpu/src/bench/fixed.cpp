@@ -0,0 +1,104 @@
+#include "../bench.hpp"
+
+#include "../../../common/jobsystem.hpp"
+#include "../../../common/parallel.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../fixedscene.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+
+namespace {
+	constexpr std::array<size_t, 3> FIXED_ENTITY_COUNTS{1000, 2000, 5000};
+
+	/// チェックサムを求めるシーンの進めるフレーム数
+	constexpr int CHECKSUM_FRAMES = 1000;
+
+	/// チェックサムを求めるシーンの、期待する累計の衝突数とチェックサム
+	///
+	/// どのコンパイラ・最適化の設定・ISAでビルドしてもこの値になること。一致しなければ例外を投げ、計測は失敗で終わる。
+	/// 値は画面と同じ大きさのワールドでのものなので、`--world`によらず画面の大きさで求める。
+	constexpr unsigned long long EXPECTED_HIT_COUNT = 2212832;
+	constexpr uint64_t EXPECTED_CHECKSUM = 0x5e63d00dfd770a4aull;
+
+	/// 上端の物体群と、半径と縦の位置とが散らばり自身とも衝突判定を行う下端の物体群
+	std::vector<GroupDesc> createChecksumGroups() {
+		return {
+			GroupDesc{1000,                10.0f, 5.0f, 2.5f},
+			GroupDesc{1000, HEIGHT_FLOAT - 10.0f, 5.0f, 2.5f, 20.0f, 200.0f},
+		};
+	}
+
+	InteractionMatrix createChecksumMatrix() {
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		matrix.set(1, 1);
+		return matrix;
+	}
+
+	void checksum(const char *name) {
+		FixedScene scene(createChecksumGroups(), createChecksumMatrix(), WorldBounds::screen());
+		for (int i = 0; i < CHECKSUM_FRAMES; ++i) {
+			scene.update();
+		}
+		const auto matches = scene.getHitCount() == EXPECTED_HIT_COUNT && scene.getChecksum() == EXPECTED_CHECKSUM;
+		std::cout
+			<< "checksum "
+			<< name
+			<< " "
+			<< scene.getHitCount()
+			<< " "
+			<< std::hex
+			<< scene.getChecksum()
+			<< std::dec
+			<< " "
+			<< (matches ? "ok" : "mismatch")
+			<< std::endl;
+		if (!matches) {
+			throw "the fixed-point checksum differs from the expected value.";
+		}
+	}
+}
+
+void benchFixed() {
+	const auto &world = getDefaultWorld();
+	// 固定小数点数で扱えない大きさのワールドならば、計測を始める前に例外を投げる
+	toFixedBounds(world);
+	for (auto entityCount: FIXED_ENTITY_COUNTS) {
+		const std::vector<GroupDesc> descs{
+			GroupDesc{entityCount,                10.0f, 5.0f, 2.5f},
+			GroupDesc{entityCount, world.height - 10.0f, 5.0f, 2.5f},
+		};
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+
+		Scene scene(descs, matrix);
+		Stopwatch stopwatch;
+		for (int i = 0; i < 1000; ++i) {
+			scene.update();
+		}
+		std::cout << "float " << entityCount << " " << stopwatch.elapsedMs() << " " << scene.getHitCount() << std::endl;
+
+		FixedScene fixed(descs, matrix);
+		stopwatch.reset();
+		for (int i = 0; i < 1000; ++i) {
+			fixed.update();
+		}
+		std::cout << "fixed " << entityCount << " " << stopwatch.elapsedMs() << " " << fixed.getHitCount() << std::endl;
+		cooldown();
+	}
+
+	// ジョブシステムの有無によらず、同じ値になることも確かめる
+	auto *outer = getJobSystem();
+	setJobSystem(nullptr);
+	checksum("serial");
+	{
+		JobSystem system(4);
+		setJobSystem(&system);
+		checksum("jobs");
+		setJobSystem(nullptr);
+	}
+	setJobSystem(outer);
+}
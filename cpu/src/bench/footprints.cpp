@@ -0,0 +1,228 @@
+#include "../bench.hpp"
+
+#include "../../../common/bitmap.hpp"
+#include "../../../common/footprint.hpp"
+#include "../../../common/resolution.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+	/// 1フレームに描画・照合する円の数
+	constexpr size_t DISK_COUNT = 20000;
+
+	/// 照合の相手として描画する円の数
+	constexpr size_t TARGET_COUNT = 200;
+
+	/// 円の半径
+	constexpr std::array<float, 3> DISK_RADII{2.5f, 10.0f, 30.0f};
+
+	/// シーン全体での計測の物体数
+	constexpr std::array<size_t, 2> SCENE_ENTITY_COUNTS{10000, 40000};
+
+	constexpr int FRAME_COUNT = 20;
+
+	struct Disk {
+		float x;
+		float y;
+	};
+
+	/// GPU版のisHit()と同じ、円周を中点円アルゴリズムで辿って調べる方法
+	uint32_t checkCircle(const SoftwareBitmap &bitmap, float x0f, float y0f, float rf, uint32_t mask) {
+		const int r = static_cast<int>(std::round(rf));
+		const int x0 = static_cast<int>(std::round(x0f));
+		const int y0 = static_cast<int>(std::round(y0f));
+		uint32_t found = 0;
+		int x = r;
+		int y = 0;
+		int f = -2 * r + 3;
+		while (x >= y) {
+			found |=
+				  bitmap.check(x0 + x, y0 + y, mask)
+				| bitmap.check(x0 - x, y0 + y, mask)
+				| bitmap.check(x0 + x, y0 - y, mask)
+				| bitmap.check(x0 - x, y0 - y, mask)
+				| bitmap.check(x0 + y, y0 + x, mask)
+				| bitmap.check(x0 - y, y0 + x, mask)
+				| bitmap.check(x0 + y, y0 - x, mask)
+				| bitmap.check(x0 - y, y0 - x, mask);
+			if (found == mask) {
+				return found;
+			}
+			if (f >= 0) {
+				x -= 1;
+				f -= 4 * x;
+			}
+			y += 1;
+			f += 4 * y + 2;
+		}
+		return found;
+	}
+
+	/// 足跡の縁の画素を辿って調べる方法
+	uint32_t checkRim(const SoftwareBitmap &bitmap, const DiskFootprints &footprints, float x0, float y0, float r, uint32_t mask) {
+		int x, y;
+		const auto *footprint = footprints.find(x0, y0, r, x, y);
+		const auto *rim = footprints.getRim(*footprint);
+		uint32_t found = 0;
+		for (uint32_t k = 0; k < footprint->rimCount; ++k) {
+			found |= bitmap.check(x + rim[k].x, y + rim[k].y, mask);
+			// 円の8つの部分を一巡りするごとに打ち切るか調べる
+			if ((k & 7) == 7 && found == mask) {
+				return found;
+			}
+		}
+		return found;
+	}
+
+	void print(const char *kind, const char *method, float r, double elapsed, size_t value) {
+		std::cout
+			<< kind
+			<< " "
+			<< method
+			<< " "
+			<< r
+			<< " "
+			<< elapsed * 1000000.0 / (static_cast<double>(FRAME_COUNT) * DISK_COUNT)
+			<< " "
+			<< value
+			<< std::endl;
+	}
+
+	/// 円を描画し、すでに描画した物体群の面と照合する
+	///
+	/// 描画では重ならない程度に少ない円を描画したときに覆った画素の数を、照合では見つかった物体群の数を出力する。
+	/// 描画の後には、解析的に求めた場合と食い違った画素の数も出力する。
+	void runDisks(const DiskFootprints &footprints, float r, const std::vector<Disk> &disks, const std::vector<Disk> &targets) {
+		const auto width = toBitmapSize(getDefaultWorld().width, 1.0f);
+		const auto height = toBitmapSize(getDefaultWorld().height, 1.0f);
+		SoftwareBitmap analytic(width, height, 2);
+		SoftwareBitmap cached(width, height, 2);
+		cached.setFootprints(&footprints);
+
+		std::array<double, 2> elapsed{};
+		for (auto *bitmap: {&analytic, &cached}) {
+			const Stopwatch stopwatch;
+			for (int i = 0; i < FRAME_COUNT; ++i) {
+				bitmap->clear(0);
+				for (const auto &n: disks) {
+					bitmap->drawDisk(0, n.x, n.y, r);
+				}
+			}
+			elapsed[bitmap == &cached] = stopwatch.elapsedMs();
+		}
+
+		// 照合の相手の面に描画した画素を数え、食い違いを調べる
+		std::array<size_t, 2> pixels{};
+		size_t diff = 0;
+		for (auto *bitmap: {&analytic, &cached}) {
+			bitmap->clear();
+			for (const auto &n: targets) {
+				bitmap->drawDisk(1, n.x, n.y, r);
+			}
+		}
+		for (int y = 0; y < analytic.getHeight(); ++y) {
+			for (size_t w = 0; w < analytic.getWordsPerRow(); ++w) {
+				pixels[0] += std::popcount(analytic.getRow(1, y)[w]);
+				pixels[1] += std::popcount(cached.getRow(1, y)[w]);
+				diff += std::popcount(analytic.getRow(1, y)[w] ^ cached.getRow(1, y)[w]);
+			}
+		}
+		print("draw", "analytic", r, elapsed[0], pixels[0]);
+		print("draw", "footprint", r, elapsed[1], pixels[1]);
+		std::cout << "draw-diff " << r << " " << diff << std::endl;
+
+		for (auto *bitmap: {&analytic, &cached}) {
+			const Stopwatch stopwatch;
+			size_t hits = 0;
+			for (int i = 0; i < FRAME_COUNT; ++i) {
+				for (const auto &n: disks) {
+					hits += std::popcount(bitmap->overlapDisk(n.x, n.y, r, 0b10));
+				}
+			}
+			print("overlap", bitmap == &cached ? "footprint" : "analytic", r, stopwatch.elapsedMs(), hits / FRAME_COUNT);
+		}
+		{
+			const Stopwatch stopwatch;
+			size_t hits = 0;
+			for (int i = 0; i < FRAME_COUNT; ++i) {
+				for (const auto &n: disks) {
+					hits += std::popcount(checkCircle(analytic, n.x, n.y, r, 0b10));
+				}
+			}
+			print("rim", "midpoint", r, stopwatch.elapsedMs(), hits / FRAME_COUNT);
+		}
+		{
+			const Stopwatch stopwatch;
+			size_t hits = 0;
+			for (int i = 0; i < FRAME_COUNT; ++i) {
+				for (const auto &n: disks) {
+					hits += std::popcount(checkRim(analytic, footprints, n.x, n.y, r, 0b10));
+				}
+			}
+			print("rim", "footprint", r, stopwatch.elapsedMs(), hits / FRAME_COUNT);
+		}
+	}
+
+	/// ビットマップで判定するシーン全体を、足跡の表の有無で比べる
+	void runScene(const DiskFootprints *footprints, size_t entityCount) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		Scene scene(
+			{
+				GroupDesc{entityCount / 2, 0.0f, 2.5f, 2.5f, 12.0f, world.height},
+				GroupDesc{entityCount / 2, 0.0f, 2.5f, 2.5f, 12.0f, world.height},
+			},
+			matrix
+		);
+		scene.setBackend(Backend::Bitmap);
+		scene.setFootprints(footprints);
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			scene.update();
+		}
+		std::cout
+			<< "scene "
+			<< (footprints ? "footprint" : "analytic")
+			<< " "
+			<< entityCount
+			<< " "
+			<< stopwatch.elapsedMs() / FRAME_COUNT
+			<< " "
+			<< scene.getHitCount()
+			<< std::endl;
+	}
+}
+
+void benchFootprints() {
+	const Stopwatch build;
+	const DiskFootprints footprints;
+	std::cout << "build " << build.elapsedMs() << " " << footprints.getBytes() << std::endl;
+
+	// 位置はワールド全体に低食い違い列で散らばらせる
+	const auto &world = getDefaultWorld();
+	std::vector<Disk> disks(DISK_COUNT);
+	std::vector<Disk> targets(TARGET_COUNT);
+	for (size_t i = 0; i < DISK_COUNT; ++i) {
+		const auto fi = static_cast<float>(i);
+		disks[i] = Disk{world.width * std::fmod(fi * 0.618034f, 1.0f), world.height * std::fmod(fi * 0.754878f, 1.0f)};
+	}
+	for (size_t i = 0; i < targets.size(); ++i) {
+		const auto fi = static_cast<float>(i);
+		targets[i] = Disk{world.width * std::fmod(fi * 0.569840f + 0.3f, 1.0f), world.height * std::fmod(fi * 0.324718f + 0.7f, 1.0f)};
+	}
+
+	for (auto r: DISK_RADII) {
+		runDisks(footprints, r, disks, targets);
+	}
+	for (auto entityCount: SCENE_ENTITY_COUNTS) {
+		runScene(nullptr, entityCount);
+		runScene(&footprints, entityCount);
+	}
+}
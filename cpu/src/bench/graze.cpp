@@ -0,0 +1,101 @@
+#include "../bench.hpp"
+
+#include "../../../common/resolution.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+
+namespace {
+	constexpr size_t PLAYER_COUNT = 4;
+	constexpr std::array<size_t, 3> BULLET_COUNTS{1000, 5000, 20000};
+	constexpr float GRAZE_MARGIN = 16.0f;
+	constexpr int FRAME_COUNT_PER_RUN = 200;
+
+	/// 距離場を用いずに、円どうしの距離からかすりの数を数える関数
+	unsigned long long countExactGrazes(const EntityGroup &queriers, const EntityGroup &targets, float margin) {
+		unsigned long long count = 0;
+		for (size_t q = 0; q < queriers.size(); ++q) {
+			auto nearest = HUGE_VALF;
+			for (size_t t = 0; t < targets.size(); ++t) {
+				const auto dx = queriers.x[q] - targets.x[t];
+				const auto dy = queriers.y[q] - targets.y[t];
+				nearest = std::min(nearest, std::sqrt(dx * dx + dy * dy) - queriers.r[q] - targets.r[t]);
+			}
+			if (nearest > 0.0f && nearest <= margin) {
+				count += 1;
+			}
+		}
+		return count;
+	}
+
+	void run(const char *label, size_t bulletCount, Backend backend) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		Scene scene(
+			{
+				GroupDesc{PLAYER_COUNT, world.height - 40.0f, 8.0f, 3.0f},
+				GroupDesc{bulletCount,  world.height / 2.0f,  4.0f, 2.5f},
+			},
+			matrix
+		);
+		scene.setBackend(backend);
+		scene.setGraze(GrazeDesc{0, 1, GRAZE_MARGIN});
+
+		// 距離場の計算だけにかかる時間を別に計測する
+		const auto width = toBitmapSize(world.width, 1.0f);
+		const auto height = toBitmapSize(world.height, 1.0f);
+		SoftwareBitmap bitmap(width, height, 2);
+		DistanceField distance(width, height);
+		double transformMs = 0.0;
+		unsigned long long exactGrazes = 0;
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT_PER_RUN; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		Scene replay(
+			{
+				GroupDesc{PLAYER_COUNT, world.height - 40.0f, 8.0f, 3.0f},
+				GroupDesc{bulletCount,  world.height / 2.0f,  4.0f, 2.5f},
+			},
+			InteractionMatrix()
+		);
+		for (int i = 0; i < FRAME_COUNT_PER_RUN; ++i) {
+			replay.update();
+			bitmap.clear();
+			bitmap.drawGroup(1, replay.getGroup(1));
+			const Stopwatch transform;
+			distance.build(bitmap, 1);
+			transformMs += transform.elapsedMs();
+			exactGrazes += countExactGrazes(replay.getGroup(0), replay.getGroup(1), GRAZE_MARGIN);
+		}
+
+		std::cout
+			<< label
+			<< " "
+			<< bulletCount
+			<< " "
+			<< elapsed
+			<< " "
+			<< transformMs / static_cast<double>(FRAME_COUNT_PER_RUN)
+			<< " "
+			<< scene.getHitCount()
+			<< " "
+			<< scene.getGrazeCount()
+			<< " "
+			<< exactGrazes
+			<< std::endl;
+	}
+}
+
+void benchGraze() {
+	for (auto bulletCount: BULLET_COUNTS) {
+		run("brute-force", bulletCount, Backend::BruteForce);
+		run("bitmap", bulletCount, Backend::Bitmap);
+	}
+}
@@ -0,0 +1,62 @@
+#include "../bench.hpp"
+
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <iostream>
+
+namespace {
+	enum Group: unsigned int {
+		PLAYER,
+		PLAYER_BULLET,
+		ENEMY,
+		ENEMY_BULLET,
+		ITEM,
+		TERRAIN,
+	};
+
+	InteractionMatrix createGameMatrix() {
+		InteractionMatrix matrix;
+		matrix.set(PLAYER, ENEMY);
+		matrix.set(PLAYER, ENEMY_BULLET);
+		matrix.set(PLAYER, ITEM);
+		matrix.set(PLAYER_BULLET, ENEMY);
+		matrix.set(PLAYER_BULLET, TERRAIN);
+		matrix.set(ENEMY_BULLET, TERRAIN);
+		return matrix;
+	}
+
+	/// 物体数がscaleに比例するゲーム風のシーンの物体群
+	std::vector<GroupDesc> createGameGroups(size_t scale) {
+		const auto &world = getDefaultWorld();
+		return {
+			GroupDesc{4,              world.height - 40.0f,  8.0f, 3.0f},
+			GroupDesc{scale,          world.height - 80.0f,  3.0f, 8.0f},
+			GroupDesc{scale / 20 + 1,                40.0f, 12.0f, 1.5f},
+			GroupDesc{scale * 2,                     80.0f,  4.0f, 2.5f},
+			GroupDesc{scale / 50 + 1,  world.height / 2.0f,  6.0f, 1.0f},
+			GroupDesc{16,              world.height / 3.0f, 30.0f, 0.0f},
+		};
+	}
+}
+
+void benchGroups() {
+	const auto matrix = createGameMatrix();
+	for (auto entityCount: ENTITY_COUNTS) {
+		Scene scene(createGameGroups(entityCount), matrix);
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < 1000; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		std::cout
+			<< scene.getEntityCount()
+			<< " "
+			<< elapsed
+			<< " "
+			<< scene.getHitCount()
+			<< std::endl;
+	}
+}
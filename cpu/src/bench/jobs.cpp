@@ -0,0 +1,94 @@
+#include "../bench.hpp"
+
+#include "../../../common/jobsystem.hpp"
+#include "../../../common/parallel.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace {
+	constexpr int FRAME_COUNT = 100;
+
+	struct Case {
+		std::string_view name;
+		Backend backend;
+		size_t entityCount;
+	};
+
+	constexpr std::array<Case, 3> CASES{
+		Case{"brute-force", Backend::BruteForce, 5000},
+		Case{"bitmap", Backend::Bitmap, 100000},
+		Case{"lbvh", Backend::Lbvh, 200000},
+	};
+
+	/// 三つの物体群のうち、0番と1番、1番と2番、2番どうしが相互作用するシーン
+	///
+	/// ビットマップでは2番どうしの判定は行われない。
+	void run(const Case &c, JobSystem *system) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		matrix.set(1, 2);
+		matrix.set(2, 2);
+		Scene scene(
+			{
+				GroupDesc{c.entityCount / 4, 0.0f, 2.0f, 2.5f, 0.0f, world.height},
+				GroupDesc{c.entityCount / 2, 0.0f, 1.0f, 4.0f, 0.0f, world.height},
+				GroupDesc{c.entityCount / 4, 0.0f, 3.0f, 1.5f, 0.0f, world.height},
+			},
+			matrix
+		);
+		scene.setBackend(c.backend);
+		setJobSystem(system);
+		if (system) {
+			system->resetStats();
+		}
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+		setJobSystem(nullptr);
+
+		std::cout
+			<< c.name
+			<< " "
+			<< c.entityCount
+			<< " "
+			<< (system ? system->getWorkerCount() : 0)
+			<< " "
+			<< elapsed / FRAME_COUNT
+			<< " "
+			<< scene.getHitCount();
+		if (system) {
+			for (const auto &n: system->getStats()) {
+				std::cout << " " << n.utilization;
+			}
+		}
+		std::cout << std::endl;
+	}
+}
+
+void benchJobs() {
+	// 呼び出し側が設定したジョブシステムは使わず、ワーカー数を変えて比べる
+	auto *outer = getJobSystem();
+	setJobSystem(nullptr);
+	std::vector<unsigned int> workerCounts;
+	for (unsigned int n = 1; n < getWorkerCount(); n *= 2) {
+		workerCounts.push_back(n);
+	}
+	workerCounts.push_back(getWorkerCount());
+	for (const auto &c: CASES) {
+		run(c, nullptr);
+		for (const auto n: workerCounts) {
+			JobSystem system(n);
+			run(c, &system);
+		}
+		cooldown();
+	}
+	setJobSystem(outer);
+}
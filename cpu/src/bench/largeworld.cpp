@@ -0,0 +1,118 @@
+#include "../bench.hpp"
+
+#include "../../../common/bitmap.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../../../common/tiledbitmap.hpp"
+#include "../../../common/world.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <bit>
+#include <iostream>
+#include <vector>
+
+namespace {
+	/// 二つの物体群を合わせた物体数
+	constexpr size_t LARGE_WORLD_ENTITY_COUNT = 20000;
+
+	/// ワールドの大きさ
+	constexpr std::array<WorldBounds, 3> LARGE_WORLDS{
+		WorldBounds::screen(),
+		WorldBounds{4096.0f, 4096.0f},
+		WorldBounds{16384.0f, 16384.0f},
+	};
+
+	constexpr int FRAME_COUNT = 20;
+
+	/// 物体群groupsを描画し、各物体が相手の物体群と重なっている数を数える関数
+	template<typename B>
+	unsigned long long collide(B &bitmap, const std::vector<EntityGroup> &groups) {
+		bitmap.clear();
+		for (unsigned int g = 0; g < 2; ++g) {
+			bitmap.drawGroup(g, groups[g]);
+		}
+		unsigned long long hitCount = 0;
+		for (unsigned int g = 0; g < 2; ++g) {
+			const auto &group = groups[g];
+			for (size_t i = 0; i < group.size(); ++i) {
+				hitCount += std::popcount(bitmap.overlapDisk(group.x[i], group.y[i], group.r[i], 1u << (1 - g)));
+			}
+		}
+		return hitCount;
+	}
+
+	/// ワールドの大きさごとに、区画に分けたビットマップとワールド全体を覆う一枚のビットマップとで、
+	/// 同じ位置の物体を描画・照合する1フレームあたりの時間を出力する
+	///
+	/// 物体はワールドの中ほどの、画面の高さの帯に散らばらせる。
+	/// 確保した区画の数とバイト数、一枚のビットマップのバイト数、両方の衝突数も出力する。
+	/// 衝突数は、遠くの座標の丸め誤差で境界上の画素がわずかに異なる分を除いて一致する。
+	void run(const WorldBounds &world) {
+		const auto y = (world.height - HEIGHT_FLOAT) / 2.0f;
+		// 物体を動かすだけのシーン
+		Scene scene(
+			{
+				GroupDesc{LARGE_WORLD_ENTITY_COUNT / 2, y, 2.5f, 2.5f, 12.0f, HEIGHT_FLOAT},
+				GroupDesc{LARGE_WORLD_ENTITY_COUNT / 2, y, 2.5f, 2.5f, 12.0f, HEIGHT_FLOAT},
+			},
+			InteractionMatrix(),
+			world
+		);
+		TiledBitmap tiled(world, 2);
+		SoftwareBitmap dense(tiled.getWidth(), tiled.getHeight(), 2);
+
+		double tiledElapsed = 0.0;
+		double denseElapsed = 0.0;
+		unsigned long long tiledHitCount = 0;
+		unsigned long long denseHitCount = 0;
+		std::vector<EntityGroup> groups(2);
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			scene.update();
+			groups[0] = scene.getGroup(0);
+			groups[1] = scene.getGroup(1);
+
+			const Stopwatch tiledStopwatch;
+			tiled.prepare(groups, false);
+			tiledHitCount += collide(tiled, groups);
+			tiledElapsed += tiledStopwatch.elapsedMs();
+
+			const Stopwatch denseStopwatch;
+			denseHitCount += collide(dense, groups);
+			denseElapsed += denseStopwatch.elapsedMs();
+		}
+
+		const auto denseBytes = dense.getWordsPerRow() * sizeof(uint64_t) * dense.getHeight() * 2;
+		std::cout
+			<< world.width
+			<< "x"
+			<< world.height
+			<< " "
+			<< tiled.getAllocatedTileCount()
+			<< "/"
+			<< tiled.getTileCount()
+			<< " "
+			<< tiled.getAllocatedBytes()
+			<< " "
+			<< denseBytes
+			<< " "
+			<< tiledElapsed / FRAME_COUNT
+			<< " "
+			<< denseElapsed / FRAME_COUNT
+			<< " "
+			<< tiledHitCount
+			<< " "
+			<< denseHitCount
+			<< std::endl;
+	}
+}
+
+void benchLargeWorld() {
+	// 比べるワールドの大きさは自身で決めるため、既定のワールドの大きさは受け付けない
+	const auto &defaultWorld = getDefaultWorld();
+	if (defaultWorld.width != WIDTH_FLOAT || defaultWorld.height != HEIGHT_FLOAT) {
+		throw "large-world compares its own world sizes and does not accept --world.";
+	}
+	for (const auto &world: LARGE_WORLDS) {
+		run(world);
+	}
+}
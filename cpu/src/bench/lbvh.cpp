@@ -0,0 +1,59 @@
+#include "../bench.hpp"
+
+#include "../../../common/parallel.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+
+namespace {
+	/// 二つの物体群を合わせた物体数
+	constexpr std::array<size_t, 3> LBVH_ENTITY_COUNTS{10000, 100000, 1000000};
+
+	/// 総当たりで計測する物体数の上限
+	constexpr size_t BRUTE_FORCE_LIMIT = 100000;
+
+	constexpr float RADIUS = 1.0f;
+
+	void run(size_t entityCount, Backend backend, int frameCount) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		// ワールド全体に散らばらせ、一列に並んだ初期配置での極端な密集を避ける
+		Scene scene(
+			{
+				GroupDesc{entityCount / 2, 0.0f, RADIUS, 2.5f, 0.0f, world.height},
+				GroupDesc{entityCount / 2, 0.0f, RADIUS, 2.5f, 0.0f, world.height},
+			},
+			matrix
+		);
+		scene.setBackend(backend);
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < frameCount; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		std::cout
+			<< (backend == Backend::Lbvh ? "lbvh" : "brute-force")
+			<< " "
+			<< entityCount
+			<< " "
+			<< elapsed / frameCount
+			<< " "
+			<< scene.getHitCount()
+			<< std::endl;
+	}
+}
+
+void benchLbvh() {
+	std::cout << "workers " << getWorkerCount() << std::endl;
+	for (auto entityCount: LBVH_ENTITY_COUNTS) {
+		if (entityCount <= BRUTE_FORCE_LIMIT) {
+			run(entityCount, Backend::BruteForce, entityCount < BRUTE_FORCE_LIMIT ? 20 : 2);
+		}
+		run(entityCount, Backend::Lbvh, entityCount < BRUTE_FORCE_LIMIT ? 20 : 2);
+	}
+}
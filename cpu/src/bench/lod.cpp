@@ -0,0 +1,152 @@
+#include "../bench.hpp"
+
+#include "../../../common/contact.hpp"
+#include "../../../common/lod.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace {
+	/// 二つの物体群を合わせた物体数
+	constexpr size_t LOD_ENTITY_COUNT = 10000;
+
+	/// 関心点 (ワールドの下の方にいる二つの自機)
+	std::array<InterestPoint, 2> getInterestPoints() {
+		const auto &world = getDefaultWorld();
+		return {
+			InterestPoint{world.width / 4.0f, world.height * 3.0f / 4.0f},
+			InterestPoint{world.width * 3.0f / 4.0f, world.height * 3.0f / 4.0f},
+		};
+	}
+
+	/// 比べる詳細度の設定 (std::nulloptはすべての物体を詳細に判定する)
+	constexpr std::array<std::optional<LodDesc>, 7> LOD_SETTINGS{
+		std::nullopt,
+		LodDesc{320.0f, 8.0f},
+		LodDesc{320.0f, 64.0f},
+		LodDesc{160.0f, 8.0f},
+		LodDesc{160.0f, 64.0f},
+		LodDesc{80.0f, 8.0f},
+		LodDesc{80.0f, 64.0f},
+	};
+
+	constexpr std::array<std::pair<const char *, Backend>, 2> LOD_BACKENDS{
+		std::pair{"brute-force", Backend::BruteForce},
+		std::pair{"bitmap", Backend::Bitmap},
+	};
+
+	constexpr int FRAME_COUNT = 30;
+
+	std::unique_ptr<Scene> createScene(Backend backend) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		auto scene = std::make_unique<Scene>(
+			std::vector<GroupDesc>{
+				GroupDesc{LOD_ENTITY_COUNT / 2, 0.0f, 2.5f, 2.5f, 0.0f, world.height},
+				GroupDesc{LOD_ENTITY_COUNT / 2, 0.0f, 2.5f, 2.5f, 0.0f, world.height},
+			},
+			matrix
+		);
+		scene->setBackend(backend);
+		const auto points = getInterestPoints();
+		scene->setInterestPoints(points.data(), points.size());
+		return scene;
+	}
+
+	/// 物体(x, y)が関心点のどれかからradius以内にあるか
+	bool isNear(float x, float y, float radius) {
+		for (const auto &point: getInterestPoints()) {
+			const auto dx = x - point.x;
+			const auto dy = y - point.y;
+			if (dx * dx + dy * dy <= radius * radius) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// 詳細度の設定ごとに、1フレームあたりの時間と詳細に判定した物体数と、
+	/// 総当たりで求めた衝突フラグと比べて誤って立った・立たなかった物体の割合(%)とを、
+	/// すべての物体と関心点の近くの物体とについて出力する
+	///
+	/// 同じ初期配置のシーンを総当たりと並べて進め、フレームごとに衝突フラグを比べる。
+	void run(const char *name, Backend backend, const std::optional<LodDesc> &lod) {
+		auto reference = createScene(Backend::BruteForce);
+		auto scene = createScene(backend);
+		scene->setLod(lod);
+
+		constexpr auto half = LOD_ENTITY_COUNT / 2;
+		std::array<HitBitset, 2> referenceHits{HitBitset(half), HitBitset(half)};
+		std::array<HitBitset, 2> hits{HitBitset(half), HitBitset(half)};
+		reference->setContactOutput(nullptr, referenceHits.data());
+		scene->setContactOutput(nullptr, hits.data());
+
+		double elapsed = 0.0;
+		size_t nearCount = 0;
+		// [0]はすべての物体、[1]は関心点の近くの物体について数える
+		std::array<size_t, 2> referenceCounts{};
+		std::array<size_t, 2> falsePositives{};
+		std::array<size_t, 2> falseNegatives{};
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			reference->update();
+			const Stopwatch stopwatch;
+			scene->update();
+			elapsed += stopwatch.elapsedMs();
+			nearCount += lod ? scene->getLodNearCount() : LOD_ENTITY_COUNT;
+			for (unsigned int g = 0; g < 2; ++g) {
+				const auto &group = scene->getGroup(g);
+				for (size_t k = 0; k < half; ++k) {
+					const auto expected = referenceHits[g].test(k);
+					const auto actual = hits[g].test(k);
+					for (size_t m = 0; m < 2; ++m) {
+						if (m == 1 && !isNear(group.x[k], group.y[k], lod ? lod->radius : 0.0f)) {
+							continue;
+						}
+						referenceCounts[m] += expected;
+						falsePositives[m] += actual && !expected;
+						falseNegatives[m] += !actual && expected;
+					}
+				}
+			}
+		}
+
+		const auto percent = [](size_t n, size_t total) {
+			return total == 0 ? 0.0 : static_cast<double>(n) * 100.0 / static_cast<double>(total);
+		};
+		std::cout << name << " ";
+		if (lod) {
+			std::cout << lod->radius << " " << lod->cellSize;
+		} else {
+			std::cout << "off -";
+		}
+		std::cout
+			<< " "
+			<< elapsed / FRAME_COUNT
+			<< " "
+			<< nearCount / FRAME_COUNT
+			<< " "
+			<< percent(falsePositives[0], referenceCounts[0])
+			<< " "
+			<< percent(falseNegatives[0], referenceCounts[0])
+			<< " "
+			<< percent(falsePositives[1], referenceCounts[1])
+			<< " "
+			<< percent(falseNegatives[1], referenceCounts[1])
+			<< std::endl;
+	}
+}
+
+void benchLod() {
+	for (const auto &[name, backend]: LOD_BACKENDS) {
+		for (const auto &lod: LOD_SETTINGS) {
+			run(name, backend, lod);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#include "../bench.hpp"
+
+#include "../../../common/mask.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+
+namespace {
+	/// 二つの物体群を合わせた物体数
+	constexpr std::array<size_t, 3> MASK_ENTITY_COUNTS{2000, 10000, 40000};
+
+	constexpr int FRAME_COUNT = 100;
+
+	/// 物体に割り当てる形
+	enum class Shapes {
+		/// すべて円
+		Circle,
+		/// 円・米粒・星・レーザーを順に割り当てる
+		Mixed,
+	};
+
+	void run(size_t entityCount, Backend backend, Shapes shapes, const MaskAtlas &atlas, const std::array<uint32_t, 4> &palette) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		Scene scene(
+			{
+				GroupDesc{entityCount / 2, 0.0f, 4.0f, 2.5f, 12.0f, world.height},
+				GroupDesc{entityCount / 2, 0.0f, 4.0f, 2.5f, 12.0f, world.height},
+			},
+			matrix
+		);
+		scene.setBackend(backend);
+		scene.setMaskAtlas(&atlas);
+		if (shapes == Shapes::Mixed) {
+			for (unsigned int g = 0; g < scene.getGroupCount(); ++g) {
+				for (size_t i = 0; i < scene.getGroup(g).size(); ++i) {
+					scene.setShape(scene.getEntityIdAt(g, i), palette[i % palette.size()]);
+				}
+			}
+		}
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		std::cout
+			<< (backend == Backend::Bitmap ? "bitmap" : "brute-force")
+			<< " "
+			<< (shapes == Shapes::Mixed ? "mixed" : "circle")
+			<< " "
+			<< entityCount
+			<< " "
+			<< elapsed / FRAME_COUNT
+			<< " "
+			<< scene.getHitCount()
+			<< std::endl;
+	}
+}
+
+void benchMasks() {
+	// 組み込みの形は起動時に一度だけアトラスに加える
+	MaskAtlas atlas;
+	const std::array<uint32_t, 4> palette{
+		SHAPE_CIRCLE,
+		atlas.add(RICE_MASK),
+		atlas.add(STAR_MASK),
+		atlas.add(LASER_MASK),
+	};
+	for (auto entityCount: MASK_ENTITY_COUNTS) {
+		run(entityCount, Backend::BruteForce, Shapes::Mixed, atlas, palette);
+		run(entityCount, Backend::Bitmap, Shapes::Circle, atlas, palette);
+		run(entityCount, Backend::Bitmap, Shapes::Mixed, atlas, palette);
+	}
+}
@@ -0,0 +1,72 @@
+#include "../bench.hpp"
+
+#include "../../../common/jobsystem.hpp"
+#include "../../../common/parallel.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+#include <memory>
+
+namespace {
+	constexpr std::array<size_t, 3> PIPELINE_ENTITY_COUNTS{5000, 20000, 100000};
+
+	constexpr int FRAME_COUNT = 200;
+
+	void run(size_t entityCount, bool pipelined) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		matrix.set(1, 2);
+		Scene scene(
+			{
+				GroupDesc{entityCount / 4, 0.0f, 4.0f, 2.5f, 0.0f, world.height},
+				GroupDesc{entityCount / 2, 0.0f, 2.0f, 4.0f, 0.0f, world.height},
+				GroupDesc{entityCount / 4, 0.0f, 6.0f, 1.5f, 0.0f, world.height},
+			},
+			matrix
+		);
+		scene.setBackend(Backend::Bitmap);
+		scene.setPipelined(pipelined);
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		std::cout
+			<< (pipelined ? "pipelined" : "serial")
+			<< " "
+			<< entityCount
+			<< " "
+			<< elapsed / FRAME_COUNT
+			<< " "
+			<< scene.getHitCount();
+		if (pipelined) {
+			for (const auto n: scene.getStageMs()) {
+				std::cout << " " << n / FRAME_COUNT;
+			}
+		}
+		std::cout << std::endl;
+	}
+}
+
+void benchPipeline() {
+	// 段を同時に進めるため、呼び出し側が設定していなければハードウェアのスレッド数のジョブシステムを用いる
+	std::unique_ptr<JobSystem> system;
+	if (!getJobSystem()) {
+		system = std::make_unique<JobSystem>(getWorkerCount());
+		setJobSystem(system.get());
+	}
+	std::cout << "workers " << getWorkerCount() << std::endl;
+	for (auto entityCount: PIPELINE_ENTITY_COUNTS) {
+		run(entityCount, false);
+		run(entityCount, true);
+		cooldown();
+	}
+	if (system) {
+		setJobSystem(nullptr);
+	}
+}
@@ -0,0 +1,120 @@
+#include "../bench.hpp"
+
+#include "../../../common/query.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+	/// 二つの物体群を合わせた物体数
+	constexpr std::array<size_t, 2> QUERY_ENTITY_COUNTS{10000, 100000};
+
+	/// 一括で行う問い合わせの数
+	constexpr size_t QUERY_COUNT = 1000;
+
+	/// 問い合わせの箱の一辺の半分と円の半径
+	constexpr float QUERY_EXTENT = 16.0f;
+
+	/// k近傍の問い合わせで求める近傍の数
+	constexpr size_t NEAREST_COUNT = 8;
+
+	/// 結果を書き出す領域の大きさ
+	constexpr size_t RESULT_CAPACITY = 1 << 20;
+
+	constexpr int FRAME_COUNT = 4;
+
+	constexpr std::array<Backend, 3> BACKENDS{Backend::BruteForce, Backend::AabbTree, Backend::Lbvh};
+
+	const char *getBackendName(Backend backend) {
+		switch (backend) {
+		case Backend::AabbTree:
+			return "aabb-tree";
+		case Backend::Lbvh:
+			return "lbvh";
+		default:
+			return "brute-force";
+		}
+	}
+
+	void print(const char *backend, size_t entityCount, const char *kind, double elapsed, const QueryResults &results) {
+		std::cout
+			<< backend
+			<< " "
+			<< entityCount
+			<< " "
+			<< kind
+			<< " "
+			<< elapsed * 1000.0 / QUERY_COUNT
+			<< " "
+			<< results.size()
+			<< std::endl;
+	}
+
+	void run(size_t entityCount, Backend backend, QueryResults &results) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		Scene scene(
+			{
+				GroupDesc{entityCount / 2, 0.0f, 1.0f, 2.5f, 4.0f, world.height},
+				GroupDesc{entityCount / 2, 0.0f, 1.0f, 2.5f, 4.0f, world.height},
+			},
+			matrix
+		);
+		scene.setBackend(backend);
+		scene.setQueryGroups(0b11);
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			scene.update();
+		}
+
+		// 問い合わせの位置はワールド全体に低食い違い列で散らばらせる
+		std::vector<QueryPoint> points(QUERY_COUNT);
+		std::vector<QueryCircle> circles(QUERY_COUNT);
+		std::vector<Aabb> boxes(QUERY_COUNT);
+		for (size_t q = 0; q < QUERY_COUNT; ++q) {
+			const auto x = world.width * std::fmod(static_cast<float>(q) * 0.618034f, 1.0f);
+			const auto y = world.height * std::fmod(static_cast<float>(q) * 0.754878f, 1.0f);
+			points[q] = QueryPoint{x, y};
+			circles[q] = QueryCircle{x, y, QUERY_EXTENT};
+			boxes[q] = Aabb{x - QUERY_EXTENT, y - QUERY_EXTENT, x + QUERY_EXTENT, y + QUERY_EXTENT};
+		}
+
+		const auto *name = getBackendName(backend);
+		{
+			const Stopwatch stopwatch;
+			scene.queryBoxes(boxes.data(), QUERY_COUNT, 0b11, results);
+			print(name, entityCount, "box", stopwatch.elapsedMs(), results);
+		}
+		{
+			const Stopwatch stopwatch;
+			scene.queryCircles(circles.data(), QUERY_COUNT, 0b11, results);
+			print(name, entityCount, "circle", stopwatch.elapsedMs(), results);
+		}
+		{
+			const Stopwatch stopwatch;
+			scene.queryPoints(points.data(), QUERY_COUNT, 0b11, results);
+			print(name, entityCount, "point", stopwatch.elapsedMs(), results);
+		}
+		{
+			const Stopwatch stopwatch;
+			scene.queryNearest(points.data(), QUERY_COUNT, 0b11, NEAREST_COUNT, results);
+			print(name, entityCount, "nearest", stopwatch.elapsedMs(), results);
+		}
+	}
+}
+
+void benchQueries() {
+	std::vector<EntityId> ids(RESULT_CAPACITY);
+	std::vector<uint32_t> counts(QUERY_COUNT);
+	QueryResults results(ids.data(), ids.size(), counts.data());
+	for (auto entityCount: QUERY_ENTITY_COUNTS) {
+		for (auto backend: BACKENDS) {
+			run(entityCount, backend, results);
+		}
+	}
+}
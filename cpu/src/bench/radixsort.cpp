@@ -0,0 +1,92 @@
+#include "../bench.hpp"
+
+#include "../../../common/parallel.hpp"
+#include "../../../common/radixsort.hpp"
+#include "../../../common/stopwatch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+	constexpr std::array<size_t, 3> KEY_COUNTS{10000, 100000, 1000000};
+
+	/// 1回の計測で並べ替える回数
+	constexpr int REPEAT_COUNT = 20;
+
+	struct KeyValue {
+		uint32_t key;
+		uint32_t value;
+	};
+
+	/// 並べ替えのたびに入力を元に戻し、1回あたりの並べ替えの時間を出力する
+	template<typename Restore, typename Sort>
+	void run(const char *label, size_t count, Restore restore, Sort sort) {
+		double elapsed = 0.0;
+		for (int i = 0; i < REPEAT_COUNT; ++i) {
+			restore();
+			const Stopwatch stopwatch;
+			sort();
+			elapsed += stopwatch.elapsedMs();
+		}
+		std::cout << label << " " << count << " " << elapsed / REPEAT_COUNT << std::endl;
+	}
+
+	template<unsigned int DIGIT_BITS>
+	void runRadix(const char *label, const std::vector<uint32_t> &source, const std::vector<KeyValue> &expected) {
+		const auto count = source.size();
+		std::vector<uint32_t> keys(count);
+		std::vector<uint32_t> values(count);
+		std::vector<uint32_t> tmpKeys(count);
+		std::vector<uint32_t> tmpValues(count);
+		RadixSorter<DIGIT_BITS> sorter;
+		run(
+			label,
+			count,
+			[&]() {
+				std::copy(source.begin(), source.end(), keys.begin());
+				for (size_t i = 0; i < count; ++i) {
+					values[i] = static_cast<uint32_t>(i);
+				}
+			},
+			[&]() { sorter.sort(keys.data(), values.data(), tmpKeys.data(), tmpValues.data(), count); }
+		);
+		for (size_t i = 0; i < count; ++i) {
+			if (keys[i] != expected[i].key || values[i] != expected[i].value) {
+				throw "radix sort result mismatch.";
+			}
+		}
+	}
+}
+
+void benchRadixSort() {
+	std::cout << "workers " << getWorkerCount() << std::endl;
+	std::mt19937 random(12345);
+	for (auto count: KEY_COUNTS) {
+		std::vector<uint32_t> source(count);
+		for (auto &n: source) {
+			n = random();
+		}
+		std::vector<KeyValue> pairs(count);
+		const auto restore = [&]() {
+			for (size_t i = 0; i < count; ++i) {
+				pairs[i] = {source[i], static_cast<uint32_t>(i)};
+			}
+		};
+		const auto less = [](const KeyValue &a, const KeyValue &b) {
+			return a.key < b.key;
+		};
+		run("std::sort", count, restore, [&]() { std::sort(pairs.begin(), pairs.end(), less); });
+		run("std::sort(par)", count, restore, [&]() { std::sort(std::execution::par, pairs.begin(), pairs.end(), less); });
+
+		// 基数ソートは安定なので、同じキーは元の順序のまま並ぶ
+		restore();
+		std::stable_sort(pairs.begin(), pairs.end(), less);
+		runRadix<8>("radix-8", source, pairs);
+		runRadix<11>("radix-11", source, pairs);
+	}
+}
@@ -0,0 +1,145 @@
+#include "../bench.hpp"
+
+#include "../../../common/bitmap.hpp"
+#include "../../../common/raycast.hpp"
+#include "../../../common/resolution.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+	/// 二つの物体群を合わせた物体数
+	constexpr std::array<size_t, 3> RAY_ENTITY_COUNTS{1000, 5000, 20000};
+
+	/// 1フレームあたりの光線の数
+	constexpr size_t RAY_COUNT = 10000;
+
+	/// 光線の長さ
+	constexpr float RAY_LENGTH = 1000.0f;
+
+	constexpr int FRAME_COUNT = 10;
+
+	constexpr uint32_t RAY_MASK = 0b11;
+	constexpr size_t GROUP_COUNT = 2;
+
+	/// 光線に沿って1pxずつcheck()で画素を調べる、これまでの方法
+	void probe(const SoftwareBitmap &bitmap, const Ray &ray, uint32_t mask, float *distances) {
+		distances[0] = HUGE_VALF;
+		distances[1] = HUGE_VALF;
+		auto remaining = mask;
+		for (float t = 0.0f; t <= ray.length && remaining != 0; t += 1.0f) {
+			const auto x = static_cast<int>(std::floor(ray.x + ray.dx * t));
+			const auto y = static_cast<int>(std::floor(ray.y + ray.dy * t));
+			const auto found = bitmap.check(x, y, remaining);
+			for (auto bits = found; bits != 0; bits &= bits - 1) {
+				distances[std::countr_zero(bits)] = t;
+			}
+			remaining &= ~found;
+		}
+	}
+
+	void print(const char *method, size_t entityCount, double elapsed) {
+		std::cout
+			<< method
+			<< " "
+			<< entityCount
+			<< " "
+			<< static_cast<double>(RAY_COUNT) * FRAME_COUNT / elapsed / 1000.0
+			<< std::endl;
+	}
+
+	void run(size_t entityCount) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		Scene scene(
+			{
+				GroupDesc{entityCount / 2, 0.0f, 2.0f, 2.5f, 8.0f, world.height},
+				GroupDesc{entityCount / 2, 0.0f, 2.0f, 2.5f, 8.0f, world.height},
+			},
+			matrix
+		);
+		scene.setBackend(Backend::Bitmap);
+
+		// 始点はワールド全体に低食い違い列で散らばらせ、向きは黄金角ずつずらす
+		std::vector<Ray> rays(RAY_COUNT);
+		for (size_t q = 0; q < RAY_COUNT; ++q) {
+			const auto fq = static_cast<float>(q);
+			const auto dir = std::fmod(fq * 2.399963f, 2.0f * PI);
+			rays[q] = Ray{
+				world.width * std::fmod(fq * 0.618034f, 1.0f),
+				world.height * std::fmod(fq * 0.754878f, 1.0f),
+				std::cos(dir),
+				std::sin(dir),
+				RAY_LENGTH,
+			};
+		}
+
+		const auto width = toBitmapSize(world.width, 1.0f);
+		const auto height = toBitmapSize(world.height, 1.0f);
+		SoftwareBitmap bitmap(width, height, GROUP_COUNT);
+		OccupancyGrid full(width, height);
+		full.fill(~0u);
+		std::vector<float> expected(RAY_COUNT * GROUP_COUNT);
+		std::vector<float> distances(RAY_COUNT * GROUP_COUNT);
+		const auto check = [&](int x, int y, uint32_t m) { return bitmap.check(x, y, m); };
+		double probeMs = 0.0;
+		double ddaMs = 0.0;
+		double occupancyMs = 0.0;
+		double buildMs = 0.0;
+		double sceneMs = 0.0;
+		auto same = true;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			scene.update();
+			bitmap.clear();
+			for (unsigned int g = 0; g < GROUP_COUNT; ++g) {
+				bitmap.drawGroup(g, scene.getGroup(g));
+			}
+			{
+				const Stopwatch stopwatch;
+				for (size_t q = 0; q < RAY_COUNT; ++q) {
+					probe(bitmap, rays[q], RAY_MASK, distances.data() + q * GROUP_COUNT);
+				}
+				probeMs += stopwatch.elapsedMs();
+			}
+			{
+				const Stopwatch stopwatch;
+				castRays(full, rays.data(), RAY_COUNT, RAY_MASK, expected.data(), GROUP_COUNT, check);
+				ddaMs += stopwatch.elapsedMs();
+			}
+			{
+				const Stopwatch stopwatch;
+				bitmap.updateOccupancy();
+				buildMs += stopwatch.elapsedMs();
+			}
+			{
+				const Stopwatch stopwatch;
+				bitmap.castRays(rays.data(), RAY_COUNT, RAY_MASK, distances.data());
+				occupancyMs += stopwatch.elapsedMs();
+			}
+			same = same && distances == expected;
+			{
+				const Stopwatch stopwatch;
+				scene.castRays(rays.data(), RAY_COUNT, RAY_MASK, distances.data());
+				sceneMs += stopwatch.elapsedMs();
+			}
+			same = same && distances == expected;
+		}
+		print("probe", entityCount, probeMs);
+		print("dda", entityCount, ddaMs);
+		print("dda+occupancy", entityCount, occupancyMs);
+		print("scene", entityCount, sceneMs);
+		std::cout << "occupancy-build " << entityCount << " " << buildMs / FRAME_COUNT << std::endl;
+		std::cout << "match " << entityCount << " " << (same ? "ok" : "NG") << std::endl;
+	}
+}
+
+void benchRays() {
+	for (auto entityCount: RAY_ENTITY_COUNTS) {
+		run(entityCount);
+	}
+}
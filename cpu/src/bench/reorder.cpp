@@ -0,0 +1,123 @@
+#include "../bench.hpp"
+
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace {
+	/// 二つの物体群を合わせた物体数
+	constexpr size_t REORDER_ENTITY_COUNT = 100000;
+
+	/// 生成順と空間での並びとの相関がなくなるまで進めるフレーム数
+	constexpr int WARMUP_FRAME_COUNT = 300;
+
+	constexpr int FRAME_COUNT_PER_RUN = 64;
+
+	/// 1つのキャッシュラインに入るfloatの数
+	constexpr size_t FLOATS_PER_LINE = 16;
+
+	/// 1つの4KiBのページに入るfloatの数
+	constexpr size_t FLOATS_PER_PAGE = 1024;
+
+	struct Order {
+		const char *label;
+		SpatialOrder order;
+	};
+	constexpr std::array<Order, 3> ORDERS{
+		Order{"none", SpatialOrder::None},
+		Order{"morton", SpatialOrder::Morton},
+		Order{"hilbert", SpatialOrder::Hilbert},
+	};
+
+	struct Method {
+		const char *label;
+		Backend backend;
+	};
+	constexpr std::array<Method, 3> METHODS{
+		Method{"lbvh", Backend::Lbvh},
+		Method{"aabb-tree", Backend::AabbTree},
+		Method{"bitmap", Backend::Bitmap},
+	};
+
+	/// 書き出された衝突ペアの順に相手の物体(物体群0)の位置を辿ったとき、
+	/// 直前の相手と異なるキャッシュラインに移った割合と、異なるページに移った割合
+	///
+	/// キャッシュミス(とTLBミス)の代わりとなる指標で、物体の並びが空間で近い順であるほど小さくなる。
+	std::pair<double, double> measureSwitchRates(Scene &scene) {
+		std::vector<ContactPair> pairs(1 << 20);
+		ContactBuffer contacts(pairs.data(), pairs.size());
+		std::array<HitBitset, 2> hits{HitBitset(scene.getGroup(0).size()), HitBitset(scene.getGroup(1).size())};
+		scene.setContactOutput(&contacts, hits.data());
+		scene.update();
+		scene.setContactOutput(nullptr, nullptr);
+		size_t lineSwitchCount = 0;
+		size_t pageSwitchCount = 0;
+		size_t previousSlot = SIZE_MAX;
+		for (size_t i = 0; i < contacts.size(); ++i) {
+			const auto slot = scene.getSlotOf(contacts.data()[i].a);
+			lineSwitchCount += slot / FLOATS_PER_LINE != previousSlot / FLOATS_PER_LINE ? 1 : 0;
+			pageSwitchCount += slot / FLOATS_PER_PAGE != previousSlot / FLOATS_PER_PAGE ? 1 : 0;
+			previousSlot = slot;
+		}
+		if (contacts.size() == 0) {
+			return {0.0, 0.0};
+		}
+		const auto count = static_cast<double>(contacts.size());
+		return {static_cast<double>(lineSwitchCount) / count, static_cast<double>(pageSwitchCount) / count};
+	}
+
+	void run(const Method &method, const Order &order) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		Scene scene(
+			{
+				GroupDesc{REORDER_ENTITY_COUNT / 2, 0.0f, 1.0f, 2.5f, 0.0f, world.height},
+				GroupDesc{REORDER_ENTITY_COUNT / 2, 0.0f, 1.0f, 2.5f, 0.0f, world.height},
+			},
+			matrix
+		);
+		// 衝突判定の安いビットマップで進めてから、計測する方式に切り替える
+		scene.setBackend(Backend::Bitmap);
+		for (int i = 0; i < WARMUP_FRAME_COUNT; ++i) {
+			scene.update();
+		}
+		scene.setBackend(method.backend);
+		scene.setSpatialOrder(order.order);
+		scene.update();
+
+		const auto hitCount = scene.getHitCount();
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT_PER_RUN; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+		const auto frameHitCount = scene.getHitCount() - hitCount;
+
+		std::cout
+			<< method.label
+			<< " "
+			<< order.label
+			<< " "
+			<< elapsed / FRAME_COUNT_PER_RUN
+			<< " "
+			<< frameHitCount;
+		if (method.backend != Backend::Bitmap) {
+			const auto [line, page] = measureSwitchRates(scene);
+			std::cout << " " << line << " " << page;
+		}
+		std::cout << std::endl;
+	}
+}
+
+void benchReorder() {
+	for (const auto &method: METHODS) {
+		for (const auto &order: ORDERS) {
+			run(method, order);
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#include "../bench.hpp"
+
+#include "../../../common/resolution.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+	/// 二つの物体群を合わせた物体数
+	constexpr std::array<size_t, 2> RESOLUTION_ENTITY_COUNTS{10000, 40000};
+
+	/// 衝突判定ビットマップの、ワールドの1単位あたりの画素数
+	constexpr std::array<float, 4> BITMAP_SCALES{0.25f, 0.5f, 1.0f, 2.0f};
+
+	constexpr int FRAME_COUNT = 50;
+
+	std::unique_ptr<Scene> createScene(size_t entityCount, Backend backend) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		auto scene = std::make_unique<Scene>(
+			std::vector<GroupDesc>{
+				GroupDesc{entityCount / 2, 0.0f, 2.5f, 2.5f, 12.0f, world.height},
+				GroupDesc{entityCount / 2, 0.0f, 2.5f, 2.5f, 12.0f, world.height},
+			},
+			matrix
+		);
+		scene->setBackend(backend);
+		return scene;
+	}
+
+	/// 倍率ごとに、ビットマップで判定するシーンの1フレームあたりの時間と、
+	/// 総当たりで求めた衝突フラグと比べて誤って立った・立たなかった物体の割合(%)とを出力する
+	///
+	/// 同じ初期配置のシーンを総当たりと並べて進め、フレームごとに衝突フラグを比べる。
+	void run(size_t entityCount, float scale) {
+		auto reference = createScene(entityCount, Backend::BruteForce);
+		auto scene = createScene(entityCount, Backend::Bitmap);
+		scene->setBitmapScale(scale);
+
+		std::array<HitBitset, 2> referenceHits{HitBitset(entityCount / 2), HitBitset(entityCount / 2)};
+		std::array<HitBitset, 2> hits{HitBitset(entityCount / 2), HitBitset(entityCount / 2)};
+		reference->setContactOutput(nullptr, referenceHits.data());
+		scene->setContactOutput(nullptr, hits.data());
+
+		double elapsed = 0.0;
+		size_t referenceCount = 0;
+		size_t falsePositives = 0;
+		size_t falseNegatives = 0;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			reference->update();
+			const Stopwatch stopwatch;
+			scene->update();
+			elapsed += stopwatch.elapsedMs();
+			for (unsigned int g = 0; g < 2; ++g) {
+				for (size_t k = 0; k < entityCount / 2; ++k) {
+					const auto expected = referenceHits[g].test(k);
+					const auto actual = hits[g].test(k);
+					referenceCount += expected;
+					falsePositives += actual && !expected;
+					falseNegatives += !actual && expected;
+				}
+			}
+		}
+
+		const auto width = toBitmapSize(getDefaultWorld().width, scale);
+		const auto height = toBitmapSize(getDefaultWorld().height, scale);
+		const auto bytes = (static_cast<size_t>(width) + 63) / 64 * 8 * height * 2;
+		std::cout
+			<< entityCount
+			<< " "
+			<< scale
+			<< " "
+			<< width
+			<< "x"
+			<< height
+			<< " "
+			<< bytes
+			<< " "
+			<< elapsed / FRAME_COUNT
+			<< " "
+			<< static_cast<double>(falsePositives) * 100.0 / static_cast<double>(referenceCount)
+			<< " "
+			<< static_cast<double>(falseNegatives) * 100.0 / static_cast<double>(referenceCount)
+			<< std::endl;
+	}
+}
+
+void benchResolution() {
+	for (auto entityCount: RESOLUTION_ENTITY_COUNTS) {
+		for (auto scale: BITMAP_SCALES) {
+			run(entityCount, scale);
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#include "../bench.hpp"
+
+#include "../../../common/snapshot.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <cstring>
+#include <iostream>
+
+namespace {
+	/// 巻き戻しで遡るフレーム数
+	constexpr unsigned long long ROLLBACK_FRAMES = 8;
+
+	constexpr size_t ENTITY_COUNT = 5000;
+	constexpr int WARMUP_FRAMES = 60;
+	constexpr int REPEAT_COUNT = 1000;
+	constexpr int ROLLBACK_COUNT = 50;
+
+	void run(Backend backend) {
+		Scene scene(ENTITY_COUNT / 2);
+		scene.setBackend(backend);
+		scene.update();
+
+		// 保存した大きさに余裕を持たせて、リングの領域を事前に確保する
+		Snapshot probe;
+		scene.save(probe);
+		SnapshotRing ring(ROLLBACK_FRAMES + 1, probe.size() + probe.size() / 4);
+		for (int i = 0; i < WARMUP_FRAMES; ++i) {
+			scene.update();
+			scene.save(ring.acquire(scene.getFrameCount()));
+		}
+		const auto frame = scene.getFrameCount();
+
+		Stopwatch stopwatch;
+		for (int i = 0; i < REPEAT_COUNT; ++i) {
+			scene.save(ring.acquire(frame));
+		}
+		const auto saveUs = stopwatch.elapsedMs() * 1000.0 / REPEAT_COUNT;
+
+		stopwatch.reset();
+		for (int i = 0; i < REPEAT_COUNT; ++i) {
+			scene.restore(ring.get(frame - ROLLBACK_FRAMES));
+		}
+		const auto restoreUs = stopwatch.elapsedMs() * 1000.0 / REPEAT_COUNT;
+		scene.restore(ring.get(frame));
+
+		// 巻き戻して保存しながら進め直し、元の状態と一致するか確かめる
+		Snapshot expected;
+		scene.save(expected);
+		stopwatch.reset();
+		for (int i = 0; i < ROLLBACK_COUNT; ++i) {
+			scene.restore(ring.get(frame - ROLLBACK_FRAMES));
+			while (scene.getFrameCount() < frame) {
+				scene.update();
+				scene.save(ring.acquire(scene.getFrameCount()));
+			}
+		}
+		const auto rollbackMs = stopwatch.elapsedMs() / ROLLBACK_COUNT;
+		Snapshot actual;
+		scene.save(actual);
+		const auto matches = expected.size() == actual.size() && std::memcmp(expected.data(), actual.data(), actual.size()) == 0;
+
+		std::cout
+			<< (backend == Backend::AabbTree ? "aabb-tree" : "brute-force")
+			<< " "
+			<< probe.size()
+			<< " "
+			<< saveUs
+			<< " "
+			<< restoreUs
+			<< " "
+			<< rollbackMs
+			<< " "
+			<< (matches ? "ok" : "mismatch")
+			<< std::endl;
+	}
+}
+
+void benchRollback() {
+	run(Backend::BruteForce);
+	run(Backend::AabbTree);
+}
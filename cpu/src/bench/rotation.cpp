@@ -0,0 +1,90 @@
+#include "../bench.hpp"
+
+#include "../../../common/bitmap.hpp"
+#include "../../../common/mask.hpp"
+#include "../../../common/resolution.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../../../common/world.hpp"
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+	/// 1フレームに描画する物体の数
+	constexpr size_t SPRITE_COUNT = 20000;
+
+	/// 物体の半径
+	constexpr std::array<float, 3> SPRITE_RADII{4.0f, 12.0f, 32.0f};
+
+	constexpr int FRAME_COUNT = 20;
+
+	struct Sprite {
+		float x;
+		float y;
+		float angle;
+	};
+
+	/// rotatedならば物体ごとに異なる角度で、そうでなければ回さずに描画する
+	void run(const MaskAtlas &atlas, uint32_t shape, const char *name, float r, const std::vector<Sprite> &sprites, bool rotated) {
+		const auto &world = getDefaultWorld();
+		const auto width = toBitmapSize(world.width, 1.0f);
+		const auto height = toBitmapSize(world.height, 1.0f);
+		SoftwareBitmap bitmap(width, height, 1);
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			bitmap.clear();
+			for (const auto &n: sprites) {
+				bitmap.drawMask(0, atlas, shape, n.x, n.y, r, rotated ? n.angle : 0.0f);
+			}
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		// 回しても形の面積は変わらないはずなので、覆った画素の数を比べられるよう出力する
+		size_t area = 0;
+		forEachMaskSpan(atlas, shape, world.width / 2.0f, world.height / 2.0f, r, rotated ? sprites[0].angle : 0.0f, width, height, [&](int, int x0, int x1) {
+			area += static_cast<size_t>(x1 - x0);
+		});
+
+		std::cout
+			<< name
+			<< " "
+			<< (rotated ? "rotated" : "axis-aligned")
+			<< " "
+			<< r
+			<< " "
+			<< elapsed * 1000000.0 / (static_cast<double>(FRAME_COUNT) * SPRITE_COUNT)
+			<< " "
+			<< area
+			<< std::endl;
+	}
+}
+
+void benchRotation() {
+	MaskAtlas atlas;
+	const std::array<std::pair<const char *, uint32_t>, 3> shapes{
+		std::pair{"rice", atlas.add(RICE_MASK)},
+		std::pair{"star", atlas.add(STAR_MASK)},
+		std::pair{"laser", atlas.add(LASER_MASK)},
+	};
+
+	// 位置はワールド全体に低食い違い列で散らばらせ、角度は黄金角ずつずらす
+	const auto &world = getDefaultWorld();
+	std::vector<Sprite> sprites(SPRITE_COUNT);
+	for (size_t i = 0; i < SPRITE_COUNT; ++i) {
+		const auto fi = static_cast<float>(i);
+		sprites[i] = Sprite{
+			world.width * std::fmod(fi * 0.618034f, 1.0f),
+			world.height * std::fmod(fi * 0.754878f, 1.0f),
+			std::fmod(fi * 2.399963f + 0.5f, 2.0f * PI),
+		};
+	}
+
+	for (const auto &[name, shape]: shapes) {
+		for (auto r: SPRITE_RADII) {
+			run(atlas, shape, name, r, sprites, false);
+			run(atlas, shape, name, r, sprites, true);
+		}
+	}
+}
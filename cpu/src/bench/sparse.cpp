@@ -0,0 +1,112 @@
+#include "../bench.hpp"
+
+#include "../../../common/bitmap.hpp"
+#include "../../../common/resolution.hpp"
+#include "../../../common/sparsebitmap.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../../../common/world.hpp"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+	/// 物体群の数
+	constexpr unsigned int SPARSE_GROUP_COUNT = 4;
+
+	/// すべての物体群を合わせた物体数
+	constexpr std::array<size_t, 6> SPARSE_ENTITY_COUNTS{100, 1000, 5000, 20000, 50000, 100000};
+
+	/// 物体の半径
+	constexpr std::array<float, 2> SPARSE_RADII{2.5f, 10.0f};
+
+	constexpr int FRAME_COUNT = 20;
+
+	/// 物体をワールド全体に低食い違い列で散らばらせた物体群を作る関数
+	std::vector<EntityGroup> createGroups(size_t entityCount, float r) {
+		const auto &world = getDefaultWorld();
+		std::vector<EntityGroup> groups(SPARSE_GROUP_COUNT);
+		for (size_t i = 0; i < entityCount; ++i) {
+			const auto fi = static_cast<float>(i);
+			const auto x = world.width * std::fmod(fi * 0.618034f, 1.0f);
+			const auto y = world.height * std::fmod(fi * 0.754878f, 1.0f);
+			groups[i % SPARSE_GROUP_COUNT].push(x, y, r, 0.0f, 0.0f, SHAPE_CIRCLE);
+		}
+		return groups;
+	}
+
+	/// すべての物体群を描画し、各物体がほかの物体群と重なっている数を数える関数
+	template<typename B>
+	unsigned long long collide(B &bitmap, const std::vector<EntityGroup> &groups) {
+		bitmap.clear();
+		for (unsigned int g = 0; g < SPARSE_GROUP_COUNT; ++g) {
+			bitmap.drawGroup(g, groups[g]);
+		}
+		constexpr auto all = (1u << SPARSE_GROUP_COUNT) - 1;
+		unsigned long long hitCount = 0;
+		for (unsigned int g = 0; g < SPARSE_GROUP_COUNT; ++g) {
+			const auto &group = groups[g];
+			for (size_t i = 0; i < group.size(); ++i) {
+				hitCount += std::popcount(bitmap.overlapDisk(group.x[i], group.y[i], group.r[i], all & ~(1u << g)));
+			}
+		}
+		return hitCount;
+	}
+
+	/// 物体数と半径ごとに、疎なビットマップと密なビットマップとで同じ物体を消去・描画・照合する1フレームあたりの時間を出力する
+	///
+	/// 確保した区画の割合(%)、疎なビットマップのバイト数、密なビットマップのバイト数、両方の衝突数も出力する。
+	/// 衝突数は常に一致する。
+	void run(size_t entityCount, float r) {
+		const auto groups = createGroups(entityCount, r);
+		const auto width = toBitmapSize(getDefaultWorld().width, 1.0f);
+		const auto height = toBitmapSize(getDefaultWorld().height, 1.0f);
+		SparseBitmap sparse(width, height, SPARSE_GROUP_COUNT);
+		SoftwareBitmap dense(width, height, SPARSE_GROUP_COUNT);
+
+		double sparseElapsed = 0.0;
+		double denseElapsed = 0.0;
+		unsigned long long sparseHitCount = 0;
+		unsigned long long denseHitCount = 0;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			const Stopwatch sparseStopwatch;
+			sparseHitCount += collide(sparse, groups);
+			sparseElapsed += sparseStopwatch.elapsedMs();
+
+			const Stopwatch denseStopwatch;
+			denseHitCount += collide(dense, groups);
+			denseElapsed += denseStopwatch.elapsedMs();
+		}
+
+		const auto denseBytes = dense.getWordsPerRow() * sizeof(uint64_t) * dense.getHeight() * SPARSE_GROUP_COUNT;
+		std::cout
+			<< entityCount
+			<< " "
+			<< r
+			<< " "
+			<< static_cast<double>(sparse.getAllocatedTileCount()) * 100.0 / static_cast<double>(sparse.getTileCount())
+			<< " "
+			<< sparse.getAllocatedBytes()
+			<< " "
+			<< denseBytes
+			<< " "
+			<< sparseElapsed / FRAME_COUNT
+			<< " "
+			<< denseElapsed / FRAME_COUNT
+			<< " "
+			<< sparseHitCount / FRAME_COUNT
+			<< " "
+			<< denseHitCount / FRAME_COUNT
+			<< std::endl;
+	}
+}
+
+void benchSparseBitmap() {
+	for (auto r: SPARSE_RADII) {
+		for (auto entityCount: SPARSE_ENTITY_COUNTS) {
+			run(entityCount, r);
+		}
+	}
+}
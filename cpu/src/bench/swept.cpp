@@ -0,0 +1,61 @@
+#include "../bench.hpp"
+
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+
+#include <array>
+#include <iostream>
+
+namespace {
+	constexpr std::array<size_t, 3> SWEPT_ENTITY_COUNTS{500, 1000, 2000};
+	constexpr std::array<float, 2> SPEEDS{2.5f, 20.0f};
+	constexpr float RADIUS = 3.0f;
+	constexpr int FRAME_COUNT_PER_RUN = 200;
+
+	double run(const char *label, size_t entityCount, float speed, Backend backend, bool swept) {
+		const auto &world = getDefaultWorld();
+		InteractionMatrix matrix;
+		matrix.set(0, 1);
+		Scene scene(
+			{
+				GroupDesc{entityCount,                  10.0f, RADIUS, speed},
+				GroupDesc{entityCount, world.height - 10.0f, RADIUS, speed},
+			},
+			matrix
+		);
+		scene.setBackend(backend);
+		scene.setSwept(swept);
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT_PER_RUN; ++i) {
+			scene.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		std::cout
+			<< label
+			<< " "
+			<< entityCount
+			<< " "
+			<< speed
+			<< " "
+			<< elapsed
+			<< " "
+			<< scene.getHitCount()
+			<< std::endl;
+		return elapsed;
+	}
+}
+
+void benchSwept() {
+	for (auto speed: SPEEDS) {
+		for (auto entityCount: SWEPT_ENTITY_COUNTS) {
+			const auto discrete = run("brute-force", entityCount, speed, Backend::BruteForce, false);
+			const auto swept = run("brute-force-swept", entityCount, speed, Backend::BruteForce, true);
+			std::cout << "ratio " << entityCount << " " << speed << " " << swept / discrete << std::endl;
+			const auto bitmap = run("bitmap", entityCount, speed, Backend::Bitmap, false);
+			const auto bitmapSwept = run("bitmap-swept", entityCount, speed, Backend::Bitmap, true);
+			std::cout << "ratio " << entityCount << " " << speed << " " << bitmapSwept / bitmap << std::endl;
+		}
+	}
+}
@@ -0,0 +1,107 @@
+#include "../bench.hpp"
+
+#include "../../../common/jobsystem.hpp"
+#include "../../../common/parallel.hpp"
+#include "../../../common/stopwatch.hpp"
+#include "../scene.hpp"
+#include "../worldbatch.hpp"
+
+#include <array>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+	constexpr std::array<size_t, 3> WORLD_COUNTS{64, 256, 1024};
+
+	constexpr int FRAME_COUNT = 200;
+
+	/// 一つの対戦に相当する、数百の物体からなるワールドの物体群
+	std::vector<GroupDesc> createMatchGroups() {
+		const auto &world = getDefaultWorld();
+		return {
+			GroupDesc{2,               world.height - 40.0f,  8.0f, 3.0f},
+			GroupDesc{120,             world.height - 80.0f,  3.0f, 8.0f},
+			GroupDesc{24,                             40.0f, 12.0f, 1.5f},
+			GroupDesc{160,                            80.0f,  4.0f, 2.5f},
+		};
+	}
+
+	InteractionMatrix createMatchMatrix() {
+		InteractionMatrix matrix;
+		matrix.set(0, 2);
+		matrix.set(0, 3);
+		matrix.set(1, 2);
+		return matrix;
+	}
+
+	void print(const char *name, size_t worldCount, double elapsed, unsigned long long hitCount) {
+		std::cout
+			<< name
+			<< " "
+			<< worldCount
+			<< " "
+			<< elapsed / FRAME_COUNT
+			<< " "
+			<< static_cast<double>(worldCount) * FRAME_COUNT / (elapsed / 1000.0)
+			<< " "
+			<< hitCount
+			<< std::endl;
+	}
+
+	/// ワールドごとにSceneを作り、ワールドを単位に並列に進める
+	void runScenes(size_t worldCount) {
+		const auto descs = createMatchGroups();
+		const auto matrix = createMatchMatrix();
+		std::vector<std::unique_ptr<Scene>> scenes;
+		for (size_t i = 0; i < worldCount; ++i) {
+			scenes.push_back(std::make_unique<Scene>(descs, matrix));
+		}
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			getJobSystem()->parallelFor(worldCount, [&](size_t begin, size_t end) {
+				for (auto w = begin; w < end; ++w) {
+					scenes[w]->update();
+				}
+			});
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		unsigned long long hitCount = 0;
+		for (const auto &n: scenes) {
+			hitCount += n->getHitCount();
+		}
+		print("scenes", worldCount, elapsed, hitCount);
+	}
+
+	void runBatch(size_t worldCount) {
+		WorldBatch batch(createMatchGroups(), createMatchMatrix(), worldCount);
+
+		const Stopwatch stopwatch;
+		for (int i = 0; i < FRAME_COUNT; ++i) {
+			batch.update();
+		}
+		const auto elapsed = stopwatch.elapsedMs();
+
+		print("batch", worldCount, elapsed, batch.getHitCount());
+	}
+}
+
+void benchWorlds() {
+	// 呼び出し側が設定していなければ、ハードウェアのスレッド数のジョブシステムを用いる
+	std::unique_ptr<JobSystem> system;
+	if (!getJobSystem()) {
+		system = std::make_unique<JobSystem>(getWorkerCount());
+		setJobSystem(system.get());
+	}
+	std::cout << "workers " << getWorkerCount() << std::endl;
+	for (auto worldCount: WORLD_COUNTS) {
+		runScenes(worldCount);
+		runBatch(worldCount);
+		cooldown();
+	}
+	if (system) {
+		setJobSystem(nullptr);
+	}
+}
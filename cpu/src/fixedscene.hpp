@@ -0,0 +1,122 @@
+#pragma once
+
+#include "../../common/common.hpp"
+#include "../../common/fixed.hpp"
+#include "../../common/jobsystem.hpp"
+#include "../../common/parallel.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+/// 固定小数点数で決定的に進めるシーン
+///
+/// 位置・速さはQ16.16、向きは表引きの角度で持ち、移動も衝突判定も整数演算だけで行う。
+/// そのためコンパイラや最適化の設定、ISAによらず、同じ設定からは同じ位置と衝突数とが得られる。
+/// 判定は相互作用行列に従った総当たりで、衝突数だけを求める。
+/// ジョブシステムが設定されていれば物体を区間に分けて並列に数えるが、整数の和のため結果は変わらない。
+///
+/// NOTE: ワールドの対角線の長さはFIXED_MAX_DIAGONAL以下であること。
+class FixedScene final {
+private:
+	FixedBounds _bounds;
+	std::vector<FixedGroup> _groups;
+	InteractionMatrix _matrix;
+	unsigned long long _hitCount;
+	std::atomic<unsigned long long> _concurrentHitCount;
+
+	/// 物体群bのj番目の物体と、自身より番号の小さい相互作用する物体群(と自身の物体群の[0, j))との衝突数
+	inline unsigned long long countLower(unsigned int b, uint32_t lower, bool self, size_t j) const {
+		const auto &gb = _groups[b];
+		unsigned long long hitCount = 0;
+		for (auto bits = lower; bits != 0; bits &= bits - 1) {
+			const auto a = static_cast<unsigned int>(std::countr_zero(bits));
+			hitCount += countFixedHits(_groups[a], 0, _groups[a].size(), gb.cx[j], gb.cy[j], gb.cr[j]);
+		}
+		if (self) {
+			hitCount += countFixedHits(gb, 0, j, gb.cx[j], gb.cy[j], gb.cr[j]);
+		}
+		return hitCount;
+	}
+
+public:
+	/// 物体群をdescsのとおりにワールドworldの中に生成したシーンを作る
+	explicit FixedScene(const std::vector<GroupDesc> &descs, const InteractionMatrix &matrix, const WorldBounds &world = getDefaultWorld()):
+		_bounds(toFixedBounds(world)),
+		_groups(descs.size()),
+		_matrix(matrix),
+		_hitCount(0),
+		_concurrentHitCount(0)
+	{
+		if (descs.size() > MAX_GROUP_COUNT) {
+			throw "too many groups.";
+		}
+		for (size_t g = 0; g < descs.size(); ++g) {
+			spawnFixedGroup(_groups[g], descs[g], static_cast<unsigned int>(g), _bounds);
+		}
+	}
+	FixedScene(const FixedScene &) = delete;
+	FixedScene(const FixedScene &&) = delete;
+	FixedScene &operator=(const FixedScene &) = delete;
+	FixedScene &&operator=(const FixedScene &&) = delete;
+	~FixedScene() = default;
+
+	void update() {
+		for (auto &n: _groups) {
+			n.update(_bounds);
+		}
+		auto *system = getJobSystem();
+		for (unsigned int b = 0; b < _groups.size(); ++b) {
+			const auto lower = _matrix.getRow(b) & ((1u << b) - 1);
+			const auto self = _matrix.interacts(b, b);
+			if (lower == 0 && !self) {
+				continue;
+			}
+			if (system) {
+				_concurrentHitCount.store(0, std::memory_order_relaxed);
+				system->parallelFor(_groups[b].size(), [&](size_t begin, size_t end) {
+					unsigned long long hitCount = 0;
+					for (auto j = begin; j < end; ++j) {
+						hitCount += countLower(b, lower, self, j);
+					}
+					_concurrentHitCount.fetch_add(hitCount, std::memory_order_relaxed);
+				}, 256);
+				_hitCount += _concurrentHitCount.load(std::memory_order_relaxed);
+			} else {
+				for (size_t j = 0; j < _groups[b].size(); ++j) {
+					_hitCount += countLower(b, lower, self, j);
+				}
+			}
+		}
+	}
+
+	inline unsigned long long getHitCount() const {
+		return _hitCount;
+	}
+	inline const FixedGroup &getGroup(unsigned int group) const {
+		return _groups[group];
+	}
+
+	/// 位置・向きと累計の衝突数とのチェックサム(64bitのFNV-1a)
+	///
+	/// 異なるビルドで同じ値になれば、シミュレーションがビット単位で一致している。
+	uint64_t getChecksum() const {
+		uint64_t hash = 14695981039346656037ull;
+		const auto mix = [&](uint64_t value) {
+			for (int i = 0; i < 8; ++i) {
+				hash ^= (value >> (i * 8)) & 0xff;
+				hash *= 1099511628211ull;
+			}
+		};
+		for (const auto &group: _groups) {
+			for (size_t i = 0; i < group.size(); ++i) {
+				mix(static_cast<uint32_t>(group.x[i]));
+				mix(static_cast<uint32_t>(group.y[i]));
+				mix(group.angle[i]);
+			}
+		}
+		mix(_hitCount);
+		return hash;
+	}
+};
@@ -1,64 +1,121 @@
-#include "../../common/common.hpp"
+#include "bench.hpp"
+
+#include "../../common/jobsystem.hpp"
+#include "../../common/parallel.hpp"
+#include "../../common/stopwatch.hpp"
+#include "../../common/world.hpp"
 
 #include <array>
+#include <chrono>
 #include <iostream>
-#include <Windows.h>
+#include <memory>
+#include <string>
+#include <string_view>
 
-class Entity final: public EntityBase {
-public:
-	Entity(float x, float y, float r, float spd, float dir): EntityBase(x, y, r, spd, dir) {}
-	bool isHit(const Entity &opponent) const {
-		const auto dx = _x - opponent._x;
-		const auto dy = _y - opponent._y;
-		const auto rr = _r + opponent._r;
-		return dx * dx + dy * dy < rr * rr;
-	}
-};
+namespace {
+	struct Benchmark {
+		std::string_view name;
+		void (*run)();
+	};
 
-class Scene final: public SceneBase<Entity> {
-public:
-	explicit Scene(size_t entityCount): SceneBase(entityCount) {}
-	void update() {
-		for (auto &n: _entities1) {
-			n.update();
+	constexpr std::array<Benchmark, 25> BENCHMARKS{
+		Benchmark{"collision", benchCollision},
+		Benchmark{"contacts", benchContacts},
+		Benchmark{"groups", benchGroups},
+		Benchmark{"asymmetric", benchAsymmetric},
+		Benchmark{"graze", benchGraze},
+		Benchmark{"swept", benchSwept},
+		Benchmark{"aabb-tree", benchAabbTree},
+		Benchmark{"lbvh", benchLbvh},
+		Benchmark{"radix-sort", benchRadixSort},
+		Benchmark{"reorder", benchReorder},
+		Benchmark{"jobs", benchJobs},
+		Benchmark{"pipeline", benchPipeline},
+		Benchmark{"worlds", benchWorlds},
+		Benchmark{"rollback", benchRollback},
+		Benchmark{"fixed", benchFixed},
+		Benchmark{"queries", benchQueries},
+		Benchmark{"rays", benchRays},
+		Benchmark{"masks", benchMasks},
+		Benchmark{"rotation", benchRotation},
+		Benchmark{"footprints", benchFootprints},
+		Benchmark{"coverage", benchCoverage},
+		Benchmark{"resolution", benchResolution},
+		Benchmark{"large-world", benchLargeWorld},
+		Benchmark{"sparse-bitmap", benchSparseBitmap},
+		Benchmark{"lod", benchLod},
+	};
+
+	/// 計測全体での、ワーカーごとの稼働率を出力する関数
+	void printUtilization(const JobSystem &system) {
+		const auto stats = system.getStats();
+		for (size_t i = 0; i < stats.size(); ++i) {
+			std::cout
+				<< "worker "
+				<< i
+				<< " "
+				<< stats[i].utilization
+				<< " "
+				<< stats[i].jobCount
+				<< " "
+				<< stats[i].stealCount
+				<< std::endl;
 		}
-		for (auto &n: _entities2) {
-			n.update();
-			for (auto &m: _entities1) {
-				if (n.isHit(m)) {
-					SceneBase::incrementHitCount();
-				}
+	}
+}
+
+/// 第一引数で計測の種類を選ぶ。省略した場合は"collision"を行う。
+///
+/// 続く引数で次を設定できる：
+/// - `--jobs N` : N個のワーカーのジョブシステムで並列に処理し、終了時にワーカーごとの稼働率を出力する
+/// - `--cooldown MS` : 計測の合間に待機する時間(ミリ秒)
+/// - `--world WxH` : 物体や問い合わせを置くワールドの大きさ (既定は画面と同じ大きさ。対応しない計測では例外を投げる)
+///
+/// 計測が例外を投げた場合(固定小数点のチェックサムの不一致など)は、メッセージを出力して1を返す。
+int main(int argc, char *argv[]) {
+	std::string_view name = "collision";
+	unsigned int workerCount = 0;
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--jobs" && i + 1 < argc) {
+			workerCount = static_cast<unsigned int>(std::stoul(argv[++i]));
+		} else if (arg == "--cooldown" && i + 1 < argc) {
+			setCooldown(std::chrono::milliseconds(std::stoul(argv[++i])));
+		} else if (arg == "--world" && i + 1 < argc) {
+			try {
+				setDefaultWorld(parseWorld(argv[++i]));
+			} catch (const char *message) {
+				std::cerr << "error: " << message << std::endl;
+				return 1;
 			}
+		} else {
+			name = arg;
 		}
 	}
-};
-
-int main() {
-	constexpr std::array<size_t, 7> entityCounts{100, 500, 1000, 2000, 3000, 4000, 5000};
-	for (auto entityCount: entityCounts) {
-		Scene scene(entityCount);
-
-		LARGE_INTEGER freq;
-		QueryPerformanceFrequency(&freq);
-		LARGE_INTEGER before;
-		QueryPerformanceCounter(&before);
-
-		for (int i = 0; i < 1000; ++i) {
-			scene.update();
+	for (const auto &n: BENCHMARKS) {
+		if (n.name == name) {
+			std::unique_ptr<JobSystem> system;
+			if (workerCount > 0) {
+				system = std::make_unique<JobSystem>(workerCount);
+				setJobSystem(system.get());
+			}
+			try {
+				n.run();
+			} catch (const char *message) {
+				setJobSystem(nullptr);
+				std::cerr << "error: " << message << std::endl;
+				return 1;
+			}
+			if (system) {
+				setJobSystem(nullptr);
+				printUtilization(*system);
+			}
+			return 0;
 		}
-
-		LARGE_INTEGER after;
-		QueryPerformanceCounter(&after);
-
-		std::cout
-			<< entityCount
-			<< " "
-			<< (static_cast<double>(after.QuadPart - before.QuadPart) * 1000.0 / static_cast<double>(freq.QuadPart))
-			<< " "
-			<< scene.getHitCount()
-			<< std::endl;
-
-		// NOTE: 念のため、CPUを冷ますために2秒待つ。
-		Sleep(2000);
 	}
+	std::cerr << "unknown benchmark: " << name << std::endl;
+	for (const auto &n: BENCHMARKS) {
+		std::cerr << "  " << n.name << std::endl;
+	}
+	return 1;
 }
@@ -0,0 +1,1424 @@
+#pragma once
+
+#include "../../common/aabbtree.hpp"
+#include "../../common/common.hpp"
+#include "../../common/curve.hpp"
+#include "../../common/jobsystem.hpp"
+#include "../../common/lbvh.hpp"
+#include "../../common/lod.hpp"
+#include "../../common/parallel.hpp"
+#include "../../common/query.hpp"
+#include "../../common/radixsort.hpp"
+#include "../../common/snapshot.hpp"
+#include "../../common/stopwatch.hpp"
+#include "../../common/sweep.hpp"
+#include "../../common/tiledbitmap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <optional>
+
+/// 問い合わせ側として掃引する物体群の物体数の既定の上限
+constexpr size_t SWEEP_QUERIER_LIMIT = 16;
+
+/// 物体の並びを空間充填曲線の順に入れ替える既定の間隔(フレーム数)
+constexpr unsigned int REORDER_INTERVAL = 16;
+
+/// ジョブシステムで物体を分けて処理するときの区間の最小の大きさ
+constexpr size_t SCENE_MIN_GRAIN = 256;
+
+/// パイプライン実行で同時に保持するフレーム数
+///
+/// 移動(N+1)、描画(N)、問い合わせ(N-1)の三段。
+constexpr size_t PIPELINE_DEPTH = 3;
+
+/// k近傍の問い合わせで最初に探す円の半径
+///
+/// 木で候補を絞れる場合、k個見つかるまで半径を倍にして探し直す。
+constexpr float QUERY_NEAREST_RADIUS = 32.0f;
+
+/// 衝突判定の方式
+enum class Backend {
+	/// 物体の組ごとに円どうしの重なりを調べる
+	BruteForce,
+	/// CPU上で描画した衝突判定ビットマップを調べる
+	///
+	/// GPU版と同じく、衝突した相手の物体群しか分からないため衝突フラグのみ書き出す。
+	/// 形のアトラスが設定されていれば物体をその形で描画し、調べる。
+	/// 大きなワールドでは、ビットマップを物体のいる区画だけ確保する(TiledBitmapを参照)。
+	Bitmap,
+	/// 動的AABB木で候補を絞ってから円どうしの重なりを調べる
+	///
+	/// 半径の大きさがまちまちなシーン向け。木は物体群ごとに持つ。
+	AabbTree,
+	/// 毎フレーム作り直すLBVHで候補を絞ってから円どうしの重なりを調べる
+	///
+	/// 物体数の多いシーン向け。構築と問い合わせとを並列に行う。
+	/// NOTE: 衝突ペア・衝突フラグを書き出す場合、問い合わせは単一のスレッドで行う。
+	Lbvh,
+};
+
+class Scene final: public SceneBase {
+public:
+	/// パイプライン実行の段
+	enum Stage: unsigned int {
+		/// 物体を移動させ、位置を写し取る
+		INTEGRATE,
+		/// 写し取った位置を衝突判定ビットマップに描画する
+		DRAW,
+		/// 描画済みのビットマップに問い合わせる
+		QUERY,
+	};
+
+private:
+	/// パイプライン実行で1フレーム分の物体の位置を保持する領域
+	///
+	/// 並びの入れ替えに備えて、位置から物体の番号への表も写し取る。
+	struct PipelineFrame {
+		std::vector<EntityGroup> groups;
+		std::vector<std::vector<uint32_t>> handles;
+	};
+
+	Backend _backend;
+	std::unique_ptr<TiledBitmap> _bitmap;
+	/// 衝突判定ビットマップの、ワールドの1単位あたりの画素数
+	float _bitmapScale;
+	/// _bitmapにすべての物体群が現在の位置で描画されているか
+	bool _bitmapCurrent;
+	/// _bitmapの粗い占有格子が描画に合っているか
+	bool _occupancyCurrent;
+	size_t _sweepLimit;
+	bool _swept;
+	std::vector<unsigned long long> _sweepCounts;
+	std::vector<EntityGroup> _sweptBounds;
+	std::vector<std::unique_ptr<AabbTree>> _trees;
+	std::vector<std::vector<int>> _proxies;
+	size_t _reinsertCount;
+	std::vector<std::unique_ptr<Lbvh>> _bvhs;
+	uint32_t _queryGroups;
+	/// 動的AABB木・LBVHが物体群の現在の位置に合っているか
+	bool _queryIndexReady;
+	std::vector<unsigned long long> _chunkHitCounts;
+	SpatialOrder _spatialOrder;
+	unsigned int _reorderInterval;
+	unsigned long long _frameCount;
+	RadixSorter<11> _reorderSorter;
+	std::vector<uint32_t> _reorderKeys;
+	std::vector<uint32_t> _reorderOrder;
+	std::vector<int> _proxyScratch;
+	std::unique_ptr<TaskGraph> _bitmapGraph;
+	std::atomic<unsigned long long> _concurrentHitCount;
+	bool _pipelined;
+	unsigned long long _pipelineCount;
+	std::array<PipelineFrame, PIPELINE_DEPTH> _pipelineFrames;
+	std::array<std::unique_ptr<TiledBitmap>, PIPELINE_DEPTH - 1> _pipelineBitmaps;
+	std::unique_ptr<TaskGraph> _pipelineGraph;
+	std::array<double, PIPELINE_DEPTH> _stageMs;
+	std::optional<LodDesc> _lod;
+	std::vector<InterestPoint> _interestPoints;
+	std::unique_ptr<CoarseGrid> _coarseGrid;
+	/// 物体群ごとの、関心点の近くの物体か
+	std::vector<std::vector<uint8_t>> _lodNear;
+	/// 物体群ごとの、詳細に判定する物体と重なりうる物体の位置
+	///
+	/// 関心点の近くの物体を先に、その周りの物体を後に並べる。
+	std::vector<std::vector<uint32_t>> _lodZones;
+	/// 物体群ごとの、_lodZonesのうち関心点の近くの物体の数
+	std::vector<size_t> _lodNearCounts;
+	/// _lodZonesの物体を写し取った物体群 (ビットマップでの判定で描画する)
+	std::vector<EntityGroup> _lodGroups;
+
+	/// 物体群aとbとのどちらかが少数ならば、掃引で判定するか
+	inline bool isSweepPair(unsigned int a, unsigned int b) const {
+		return a != b && std::min(_groups[a].size(), _groups[b].size()) <= _sweepLimit;
+	}
+
+	/// 物体群aとbとを、物体数の少ない方を問い合わせ側として掃引で判定する関数
+	template<bool EMIT>
+	void sweep(unsigned int a, unsigned int b) {
+		const auto swapped = _groups[a].size() > _groups[b].size();
+		const auto qg = swapped ? b : a;
+		const auto tg = swapped ? a : b;
+		const auto &queriers = _groups[qg];
+		const auto &targets = _groups[tg];
+		if (_sweepCounts.size() < queriers.size()) {
+			_sweepCounts.resize(queriers.size());
+		}
+		if (_swept) {
+			sweepCountSwept(queriers, targets, _sweptBounds[qg], _sweptBounds[tg], _sweepCounts.data());
+		} else {
+			sweepCount(queriers, targets, _sweepCounts.data());
+		}
+		for (size_t q = 0; q < queriers.size(); ++q) {
+			if (_sweepCounts[q] == 0) {
+				continue;
+			}
+			_hitCount += _sweepCounts[q];
+			if constexpr (EMIT) {
+				const auto emit = [&](size_t t) {
+					const auto ia = swapped ? t : q;
+					const auto ib = swapped ? q : t;
+					SceneBase::emitContact(a, ia, b, ib);
+				};
+				if (_swept) {
+					sweepEmitSwept(targets, queriers, q, emit);
+				} else {
+					sweepEmit(targets, queriers.x[q], queriers.y[q], queriers.r[q], emit);
+				}
+			}
+		}
+	}
+
+	/// 掃引判定で、物体群bのj番目の物体と物体群aの[begin, end)の物体との移動全体を囲む円が一つも重ならないか
+	///
+	/// 重ならなければ掃引判定を省ける。
+	inline bool isSweptBoundsMiss(unsigned int a, size_t begin, size_t end, unsigned int b, size_t j) const {
+		const auto &ba = _sweptBounds[a];
+		const auto &bb = _sweptBounds[b];
+		return countHits(ba, begin, end, bb.x[j], bb.y[j], bb.r[j]) == 0;
+	}
+
+	/// 物体群bのj番目の物体と物体群aの[begin, end)の物体とが衝突している数を返す関数
+	///
+	/// 状態を変えないため、複数のスレッドから同時に呼べる。
+	inline unsigned long long count(unsigned int a, size_t begin, size_t end, unsigned int b, size_t j) const {
+		const auto &ga = _groups[a];
+		const auto &gb = _groups[b];
+		if (!_swept) {
+			return countHits(ga, begin, end, gb.x[j], gb.y[j], gb.r[j]);
+		}
+		if (isSweptBoundsMiss(a, begin, end, b, j)) {
+			return 0;
+		}
+		return countSweptHits(ga, begin, end, gb.px[j], gb.py[j], gb.x[j], gb.y[j], gb.r[j]);
+	}
+
+	/// 物体群bのj番目の物体と物体群aの[begin, end)の物体との衝突判定を行う関数
+	template<bool EMIT>
+	inline void collide(unsigned int a, size_t begin, size_t end, unsigned int b, size_t j) {
+		if constexpr (!EMIT) {
+			_hitCount += count(a, begin, end, b, j);
+		} else {
+			if (_swept && isSweptBoundsMiss(a, begin, end, b, j)) {
+				return;
+			}
+			for (size_t i = begin; i < end; ++i) {
+				if (!isHit(a, i, b, j)) {
+					continue;
+				}
+				SceneBase::incrementHitCount();
+				SceneBase::emitContact(a, i, b, j);
+			}
+		}
+	}
+
+	/// 衝突判定を行うすべての物体群の組を一度の走査で判定する関数
+	///
+	/// 各物体について、相互作用行列の行のうち自身より番号の小さい物体群(と自身の物体群)だけを調べる。
+	/// 一方が少数の物体群の組は、物体ごとの走査から外して掃引で判定する。
+	template<bool EMIT>
+	void collideAll() {
+		for (unsigned int b = 0; b < _groups.size(); ++b) {
+			const auto row = _matrix.getRow(b);
+			auto lower = row & ((1u << b) - 1);
+			const auto self = _matrix.interacts(b, b);
+			for (auto bits = lower; bits != 0; bits &= bits - 1) {
+				const auto a = static_cast<unsigned int>(std::countr_zero(bits));
+				if (isSweepPair(a, b)) {
+					sweep<EMIT>(a, b);
+					lower &= ~(1u << a);
+				}
+			}
+			if (lower == 0 && !self) {
+				continue;
+			}
+			auto *system = getJobSystem();
+			if (!EMIT && system) {
+				// 衝突数だけならば、物体群bの物体を区間に分けて並列に数える
+				_concurrentHitCount.store(0, std::memory_order_relaxed);
+				system->parallelFor(_groups[b].size(), [&](size_t begin, size_t end) {
+					unsigned long long hitCount = 0;
+					for (auto j = begin; j < end; ++j) {
+						for (auto bits = lower; bits != 0; bits &= bits - 1) {
+							const auto a = static_cast<unsigned int>(std::countr_zero(bits));
+							hitCount += count(a, 0, _groups[a].size(), b, j);
+						}
+						if (self) {
+							hitCount += count(b, 0, j, b, j);
+						}
+					}
+					_concurrentHitCount.fetch_add(hitCount, std::memory_order_relaxed);
+				}, SCENE_MIN_GRAIN);
+				_hitCount += _concurrentHitCount.load(std::memory_order_relaxed);
+				continue;
+			}
+			for (size_t j = 0; j < _groups[b].size(); ++j) {
+				for (auto bits = lower; bits != 0; bits &= bits - 1) {
+					const auto a = static_cast<unsigned int>(std::countr_zero(bits));
+					collide<EMIT>(a, 0, _groups[a].size(), b, j);
+				}
+				if (self) {
+					collide<EMIT>(b, 0, j, b, j);
+				}
+			}
+		}
+	}
+
+	/// 物体群gのi番目の物体がこのフレームで占める箱を求める関数
+	///
+	/// 掃引判定ならば直前の位置の円も含める。
+	inline Aabb getEntityBox(unsigned int g, size_t i) const {
+		const auto &group = _groups[g];
+		const auto box = Aabb::ofCircle(group.x[i], group.y[i], group.r[i]);
+		return _swept ? Aabb::merge(box, Aabb::ofCircle(group.px[i], group.py[i], group.r[i])) : box;
+	}
+
+	/// 物体群ごとの動的AABB木を移動後の物体に合わせる関数
+	///
+	/// 初回はすべての物体を挿入する。以後は太らせた箱からはみ出した物体だけが入れ直される。
+	void updateTrees() {
+		_reinsertCount = 0;
+		if (_trees.empty()) {
+			_trees.resize(_groups.size());
+			_proxies.resize(_groups.size());
+			for (unsigned int g = 0; g < _groups.size(); ++g) {
+				_trees[g] = std::make_unique<AabbTree>();
+				_proxies[g].resize(_groups[g].size());
+				for (size_t i = 0; i < _groups[g].size(); ++i) {
+					_proxies[g][i] = _trees[g]->createProxy(getEntityBox(g, i), static_cast<uint32_t>(i));
+				}
+			}
+			return;
+		}
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			const auto &group = _groups[g];
+			for (size_t i = 0; i < group.size(); ++i) {
+				const auto dx = group.x[i] - group.px[i];
+				const auto dy = group.y[i] - group.py[i];
+				if (_trees[g]->moveProxy(_proxies[g][i], getEntityBox(g, i), dx, dy)) {
+					_reinsertCount += 1;
+				}
+			}
+		}
+	}
+
+	/// 動的AABB木を用いて判定する関数
+	///
+	/// 各物体の箱で、相互作用行列の行のうち自身より番号の小さい物体群の木(と自身の物体群の木)に問い合わせ、
+	/// 候補とだけ円どうしで判定する。木を物体群ごとに分けるため、相手でない物体群の節は辿らない。
+	template<bool EMIT>
+	void collideTree() {
+		updateTrees();
+		_queryIndexReady = true;
+		for (unsigned int b = 0; b < _groups.size(); ++b) {
+			const auto row = _matrix.getRow(b);
+			const auto lower = row & ((1u << b) - 1);
+			const auto self = _matrix.interacts(b, b);
+			if (lower == 0 && !self) {
+				continue;
+			}
+			for (size_t j = 0; j < _groups[b].size(); ++j) {
+				const auto box = getEntityBox(b, j);
+				for (auto bits = lower; bits != 0; bits &= bits - 1) {
+					const auto a = static_cast<unsigned int>(std::countr_zero(bits));
+					_trees[a]->query(box, [&](uint32_t i) { collide<EMIT>(a, i, i + 1, b, j); });
+				}
+				if (self) {
+					_trees[b]->query(box, [&](uint32_t i) {
+						if (i < j) {
+							collide<EMIT>(b, i, i + 1, b, j);
+						}
+					});
+				}
+			}
+		}
+	}
+
+	/// 物体群aのi番目の物体と物体群bのj番目の物体とが衝突しているか
+	inline bool isHit(unsigned int a, size_t i, unsigned int b, size_t j) const {
+		const auto &ga = _groups[a];
+		const auto &gb = _groups[b];
+		return _swept
+			? countSweptHits(ga, i, i + 1, gb.px[j], gb.py[j], gb.x[j], gb.y[j], gb.r[j]) != 0
+			: countHits(ga, i, i + 1, gb.x[j], gb.y[j], gb.r[j]) != 0;
+	}
+
+	/// LBVHを用いて判定する関数
+	///
+	/// 問い合わせを受ける物体群(自身より番号の大きい物体群と相互作用するか、自身と相互作用する物体群)の木を作り直し、
+	/// 各物体の箱で相互作用行列の行のうち自身より番号の小さい物体群(と自身の物体群)の木に問い合わせる。
+	/// setQueryGroups()で指定された物体群の木も、問い合わせのために作り直す。
+	template<bool EMIT>
+	void collideLbvh() {
+		_bvhs.resize(_groups.size());
+		for (unsigned int a = 0; a < _groups.size(); ++a) {
+			if ((_matrix.getRow(a) & ~((1u << a) - 1)) == 0 && ((_queryGroups >> a) & 1) == 0) {
+				// 作り直さない木は位置に合わなくなるため捨てる
+				_bvhs[a].reset();
+				continue;
+			}
+			if (!_bvhs[a]) {
+				_bvhs[a] = std::make_unique<Lbvh>();
+			}
+			_bvhs[a]->build(_groups[a].size(), [&](size_t i) { return getEntityBox(a, i); }, _world);
+		}
+		_queryIndexReady = true;
+		for (unsigned int b = 0; b < _groups.size(); ++b) {
+			const auto row = _matrix.getRow(b);
+			const auto lower = row & ((1u << b) - 1);
+			const auto self = _matrix.interacts(b, b);
+			if (lower == 0 && !self) {
+				continue;
+			}
+			// [begin, end)の物体について、衝突している相手をfに渡す
+			const auto queryRange = [&](size_t begin, size_t end, auto f) {
+				for (size_t j = begin; j < end; ++j) {
+					const auto box = getEntityBox(b, j);
+					for (auto bits = lower; bits != 0; bits &= bits - 1) {
+						const auto a = static_cast<unsigned int>(std::countr_zero(bits));
+						_bvhs[a]->query(box, [&](uint32_t i) {
+							if (isHit(a, i, b, j)) {
+								f(a, i, j);
+							}
+						});
+					}
+					if (self) {
+						_bvhs[b]->query(box, [&](uint32_t i) {
+							if (i < j && isHit(b, i, b, j)) {
+								f(b, i, j);
+							}
+						});
+					}
+				}
+			};
+			const auto count = _groups[b].size();
+			if constexpr (EMIT) {
+				queryRange(0, count, [&](unsigned int a, size_t i, size_t j) {
+					SceneBase::incrementHitCount();
+					SceneBase::emitContact(a, i, b, j);
+				});
+			} else {
+				_chunkHitCounts.assign(getChunkCount(count), 0);
+				parallelFor(count, [&](size_t begin, size_t end, size_t chunk) {
+					unsigned long long hitCount = 0;
+					queryRange(begin, end, [&](unsigned int, size_t, size_t) { hitCount += 1; });
+					_chunkHitCounts[chunk] = hitCount;
+				});
+				for (const auto n: _chunkHitCounts) {
+					_hitCount += n;
+				}
+			}
+		}
+	}
+
+	/// 物体群ごとに、物体の並びを空間充填曲線の順に入れ替える関数
+	///
+	/// 動的AABB木の葉は物体の位置を持つため、葉の表も同じく入れ替えて葉の持つ位置を付け直す。
+	void reorder() {
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			const auto &group = _groups[g];
+			const auto n = group.size();
+			_reorderKeys.resize(n);
+			_reorderOrder.resize(n);
+			for (size_t i = 0; i < n; ++i) {
+				_reorderKeys[i] = getCurveCode(_spatialOrder, group.x[i], group.y[i], _world);
+				_reorderOrder[i] = static_cast<uint32_t>(i);
+			}
+			_reorderSorter.sort(_reorderKeys.data(), _reorderOrder.data(), n);
+			SceneBase::permuteGroup(g, _reorderOrder.data());
+			if (g < _trees.size()) {
+				auto &proxies = _proxies[g];
+				_proxyScratch.resize(n);
+				for (size_t i = 0; i < n; ++i) {
+					_proxyScratch[i] = proxies[_reorderOrder[i]];
+					_trees[g]->setProxyId(_proxyScratch[i], static_cast<uint32_t>(i));
+				}
+				std::swap(proxies, _proxyScratch);
+			}
+		}
+	}
+
+	/// 倍率_bitmapScaleでワールド全体を覆う衝突判定ビットマップを作る関数
+	///
+	/// 足跡の表と画素の覆い方の規則とは作るときに渡し、以後はsetFootprints()・setCoverage()で変わったときだけ渡し直す。
+	inline std::unique_ptr<TiledBitmap> createBitmap() const {
+		auto bitmap = std::make_unique<TiledBitmap>(_world, static_cast<unsigned int>(_groups.size()), _bitmapScale);
+		bitmap->setFootprints(_footprints);
+		bitmap->setCoverage(_coverage);
+		return bitmap;
+	}
+
+	inline TiledBitmap &getBitmap() {
+		if (!_bitmap) {
+			_bitmap = createBitmap();
+		}
+		return *_bitmap;
+	}
+
+	/// 作ってある衝突判定ビットマップ(パイプライン実行のものも含む)ごとにfを呼ぶ関数
+	template<typename F>
+	inline void forEachBitmap(F f) {
+		if (_bitmap) {
+			f(*_bitmap);
+		}
+		for (auto &bitmap: _pipelineBitmaps) {
+			if (bitmap) {
+				f(*bitmap);
+			}
+		}
+	}
+
+	/// ビットマップbitmapの物体群gの面に、groupの物体を描画する関数
+	///
+	/// NOTE: 掃引判定では形によらず、外接する円を動かしたカプセルとして描画する。
+	void drawBitmapGroup(TiledBitmap &bitmap, unsigned int g, const EntityGroup &group) const {
+		if (_swept) {
+			bitmap.drawGroupSwept(g, group);
+		} else {
+			bitmap.drawGroup(g, group, _atlas);
+		}
+	}
+
+	/// 物体群gの物体groupのうち[begin, end)の物体が、ビットマップbitmapのmaskの物体群の面と重なっている数を数える関数
+	///
+	/// fは重なっている物体の位置を受け取る。
+	template<typename F>
+	unsigned long long queryBitmapRange(
+		const TiledBitmap &bitmap,
+		const EntityGroup &group,
+		uint32_t mask,
+		size_t begin,
+		size_t end,
+		F f
+	) const {
+		unsigned long long hitCount = 0;
+		for (auto i = begin; i < end; ++i) {
+			uint32_t found = 0;
+			if (_swept) {
+				found = bitmap.overlapCapsule(group.px[i], group.py[i], group.x[i], group.y[i], group.r[i], mask);
+			} else if (_atlas && group.shape[i] != SHAPE_CIRCLE) {
+				found = bitmap.overlapMask(*_atlas, group.shape[i], group.x[i], group.y[i], group.r[i], group.angle[i], mask);
+			} else {
+				found = bitmap.overlapDisk(group.x[i], group.y[i], group.r[i], mask);
+			}
+			if (found != 0) {
+				hitCount += std::popcount(found);
+				f(i);
+			}
+		}
+		return hitCount;
+	}
+
+	/// ジョブシステムで衝突判定ビットマップを用いて判定するタスクグラフを作る関数
+	///
+	/// 物体群ごとに「面を消して描画する」タスクと「物体ごとに調べる」タスクとを作り、
+	/// 調べるタスクは相互作用行列の行の物体群を描画し終えてから始める。面ごとの描画は互いに独立に進む。
+	/// タスクはbitmapの自身の面だけを書き換え、設定は読むだけにする。
+	/// WARN: 実行する前に、TiledBitmap::prepare()で描画する区画を確保しておくこと。bitmapを作り直したらグラフも作り直すこと。
+	void buildBitmapGraph(TiledBitmap &bitmap) {
+		_bitmapGraph = std::make_unique<TaskGraph>();
+		std::vector<size_t> draws;
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			draws.push_back(_bitmapGraph->add([this, &bitmap, g]() {
+				bitmap.clear(g);
+				drawBitmapGroup(bitmap, g, _groups[g]);
+			}));
+		}
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			const auto mask = _matrix.getRow(g) & ~(1u << g);
+			if (mask == 0) {
+				continue;
+			}
+			const auto query = _bitmapGraph->add([this, &bitmap, g, mask]() {
+				getJobSystem()->parallelFor(_groups[g].size(), [&](size_t begin, size_t end) {
+					const auto hitCount = queryBitmapRange(bitmap, _groups[g], mask, begin, end, [&](size_t i) {
+						SceneBase::emitHitConcurrent(g, i);
+					});
+					_concurrentHitCount.fetch_add(hitCount, std::memory_order_relaxed);
+				}, SCENE_MIN_GRAIN);
+			});
+			for (auto bits = mask; bits != 0; bits &= bits - 1) {
+				_bitmapGraph->precede(draws[std::countr_zero(bits)], query);
+			}
+		}
+	}
+
+	/// 衝突判定ビットマップを用いて判定する関数
+	///
+	/// すべての物体群を描画してから、各物体が相互作用行列の行の物体群と重なっているか調べる。
+	/// 自身の物体群との衝突判定は行わない。
+	/// ジョブシステムが設定されていれば、描画と問い合わせとをタスクグラフとして実行する。
+	void collideBitmap() {
+		auto &bitmap = getBitmap();
+		bitmap.prepare(_groups, _swept);
+		if (auto *system = getJobSystem()) {
+			if (!_bitmapGraph) {
+				buildBitmapGraph(bitmap);
+			}
+			_concurrentHitCount.store(0, std::memory_order_relaxed);
+			_bitmapGraph->run(*system);
+			_hitCount += _concurrentHitCount.load(std::memory_order_relaxed);
+			_bitmapCurrent = true;
+			return;
+		}
+		bitmap.clear();
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			drawBitmapGroup(bitmap, g, _groups[g]);
+		}
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			const auto mask = _matrix.getRow(g) & ~(1u << g);
+			if (mask == 0) {
+				continue;
+			}
+			const auto &group = _groups[g];
+			_hitCount += queryBitmapRange(bitmap, group, mask, 0, group.size(), [&](size_t i) { SceneBase::emitHit(g, i); });
+		}
+		_bitmapCurrent = true;
+	}
+
+	/// 物体を移動させ、必要ならば並びを入れ替える関数
+	void integrate() {
+		_queryIndexReady = false;
+		_bitmapCurrent = false;
+		_occupancyCurrent = false;
+		auto *system = getJobSystem();
+		for (auto &n: _groups) {
+			if (system) {
+				system->parallelFor(n.size(), [&](size_t begin, size_t end) { n.update(begin, end, _world); }, SCENE_MIN_GRAIN);
+			} else {
+				n.update(_world);
+			}
+		}
+		if (_spatialOrder != SpatialOrder::None && _frameCount % _reorderInterval == 0) {
+			reorder();
+		}
+		_frameCount += 1;
+	}
+
+	/// パイプライン実行で、frame番目のフレームの位置などを書き込む領域
+	inline PipelineFrame &getPipelineFrame(unsigned long long frame) {
+		return _pipelineFrames[frame % PIPELINE_DEPTH];
+	}
+
+	/// パイプライン実行で、frame番目のフレームを描画するビットマップ
+	inline TiledBitmap &getPipelineBitmap(unsigned long long frame) {
+		auto &bitmap = _pipelineBitmaps[frame % _pipelineBitmaps.size()];
+		if (!bitmap) {
+			bitmap = createBitmap();
+		}
+		return *bitmap;
+	}
+
+	/// 移動の段：物体を移動させ、判定に用いる位置と番号の表とをframeに写し取る関数
+	void integrateStage(PipelineFrame &frame) {
+		integrate();
+		frame.groups.resize(_groups.size());
+		frame.handles.resize(_groups.size());
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			const auto &src = _groups[g];
+			auto &dst = frame.groups[g];
+			dst.x.assign(src.x.begin(), src.x.end());
+			dst.y.assign(src.y.begin(), src.y.end());
+			dst.r.assign(src.r.begin(), src.r.end());
+			dst.px.assign(src.px.begin(), src.px.end());
+			dst.py.assign(src.py.begin(), src.py.end());
+			dst.shape.assign(src.shape.begin(), src.shape.end());
+			dst.angle.assign(src.angle.begin(), src.angle.end());
+			frame.handles[g].assign(_handles[g].begin(), _handles[g].end());
+		}
+	}
+
+	/// 描画の段：frameの物体をbitmapに描画する関数
+	///
+	/// ジョブシステムがあれば物体群の面ごとに並列に描画する。
+	void drawStage(const PipelineFrame &frame, TiledBitmap &bitmap) {
+		bitmap.prepare(frame.groups, _swept);
+		const auto draw = [&](size_t begin, size_t end) {
+			for (auto g = static_cast<unsigned int>(begin); g < end; ++g) {
+				bitmap.clear(g);
+				drawBitmapGroup(bitmap, g, frame.groups[g]);
+			}
+		};
+		if (auto *system = getJobSystem()) {
+			system->parallelFor(frame.groups.size(), draw);
+		} else {
+			draw(0, frame.groups.size());
+		}
+	}
+
+	/// 問い合わせの段：frameの物体がbitmapの相互作用行列の行の物体群と重なっているか調べる関数
+	///
+	/// 衝突フラグはframeに写し取った番号の表で立てる。かすり判定もこの段で行う。
+	void queryStage(const PipelineFrame &frame, TiledBitmap &bitmap) {
+		auto *system = getJobSystem();
+		for (unsigned int g = 0; g < frame.groups.size(); ++g) {
+			const auto mask = _matrix.getRow(g) & ~(1u << g);
+			if (mask == 0) {
+				continue;
+			}
+			const auto &group = frame.groups[g];
+			const auto query = [&](size_t begin, size_t end) {
+				const auto hitCount = queryBitmapRange(bitmap, group, mask, begin, end, [&](size_t i) {
+					if (_hits) {
+						_hits[g].setConcurrent(frame.handles[g][i]);
+					}
+				});
+				_concurrentHitCount.fetch_add(hitCount, std::memory_order_relaxed);
+			};
+			if (system) {
+				system->parallelFor(group.size(), query, SCENE_MIN_GRAIN);
+			} else {
+				query(0, group.size());
+			}
+		}
+		if (_graze) {
+			graze(bitmap, frame.groups);
+		}
+	}
+
+	/// パイプライン実行の段stageを、今回の呼び出しで受け持つフレームについて実行する関数
+	void runStage(Stage stage) {
+		const auto k = _pipelineCount;
+		if (k < stage) {
+			return;
+		}
+		const Stopwatch stopwatch;
+		auto &frame = getPipelineFrame(k - stage);
+		if (stage == INTEGRATE) {
+			integrateStage(frame);
+		} else if (stage == DRAW) {
+			drawStage(frame, getPipelineBitmap(k - stage));
+		} else {
+			queryStage(frame, getPipelineBitmap(k - stage));
+		}
+		_stageMs[stage] += stopwatch.elapsedMs();
+	}
+
+	/// パイプライン実行で1フレーム進める関数
+	///
+	/// k回目の呼び出しでは、k番目のフレームへの移動と、k - 1番目のフレームの描画と、
+	/// k - 2番目のフレームへの問い合わせとを行う。三つの段は別々の領域だけを読み書きするため、
+	/// ジョブシステムがあればタスクグラフとして同時に実行する。
+	void updatePipelined() {
+		if (_backend != Backend::Bitmap) {
+			throw "pipelined execution requires the bitmap backend.";
+		}
+		if (_lod) {
+			throw "LOD collision is not supported in pipelined execution.";
+		}
+		SceneBase::clearContactOutput();
+		// 描画先のビットマップは事前に確保し、段の中で確保が競合しないようにする
+		getPipelineBitmap(0);
+		getPipelineBitmap(1);
+		_concurrentHitCount.store(0, std::memory_order_relaxed);
+		if (auto *system = getJobSystem()) {
+			if (!_pipelineGraph) {
+				_pipelineGraph = std::make_unique<TaskGraph>();
+				for (const auto stage: {INTEGRATE, DRAW, QUERY}) {
+					_pipelineGraph->add([this, stage]() { runStage(stage); });
+				}
+			}
+			_pipelineGraph->run(*system);
+		} else {
+			for (const auto stage: {INTEGRATE, DRAW, QUERY}) {
+				runStage(stage);
+			}
+		}
+		_hitCount += _concurrentHitCount.load(std::memory_order_relaxed);
+		_pipelineCount += 1;
+	}
+
+	/// かすり判定を行う関数
+	///
+	/// target群の距離場を求め、querier群の物体ごとに一度だけ参照する。
+	/// ビットマップでの判定ならば(詳細度つきの判定を除き)、bitmapにはgroupsの物体が描画済みである。
+	/// 区画に分けたビットマップでは、距離場を区画の周りにquerier群の最大の半径と余白との和だけ広げて求める。
+	void graze(TiledBitmap &bitmap, const std::vector<EntityGroup> &groups) {
+		if (_backend != Backend::Bitmap || _lod) {
+			bitmap.prepare(groups, false, 1u << _graze->target);
+			bitmap.clear();
+			bitmap.drawGroup(_graze->target, groups[_graze->target], _atlas);
+			_bitmapCurrent = false;
+			_occupancyCurrent = false;
+		}
+		const auto &queriers = groups[_graze->querier];
+		auto reach = 0.0f;
+		for (size_t i = 0; i < queriers.size(); ++i) {
+			reach = std::max(reach, queriers.r[i]);
+		}
+		reach += _graze->margin;
+		bitmap.buildDistance(_graze->target, static_cast<int>(std::ceil(reach * bitmap.getScale())) + 1);
+		for (size_t i = 0; i < queriers.size(); ++i) {
+			if (bitmap.classify(queriers.x[i], queriers.y[i], queriers.r[i], _graze->margin) == Proximity::Graze) {
+				_grazeCount += 1;
+			}
+		}
+	}
+
+	/// 物体を関心点からの距離で分け、_lodNear・_lodZones・_lodNearCountsを求める関数
+	///
+	/// 関心点の近くの物体と重なりうるのは、その周りの物体の半径の最大値の2倍(掃引判定ならば移動量も含む)以内の物体に限られる。
+	void classifyLod() {
+		auto reach = 0.0f;
+		for (const auto &group: _groups) {
+			for (size_t i = 0; i < group.size(); ++i) {
+				auto r = group.r[i];
+				if (_swept) {
+					r += std::hypot(group.x[i] - group.px[i], group.y[i] - group.py[i]);
+				}
+				reach = std::max(reach, r);
+			}
+		}
+		const auto near = _lod->radius;
+		const auto zone = near + reach * 2.0f;
+		_lodNear.resize(_groups.size());
+		_lodZones.resize(_groups.size());
+		_lodNearCounts.assign(_groups.size(), 0);
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			const auto &group = _groups[g];
+			auto &nears = _lodNear[g];
+			auto &zones = _lodZones[g];
+			nears.assign(group.size(), 0);
+			zones.clear();
+			for (size_t pass = 0; pass < 2; ++pass) {
+				for (size_t i = 0; i < group.size(); ++i) {
+					auto d2 = HUGE_VALF;
+					for (const auto &point: _interestPoints) {
+						const auto dx = group.x[i] - point.x;
+						const auto dy = group.y[i] - point.y;
+						d2 = std::min(d2, dx * dx + dy * dy);
+					}
+					if (pass == 0 && d2 <= near * near) {
+						nears[i] = 1;
+						zones.push_back(static_cast<uint32_t>(i));
+					} else if (pass == 1 && nears[i] == 0 && d2 <= zone * zone) {
+						zones.push_back(static_cast<uint32_t>(i));
+					}
+				}
+				if (pass == 0) {
+					_lodNearCounts[g] = zones.size();
+				}
+			}
+		}
+	}
+
+	/// 詳細度つきの判定で、関心点の近くの物体が関わる組を円どうしで判定する関数
+	///
+	/// 関心点の近くの物体はその周りの物体すべてと、周りの物体は関心点の近くの物体とだけ判定する。
+	void collideLodExact() {
+		for (unsigned int b = 0; b < _groups.size(); ++b) {
+			const auto row = _matrix.getRow(b);
+			const auto lower = row & ((1u << b) - 1);
+			const auto self = _matrix.interacts(b, b);
+			if (lower == 0 && !self) {
+				continue;
+			}
+			const auto &zoneB = _lodZones[b];
+			for (size_t k = 0; k < zoneB.size(); ++k) {
+				const auto j = zoneB[k];
+				const auto nearJ = k < _lodNearCounts[b];
+				const auto collideZone = [&](unsigned int a) {
+					const auto &zoneA = _lodZones[a];
+					const auto count = nearJ ? zoneA.size() : _lodNearCounts[a];
+					for (size_t l = 0; l < count; ++l) {
+						const auto i = zoneA[l];
+						if ((a != b || i < j) && isHit(a, i, b, j)) {
+							SceneBase::incrementHitCount();
+							SceneBase::emitContact(a, i, b, j);
+						}
+					}
+				};
+				for (auto bits = lower; bits != 0; bits &= bits - 1) {
+					collideZone(static_cast<unsigned int>(std::countr_zero(bits)));
+				}
+				if (self) {
+					collideZone(b);
+				}
+			}
+		}
+	}
+
+	/// 詳細度つきの判定で、関心点の近くの物体を衝突判定ビットマップで判定する関数
+	///
+	/// 関心点の近くの物体と重なりうる物体だけを描画するため、ビットマップの区画もその周りだけ確保される。
+	void collideLodBitmap() {
+		_lodGroups.resize(_groups.size());
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			const auto &src = _groups[g];
+			auto &dst = _lodGroups[g];
+			for (auto *n: {&dst.x, &dst.y, &dst.r, &dst.px, &dst.py, &dst.angle}) {
+				n->clear();
+			}
+			dst.shape.clear();
+			for (const auto i: _lodZones[g]) {
+				dst.x.push_back(src.x[i]);
+				dst.y.push_back(src.y[i]);
+				dst.r.push_back(src.r[i]);
+				dst.px.push_back(src.px[i]);
+				dst.py.push_back(src.py[i]);
+				dst.shape.push_back(src.shape[i]);
+				dst.angle.push_back(src.angle[i]);
+			}
+		}
+		auto &bitmap = getBitmap();
+		bitmap.prepare(_lodGroups, _swept);
+		bitmap.clear();
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			drawBitmapGroup(bitmap, g, _lodGroups[g]);
+		}
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			const auto mask = _matrix.getRow(g) & ~(1u << g);
+			if (mask == 0) {
+				continue;
+			}
+			_hitCount += queryBitmapRange(bitmap, _lodGroups[g], mask, 0, _lodNearCounts[g], [&](size_t k) {
+				SceneBase::emitHit(g, _lodZones[g][k]);
+			});
+		}
+		// ビットマップには一部の物体しか描画していない
+		_bitmapCurrent = false;
+		_occupancyCurrent = false;
+	}
+
+	/// 詳細度つきの判定で、関心点から遠い物体を粗い格子で判定する関数
+	///
+	/// すべての物体の箱(掃引判定ならば直前の位置の円も囲む箱)を格子に書き込み、
+	/// 遠い物体ごとに相互作用行列の行の物体群のビットを調べる。自身の物体群とは、升目に二つ以上あるときに重なりうるとみなす。
+	/// 衝突数は見つかった物体群の数で数え、衝突フラグだけを書き出す。
+	void collideLodCoarse() {
+		if (!_coarseGrid) {
+			_coarseGrid = std::make_unique<CoarseGrid>(_world, _lod->cellSize);
+		}
+		auto &grid = *_coarseGrid;
+		grid.clear();
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			for (size_t i = 0; i < _groups[g].size(); ++i) {
+				grid.mark(g, getEntityBox(g, i));
+			}
+		}
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			const auto mask = _matrix.getRow(g);
+			if (mask == 0) {
+				continue;
+			}
+			const auto self = mask & (1u << g);
+			const auto others = mask & ~self;
+			const auto &nears = _lodNear[g];
+			for (size_t i = 0; i < _groups[g].size(); ++i) {
+				if (nears[i] != 0) {
+					continue;
+				}
+				if (const auto found = grid.overlap(getEntityBox(g, i), others, self)) {
+					_hitCount += std::popcount(found);
+					SceneBase::emitHit(g, i);
+				}
+			}
+		}
+	}
+
+	/// 詳細度つきの判定を行う関数
+	///
+	/// 関心点の近くの物体は、総当たりならば円どうしで、ビットマップならばビットマップで判定し、
+	/// 遠い物体は粗い格子で判定する。
+	void collideLod() {
+		if (_backend != Backend::BruteForce && _backend != Backend::Bitmap) {
+			throw "LOD collision requires the brute-force or bitmap backend.";
+		}
+		classifyLod();
+		if (_backend == Backend::Bitmap) {
+			collideLodBitmap();
+		} else {
+			collideLodExact();
+		}
+		collideLodCoarse();
+	}
+
+	/// 物体群gに、問い合わせに用いる動的AABB木かLBVHがあるか
+	inline bool hasQueryIndex(unsigned int g) const {
+		if (!_queryIndexReady) {
+			return false;
+		}
+		if (_backend == Backend::AabbTree) {
+			return g < _trees.size();
+		}
+		return _backend == Backend::Lbvh && g < _bvhs.size() && _bvhs[g];
+	}
+
+	/// groupMaskの物体群の物体のうち、箱boxと重なりうる物体を(物体群の番号, 位置)としてfに渡す関数
+	///
+	/// 木があればその木で候補を絞り、なければ物体群のすべての物体を渡す。候補は呼び出し側で円と判定すること。
+	template<typename F>
+	void forEachCandidate(uint32_t groupMask, const Aabb &box, F f) const {
+		if (_groups.size() < MAX_GROUP_COUNT) {
+			groupMask &= (1u << _groups.size()) - 1;
+		}
+		for (auto bits = groupMask; bits != 0; bits &= bits - 1) {
+			const auto g = static_cast<unsigned int>(std::countr_zero(bits));
+			if (!hasQueryIndex(g)) {
+				for (size_t i = 0; i < _groups[g].size(); ++i) {
+					f(g, i);
+				}
+			} else if (_backend == Backend::AabbTree) {
+				_trees[g]->query(box, [&](uint32_t i) { f(g, static_cast<size_t>(i)); });
+			} else {
+				_bvhs[g]->query(box, [&](uint32_t i) { f(g, static_cast<size_t>(i)); });
+			}
+		}
+	}
+
+public:
+	explicit Scene(size_t entityCount, const WorldBounds &world = getDefaultWorld()):
+		SceneBase(entityCount, world),
+		_backend(Backend::BruteForce),
+		_bitmapScale(1.0f),
+		_bitmapCurrent(false),
+		_occupancyCurrent(false),
+		_sweepLimit(SWEEP_QUERIER_LIMIT),
+		_swept(false),
+		_reinsertCount(0),
+		_queryGroups(0),
+		_queryIndexReady(false),
+		_spatialOrder(SpatialOrder::None),
+		_reorderInterval(REORDER_INTERVAL),
+		_frameCount(0),
+		_concurrentHitCount(0),
+		_pipelined(false),
+		_pipelineCount(0),
+		_stageMs{}
+	{}
+	explicit Scene(const std::vector<GroupDesc> &descs, const InteractionMatrix &matrix, const WorldBounds &world = getDefaultWorld()):
+		SceneBase(descs, matrix, world),
+		_backend(Backend::BruteForce),
+		_bitmapScale(1.0f),
+		_bitmapCurrent(false),
+		_occupancyCurrent(false),
+		_sweepLimit(SWEEP_QUERIER_LIMIT),
+		_swept(false),
+		_reinsertCount(0),
+		_queryGroups(0),
+		_queryIndexReady(false),
+		_spatialOrder(SpatialOrder::None),
+		_reorderInterval(REORDER_INTERVAL),
+		_frameCount(0),
+		_concurrentHitCount(0),
+		_pipelined(false),
+		_pipelineCount(0),
+		_stageMs{}
+	{}
+
+	inline void setBackend(Backend backend) {
+		if (backend != _backend) {
+			_queryIndexReady = false;
+			_bitmapCurrent = false;
+		}
+		_backend = backend;
+	}
+
+	/// 円の描画と照合とに用いる足跡の表を設定する関数 (SceneBase::setFootprints()を参照)
+	///
+	/// 作ってあるビットマップにもここで一度だけ渡す。判定の途中で渡し直すと、描画・照合しているタスクと競合するため。
+	inline void setFootprints(const DiskFootprints *footprints) {
+		SceneBase::setFootprints(footprints);
+		forEachBitmap([&](TiledBitmap &bitmap) {
+			bitmap.setFootprints(footprints);
+		});
+	}
+
+	/// 衝突判定ビットマップで画素を覆っているとみなす規則を設定する関数 (SceneBase::setCoverage()を参照)
+	///
+	/// setFootprints()と同じく、作ってあるビットマップにはここで一度だけ渡す。
+	inline void setCoverage(const Coverage &coverage) {
+		SceneBase::setCoverage(coverage);
+		forEachBitmap([&](TiledBitmap &bitmap) {
+			bitmap.setCoverage(coverage);
+		});
+		_bitmapCurrent = false;
+		_occupancyCurrent = false;
+	}
+
+	/// 衝突判定ビットマップの解像度を、ワールドの1単位あたりの画素数scaleで設定する関数
+	///
+	/// 画面の解像度とは独立に、0.5ならば半分、0.25ならば4分の1、2ならば2倍の解像度のビットマップに描画・照合する。
+	/// 解像度を下げるとメモリと描画・消去の時間とが減るが、物体の縁が粗くなって衝突数がずれる。
+	/// ビットマップは次に用いるときに作り直される。
+	inline void setBitmapScale(float scale) {
+		if (scale <= 0.0f) {
+			throw "the bitmap scale must be positive.";
+		}
+		if (scale != _bitmapScale) {
+			_bitmapScale = scale;
+			_bitmap.reset();
+			_bitmapGraph.reset();
+			for (auto &bitmap: _pipelineBitmaps) {
+				bitmap.reset();
+			}
+			_bitmapCurrent = false;
+			_occupancyCurrent = false;
+		}
+	}
+
+	/// 掃引判定を行うか設定する関数
+	///
+	/// trueならば、直前の位置(px, py)から現在の位置(x, y)までの移動の途中で重なった組も衝突とみなす。
+	/// 総当たりでは同じ時刻の位置どうしで、ビットマップではカプセルどうしの重なりで判定する。
+	inline void setSwept(bool swept) {
+		_swept = swept;
+		_bitmapCurrent = false;
+	}
+
+	/// intervalフレームごとに物体の並びをorderの曲線の順に入れ替えるよう設定する関数
+	///
+	/// 空間で近い物体がメモリ上でも近くに並び、近傍の問い合わせやビットマップへの描画でのキャッシュミスが減る。
+	/// 衝突結果の出力は生成順の番号で行われるため、入れ替えの影響を受けない。
+	inline void setSpatialOrder(SpatialOrder order, unsigned int interval = REORDER_INTERVAL) {
+		_spatialOrder = order;
+		_reorderInterval = std::max(interval, 1u);
+	}
+
+	/// 直前のupdate()で動的AABB木に入れ直された物体数を返す関数
+	inline size_t getReinsertCount() const {
+		return _reinsertCount;
+	}
+
+	/// 物体群groupの動的AABB木を返す関数
+	///
+	/// 動的AABB木でまだ判定していなければnullptrを返す。
+	inline const AabbTree *getTree(unsigned int group) const {
+		return group < _trees.size() ? _trees[group].get() : nullptr;
+	}
+
+	/// LBVHでの判定で、問い合わせのために木を作る物体群を設定する関数
+	///
+	/// LBVHは衝突判定で問い合わせを受ける物体群の分しか作らないため、
+	/// queryBoxes()などで他の物体群も木で絞り込みたければ、そのビットを立てておく。
+	inline void setQueryGroups(uint32_t groupMask) {
+		_queryGroups = groupMask;
+	}
+
+	/// boxes[q]と重なる物体を、groupMaskの物体群から一括して求める関数
+	///
+	/// 衝突判定の方式が動的AABB木かLBVHならば、直前のupdate()の木で候補を絞る(木のない物体群は総当たりで調べる)。
+	/// 結果はresultsに問い合わせの順に書かれ、問い合わせの中での物体の順は定まらない。確保は起こらない。
+	void queryBoxes(const Aabb *boxes, size_t count, uint32_t groupMask, QueryResults &results) const {
+		results.clear();
+		for (size_t q = 0; q < count; ++q) {
+			const auto &box = boxes[q];
+			results.begin(q);
+			forEachCandidate(groupMask, box, [&](unsigned int g, size_t i) {
+				const auto &group = _groups[g];
+				const auto dx = group.x[i] - std::clamp(group.x[i], box.x0, box.x1);
+				const auto dy = group.y[i] - std::clamp(group.y[i], box.y0, box.y1);
+				if (dx * dx + dy * dy < group.r[i] * group.r[i]) {
+					results.push(q, SceneBase::getEntityIdAt(g, i));
+				}
+			});
+		}
+	}
+
+	/// circles[q]と重なる物体を、groupMaskの物体群から一括して求める関数
+	///
+	/// 重なりの判定は物体どうしの衝突判定と同じ。他はqueryBoxes()と同じ。
+	void queryCircles(const QueryCircle *circles, size_t count, uint32_t groupMask, QueryResults &results) const {
+		results.clear();
+		for (size_t q = 0; q < count; ++q) {
+			const auto &circle = circles[q];
+			results.begin(q);
+			forEachCandidate(groupMask, Aabb::ofCircle(circle.x, circle.y, circle.r), [&](unsigned int g, size_t i) {
+				const auto &group = _groups[g];
+				const auto dx = group.x[i] - circle.x;
+				const auto dy = group.y[i] - circle.y;
+				const auto rr = group.r[i] + circle.r;
+				if (dx * dx + dy * dy < rr * rr) {
+					results.push(q, SceneBase::getEntityIdAt(g, i));
+				}
+			});
+		}
+	}
+
+	/// points[q]を内部に含む物体を、groupMaskの物体群から一括して求める関数
+	///
+	/// 半径0の円での問い合わせと同じ。形のアトラスが設定されていれば、円以外の形の物体はその形で判定する。
+	void queryPoints(const QueryPoint *points, size_t count, uint32_t groupMask, QueryResults &results) const {
+		results.clear();
+		for (size_t q = 0; q < count; ++q) {
+			const auto &point = points[q];
+			results.begin(q);
+			forEachCandidate(groupMask, Aabb{point.x, point.y, point.x, point.y}, [&](unsigned int g, size_t i) {
+				const auto &group = _groups[g];
+				const auto dx = point.x - group.x[i];
+				const auto dy = point.y - group.y[i];
+				if (dx * dx + dy * dy >= group.r[i] * group.r[i]) {
+					return;
+				}
+				if (_atlas && group.shape[i] != SHAPE_CIRCLE) {
+					// 点を形の向きに戻してから形を参照する
+					const auto c = std::cos(group.angle[i]);
+					const auto s = std::sin(group.angle[i]);
+					if (!_atlas->test(group.shape[i], (dx * c + dy * s) / group.r[i], (dy * c - dx * s) / group.r[i])) {
+						return;
+					}
+				}
+				results.push(q, SceneBase::getEntityIdAt(g, i));
+			});
+		}
+	}
+
+	/// points[q]に中心が近い順にk個の物体を、groupMaskの物体群から一括して求める関数
+	///
+	/// 結果は問い合わせごとに近い順に並び、物体がk個に満たなければすべての物体を返す。
+	/// 木があれば半径QUERY_NEAREST_RADIUSの円から始め、k個の物体が円の中に見つかるまで半径を倍にして探し直す。
+	/// 中心がワールドの中にあるため、円がワールド全体を覆えば打ち切る。
+	///
+	/// WARN: kはQUERY_NEAREST_MAX以下であること。
+	void queryNearest(const QueryPoint *points, size_t count, uint32_t groupMask, size_t k, QueryResults &results) const {
+		if (k > QUERY_NEAREST_MAX) {
+			throw "too many neighbors requested.";
+		}
+		struct Neighbor {
+			float d2;
+			EntityId id;
+		};
+		const auto farther = [](const Neighbor &a, const Neighbor &b) { return a.d2 < b.d2; };
+		auto indexed = false;
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			indexed = indexed || (((groupMask >> g) & 1) != 0 && hasQueryIndex(g));
+		}
+		std::array<Neighbor, QUERY_NEAREST_MAX> heap;
+		results.clear();
+		for (size_t q = 0; q < count; ++q) {
+			const auto &point = points[q];
+			results.begin(q);
+			if (k == 0) {
+				continue;
+			}
+			// ワールドの隅のうち最も遠いものまでの距離より大きい円は、すべての物体の中心を含む
+			const auto fx = std::max(point.x, _world.width - point.x);
+			const auto fy = std::max(point.y, _world.height - point.y);
+			const auto farthest = std::sqrt(fx * fx + fy * fy) + 1.0f;
+			auto radius = indexed ? std::min(QUERY_NEAREST_RADIUS, farthest) : farthest;
+			size_t size = 0;
+			while (true) {
+				const auto r2 = radius * radius;
+				size = 0;
+				forEachCandidate(groupMask, Aabb::ofCircle(point.x, point.y, radius), [&](unsigned int g, size_t i) {
+					const auto &group = _groups[g];
+					const auto dx = group.x[i] - point.x;
+					const auto dy = group.y[i] - point.y;
+					const auto d2 = dx * dx + dy * dy;
+					if (d2 > r2) {
+						return;
+					}
+					if (size < k) {
+						heap[size++] = Neighbor{d2, SceneBase::getEntityIdAt(g, i)};
+						std::push_heap(heap.begin(), heap.begin() + size, farther);
+					} else if (d2 < heap[0].d2) {
+						std::pop_heap(heap.begin(), heap.begin() + size, farther);
+						heap[size - 1] = Neighbor{d2, SceneBase::getEntityIdAt(g, i)};
+						std::push_heap(heap.begin(), heap.begin() + size, farther);
+					}
+				});
+				// 円の外の物体は円の中のk個のどれよりも遠い
+				if (size == k || radius >= farthest) {
+					break;
+				}
+				radius = std::min(radius * 2.0f, farthest);
+			}
+			std::sort_heap(heap.begin(), heap.begin() + size, farther);
+			for (size_t i = 0; i < size; ++i) {
+				results.push(q, heap[i].id);
+			}
+		}
+	}
+
+	/// count本の光線raysが最初に通るmaskの物体群の画素までの距離を一括して求める関数
+	///
+	/// 衝突判定ビットマップを、粗い占有格子で空の升目を飛ばしながらDDAで辿る。
+	/// 結果はdistances[q * getGroupCount() + g]に書かれ、通らなかった物体群にはHUGE_VALFが書かれる。
+	/// 判定の方式がBackend::Bitmapならばupdate()で描画したビットマップをそのまま用い、
+	/// そうでなければフレームごとに最初の呼び出しですべての物体群を描画する。占有格子もフレームごとに一度だけ作る。
+	///
+	/// NOTE: 物体の形は描画された画素で近似され、掃引判定ならばカプセルとして描画されている。
+	void castRays(const Ray *rays, size_t count, uint32_t mask, float *distances) {
+		auto &bitmap = getBitmap();
+		if (!_bitmapCurrent) {
+			bitmap.prepare(_groups, _swept);
+			bitmap.clear();
+			for (unsigned int g = 0; g < _groups.size(); ++g) {
+				drawBitmapGroup(bitmap, g, _groups[g]);
+			}
+			_bitmapCurrent = true;
+			_occupancyCurrent = false;
+		}
+		if (!_occupancyCurrent) {
+			bitmap.updateOccupancy();
+			_occupancyCurrent = true;
+		}
+		bitmap.castRays(rays, count, mask, distances);
+	}
+
+	/// 物体数がlimit以下の物体群を問い合わせ側として掃引するよう設定する関数
+	///
+	/// 0を渡すと掃引を行わず、すべての組を物体ごとの走査で判定する。
+	inline void setSweepLimit(size_t limit) {
+		_sweepLimit = limit;
+	}
+
+	/// 詳細度つきの判定を設定する関数
+	///
+	/// 設定すると、関心点(setInterestPoints())のどれかからlod.radius以内に中心がある物体だけを
+	/// 衝突判定の方式どおりに判定し、それ以外の物体は一辺lod.cellSizeの粗い格子で判定する。
+	/// 粗い判定は物体を囲む箱(掃引判定ならば直前の位置の円も囲む箱)で行うため重なりを取りこぼさないが、
+	/// 升目が粗いほど誤って衝突とみなす。遠い物体は衝突フラグだけを書き出す。
+	/// std::nulloptを渡すとすべての物体を詳細に判定する。
+	///
+	/// WARN: 衝突判定の方式はBackend::BruteForceかBackend::Bitmapであること。
+	/// NOTE: ジョブシステムは用いない。
+	inline void setLod(std::optional<LodDesc> lod) {
+		if (lod && (lod->radius < 0.0f || lod->cellSize <= 0.0f)) {
+			throw "the LOD radius must be non-negative and the cell size positive.";
+		}
+		if (!lod || !_coarseGrid || _coarseGrid->getCellSize() != lod->cellSize) {
+			_coarseGrid.reset();
+		}
+		_lod = lod;
+		_bitmapCurrent = false;
+	}
+
+	/// 詳細度つきの判定の関心点を設定する関数
+	///
+	/// 自機など、正確な判定が要る場所をフレームごとに渡す。関心点がなければすべての物体を粗く判定する。
+	inline void setInterestPoints(const InterestPoint *points, size_t count) {
+		_interestPoints.assign(points, points + count);
+	}
+
+	/// 直前のupdate()で、関心点の近くにあり詳細に判定した物体数
+	inline size_t getLodNearCount() const {
+		size_t count = 0;
+		for (const auto n: _lodNearCounts) {
+			count += n;
+		}
+		return count;
+	}
+
+	/// パイプライン実行を行うか設定する関数
+	///
+	/// trueならば、物体の移動、衝突判定ビットマップへの描画、ビットマップへの問い合わせを
+	/// 1フレームずつずらして同時に行う。衝突数・衝突フラグ・かすり数は2フレーム前の位置についてのものになり、
+	/// 最初の2フレームでは判定を行わない。ビットマップは2枚、位置は3フレーム分だけ保持する。
+	///
+	/// WARN: 衝突判定の方式はBackend::Bitmapであること。
+	inline void setPipelined(bool pipelined) {
+		_pipelined = pipelined;
+		_pipelineCount = 0;
+		_stageMs = {};
+	}
+
+	/// パイプライン実行での、段ごとの累計時間(ミリ秒)
+	inline const std::array<double, PIPELINE_DEPTH> &getStageMs() const {
+		return _stageMs;
+	}
+
+	/// これまでに進めたフレーム数
+	inline unsigned long long getFrameCount() const {
+		return _frameCount;
+	}
+
+	/// 現在の状態をsnapshotに書き込む関数
+	///
+	/// 物体の状態と、フレームをまたいで保持される衝突判定の状態(動的AABB木と葉の表)とを平坦に写す。
+	/// LBVH・ビットマップ・距離場・掃引判定の囲む円は毎フレーム作り直すため写さない。
+	/// SnapshotRing::acquire()の領域を渡せば、確保は起こらない。
+	///
+	/// WARN: パイプライン実行中は保存できない。
+	void save(Snapshot &snapshot) const {
+		if (_pipelined) {
+			throw "snapshots are not supported in pipelined execution.";
+		}
+		SceneBase::saveState(snapshot);
+		snapshot.write(_frameCount);
+		snapshot.write(_reinsertCount);
+		snapshot.write(_trees.size());
+		for (size_t g = 0; g < _trees.size(); ++g) {
+			_trees[g]->save(snapshot);
+			snapshot.write(_proxies[g]);
+		}
+	}
+
+	/// save()で書き込んだ状態に戻す関数
+	///
+	/// 物体数と動的AABB木の節の数とが保存時と同じならば、確保は起こらない。
+	void restore(Snapshot &snapshot) {
+		if (_pipelined) {
+			throw "snapshots are not supported in pipelined execution.";
+		}
+		snapshot.beginRead();
+		SceneBase::restoreState(snapshot);
+		snapshot.read(_frameCount);
+		snapshot.read(_reinsertCount);
+		size_t treeCount = 0;
+		snapshot.read(treeCount);
+		_trees.resize(treeCount);
+		_proxies.resize(treeCount);
+		for (size_t g = 0; g < treeCount; ++g) {
+			if (!_trees[g]) {
+				_trees[g] = std::make_unique<AabbTree>();
+			}
+			_trees[g]->restore(snapshot);
+			snapshot.read(_proxies[g]);
+		}
+		// 動的AABB木は物体と一緒に戻るが、LBVHとビットマップとは次のupdate()まで位置に合わない
+		_queryIndexReady = _backend == Backend::AabbTree && treeCount > 0;
+		_bitmapCurrent = false;
+	}
+
+	/// 1フレーム進める関数
+	///
+	/// ジョブシステムが設定されていれば(setJobSystem())、物体の移動と、総当たりで衝突数だけを求める判定、
+	/// ビットマップでの判定、LBVHの構築と問い合わせとをその上で並列に行う。
+	void update() {
+		if (_pipelined) {
+			updatePipelined();
+			return;
+		}
+		integrate();
+		if (_swept && (_backend == Backend::BruteForce || _backend == Backend::AabbTree)) {
+			_sweptBounds.resize(_groups.size());
+			for (size_t g = 0; g < _groups.size(); ++g) {
+				computeSweptBounds(_groups[g], _sweptBounds[g]);
+			}
+		}
+		if (_lod) {
+			SceneBase::clearContactOutput();
+			collideLod();
+		} else if (_backend == Backend::Bitmap) {
+			SceneBase::clearContactOutput();
+			collideBitmap();
+		} else if (_backend == Backend::Lbvh) {
+			SceneBase::clearContactOutput();
+			if (SceneBase::hasContactOutput()) {
+				collideLbvh<true>();
+			} else {
+				collideLbvh<false>();
+			}
+		} else if (_backend == Backend::AabbTree) {
+			SceneBase::clearContactOutput();
+			if (SceneBase::hasContactOutput()) {
+				collideTree<true>();
+			} else {
+				collideTree<false>();
+			}
+		} else if (SceneBase::hasContactOutput()) {
+			SceneBase::clearContactOutput();
+			collideAll<true>();
+		} else {
+			collideAll<false>();
+		}
+		if (_graze) {
+			graze(getBitmap(), _groups);
+		}
+	}
+};
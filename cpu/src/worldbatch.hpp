@@ -0,0 +1,170 @@
+#pragma once
+
+#include "../../common/common.hpp"
+#include "../../common/jobsystem.hpp"
+#include "../../common/parallel.hpp"
+#include "../../common/sweep.hpp"
+
+#include <bit>
+#include <cmath>
+#include <vector>
+
+/// ジョブシステムがないとき、一つのスレッドがまとめて進めるワールド数の下限
+constexpr size_t WORLD_BATCH_MIN_CHUNK = 16;
+
+/// 多数の独立した小さなシーン(ワールド)をまとめて進めるオブジェクト
+///
+/// すべてのワールドの物体を一つの物体群(SoA)の領域に、ワールドごと・物体群ごとに連続して並べる。
+/// ワールドは区間に分けて並列に進め、一つのワールドの移動と判定とは一つのスレッドで続けて行う。
+/// 各ワールドは数百の物体を想定し、物体群の組ごとに総当たりで判定する。ワールドどうしは相互作用しない。
+///
+/// NOTE: すべてのワールドは同じ大きさで同じ物体群と相互作用行列とを持ち、初期の向きだけがワールドごとにずれる。
+class WorldBatch final {
+private:
+	/// ワールドごとに初期の向きをずらす角度(黄金角)
+	static constexpr float WORLD_DIRECTION_STEP = 2.399963f;
+
+	size_t _worldCount;
+	unsigned int _groupCount;
+	WorldBounds _bounds;
+	InteractionMatrix _matrix;
+	EntityGroup _arena;
+	/// w番目のワールドのg番目の物体群は[_offsets[w * groupCount + g], _offsets[w * groupCount + g + 1])
+	std::vector<size_t> _offsets;
+	std::vector<unsigned long long> _hitCounts;
+
+	inline size_t getBegin(size_t world, unsigned int g) const {
+		return _offsets[world * _groupCount + g];
+	}
+	inline size_t getEnd(size_t world, unsigned int g) const {
+		return _offsets[world * _groupCount + g + 1];
+	}
+
+	/// ワールドworldで、物体群innerの物体と物体群outerの[begin, end)の物体とが衝突している数を返す関数
+	///
+	/// 内側のループは自動ベクトル化されるため、物体数の多い方を内側にする。
+	inline unsigned long long countPairs(size_t world, unsigned int inner, unsigned int outer) const {
+		unsigned long long hitCount = 0;
+		const auto innerBegin = getBegin(world, inner);
+		const auto innerEnd = getEnd(world, inner);
+		for (auto j = getBegin(world, outer); j < getEnd(world, outer); ++j) {
+			hitCount += countHits(_arena, innerBegin, innerEnd, _arena.x[j], _arena.y[j], _arena.r[j]);
+		}
+		return hitCount;
+	}
+
+	/// ワールドworldを1フレーム進める関数
+	///
+	/// 相互作用行列の組を一度ずつ、物体数の少ない物体群を外側にして総当たりで判定する。
+	void step(size_t world) {
+		_arena.update(getBegin(world, 0), getEnd(world, _groupCount - 1), _bounds);
+		unsigned long long hitCount = 0;
+		for (unsigned int b = 0; b < _groupCount; ++b) {
+			const auto sizeB = getEnd(world, b) - getBegin(world, b);
+			for (auto bits = _matrix.getRow(b) & ((1u << b) - 1); bits != 0; bits &= bits - 1) {
+				const auto a = static_cast<unsigned int>(std::countr_zero(bits));
+				const auto sizeA = getEnd(world, a) - getBegin(world, a);
+				hitCount += sizeA < sizeB ? countPairs(world, b, a) : countPairs(world, a, b);
+			}
+			if (_matrix.interacts(b, b)) {
+				const auto begin = getBegin(world, b);
+				for (auto j = begin; j < getEnd(world, b); ++j) {
+					hitCount += countHits(_arena, begin, j, _arena.x[j], _arena.y[j], _arena.r[j]);
+				}
+			}
+		}
+		_hitCounts[world] += hitCount;
+	}
+
+public:
+	/// 大きさboundsのワールドをworldCount個作る
+	explicit WorldBatch(const std::vector<GroupDesc> &descs, const InteractionMatrix &matrix, size_t worldCount, const WorldBounds &bounds = getDefaultWorld()):
+		_worldCount(worldCount),
+		_groupCount(static_cast<unsigned int>(descs.size())),
+		_bounds(bounds),
+		_matrix(matrix),
+		_arena(),
+		_offsets(),
+		_hitCounts(worldCount, 0)
+	{
+		if (descs.empty()) {
+			throw "no groups.";
+		}
+		if (descs.size() > MAX_GROUP_COUNT) {
+			throw "too many groups.";
+		}
+		size_t worldSize = 0;
+		for (const auto &n: descs) {
+			worldSize += n.count;
+		}
+		_arena.reserve(worldSize * worldCount);
+		_offsets.reserve(worldCount * _groupCount + 1);
+		for (size_t w = 0; w < worldCount; ++w) {
+			const auto worldBegin = _arena.size();
+			for (unsigned int g = 0; g < _groupCount; ++g) {
+				_offsets.push_back(_arena.size());
+				spawnGroup(_arena, descs[g], g, _bounds);
+			}
+			// 角度が大きいと三角関数が遅くなるため、[0, 2π)に収める
+			const auto offset = std::fmod(static_cast<float>(w) * WORLD_DIRECTION_STEP, 2.0f * PI);
+			for (auto i = worldBegin; i < _arena.size(); ++i) {
+				_arena.dir[i] += offset;
+			}
+		}
+		_offsets.push_back(_arena.size());
+	}
+	WorldBatch(const WorldBatch &) = delete;
+	WorldBatch(const WorldBatch &&) = delete;
+	WorldBatch &operator=(const WorldBatch &) = delete;
+	WorldBatch &&operator=(const WorldBatch &&) = delete;
+	~WorldBatch() = default;
+
+	/// すべてのワールドを1フレーム進める関数
+	///
+	/// ジョブシステムが設定されていれば、ワールドの区間をその上で並列に進める。
+	void update() {
+		if (auto *system = getJobSystem()) {
+			system->parallelFor(_worldCount, [&](size_t begin, size_t end) {
+				for (auto w = begin; w < end; ++w) {
+					step(w);
+				}
+			});
+			return;
+		}
+		parallelFor(_worldCount, [&](size_t begin, size_t end, size_t) {
+			for (auto w = begin; w < end; ++w) {
+				step(w);
+			}
+		}, WORLD_BATCH_MIN_CHUNK);
+	}
+
+	inline size_t getWorldCount() const {
+		return _worldCount;
+	}
+	inline size_t getEntityCount() const {
+		return _arena.size();
+	}
+
+	/// ワールドworldのこれまでの衝突数
+	inline unsigned long long getHitCount(size_t world) const {
+		return _hitCounts[world];
+	}
+
+	/// すべてのワールドのこれまでの衝突数
+	inline unsigned long long getHitCount() const {
+		unsigned long long count = 0;
+		for (const auto n: _hitCounts) {
+			count += n;
+		}
+		return count;
+	}
+
+	/// ワールドworldのg番目の物体群の、領域での範囲[begin, end)を求める関数
+	inline void getRange(size_t world, unsigned int g, size_t &begin, size_t &end) const {
+		begin = getBegin(world, g);
+		end = getEnd(world, g);
+	}
+	inline const EntityGroup &getArena() const {
+		return _arena;
+	}
+};
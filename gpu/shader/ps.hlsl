@@ -1,7 +1,7 @@
 struct PSInput {
 	float4 position: SV_POSITION;
 	float2 texcoord: TEXCOORD;
-	float4 mask: COLOR;
+	nointerpolation uint groups: GROUPS;
 };
 
 struct PSOutput {
@@ -11,10 +11,19 @@ struct PSOutput {
 Texture2D tex: register(t1);
 SamplerState smplr: register(s0);
 
+static const float4 PALETTE[6] = {
+	float4(1.0f, 0.0f, 0.0f, 0.0f),
+	float4(0.0f, 1.0f, 0.0f, 0.0f),
+	float4(0.0f, 0.0f, 1.0f, 0.0f),
+	float4(1.0f, 1.0f, 0.0f, 0.0f),
+	float4(0.0f, 1.0f, 1.0f, 0.0f),
+	float4(1.0f, 0.0f, 1.0f, 0.0f),
+};
+
 PSOutput main(PSInput input) {
 	PSOutput output;
 
-	output.color = input.mask * tex.Sample(smplr, input.texcoord).a;
+	output.color = PALETTE[firstbitlow(input.groups) % 6] * tex.Sample(smplr, input.texcoord).a;
 
 	return output;
 }
@@ -0,0 +1,105 @@
+struct PSInput {
+	float4 position: SV_POSITION;
+	float2 texcoord: TEXCOORD;
+	nointerpolation uint groups: GROUPS;
+	float2 texel: TEXEL;
+	nointerpolation uint shape: SHAPE;
+	nointerpolation float radius: RADIUS;
+};
+
+struct PSOutput {
+	uint groups: SV_TARGET0;
+};
+
+cbuffer Camera : register(b0) {
+	float4x4 proj;
+	uint shapeCount;
+	uint coverageMode;
+	float coverageThreshold;
+	float bitmapScale;
+};
+
+Texture2D tex: register(t1);
+
+static const int MASK_SIZE = 32;
+
+// 円の形の番号 (CPU版のSHAPE_CIRCLEと同じ)
+static const uint SHAPE_CIRCLE = 0;
+
+// CoverageModeの値
+static const uint COVERAGE_CENTER = 0;
+static const uint COVERAGE_THRESHOLD = 1;
+static const uint COVERAGE_CONSERVATIVE = 2;
+
+// 形shapeのテクセル(x, y)の値。形の外側は0とみなす(隣の形をにじませない)
+float loadTexel(uint shape, int x, int y) {
+	if (x < 0 || x >= MASK_SIZE || y < 0 || y >= MASK_SIZE) {
+		return 0.0f;
+	}
+	return tex.Load(int3(x, shape * MASK_SIZE + y, 0)).a;
+}
+
+// テクセルの中心を整数の座標としてtで双線形補間した値 (CPU版のMaskAtlas::sample()と同じ)
+float sampleLinear(uint shape, float2 t) {
+	const float2 f = floor(t);
+	const float2 w = t - f;
+	const int x = int(f.x);
+	const int y = int(f.y);
+	return lerp(
+		lerp(loadTexel(shape, x, y), loadTexel(shape, x + 1, y), w.x),
+		lerp(loadTexel(shape, x, y + 1), loadTexel(shape, x + 1, y + 1), w.x),
+		w.y
+	);
+}
+
+// 画素の正方形を形の座標へ写したものに外接する長方形のテクセルのいずれかが内側か (CPU版のMaskAtlas::any()と同じ)
+bool anyTexel(uint shape, float2 t, float2 reach) {
+	const int2 lo = max(int2(floor(t - reach)), int2(0, 0));
+	const int2 hi = min(int2(ceil(t + reach)), int2(MASK_SIZE, MASK_SIZE));
+	for (int y = lo.y; y < hi.y; ++y) {
+		for (int x = lo.x; x < hi.x; ++x) {
+			if (loadTexel(shape, x, y) > 0.0f) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// 半径radiusの円の中心から画素の中心までのずれがdである画素を、円が覆っているか
+// CPU版の円の描画と照合(getCoveredRadius()、getConservativeDiskSpan())と同じく、アトラスを用いず解析的に求める。
+bool coversDisk(float2 d, float radius) {
+	if (coverageMode == COVERAGE_CONSERVATIVE) {
+		// 画素の正方形のうち中心に最も近い点までの距離
+		return length(max(abs(d) - 0.5f, 0.0f)) <= radius;
+	}
+	if (coverageMode == COVERAGE_THRESHOLD) {
+		return length(d) <= radius + 0.5f - coverageThreshold;
+	}
+	return length(d) <= radius;
+}
+
+PSOutput main(PSInput input) {
+	PSOutput output;
+
+	bool covered;
+	if (input.shape == SHAPE_CIRCLE) {
+		// 形の座標は四角形の一辺(直径)をMASK_SIZEテクセルとするので、画素に直す
+		const float2 d = (input.texel - 0.5f * MASK_SIZE) * (input.radius / (0.5f * MASK_SIZE));
+		covered = coversDisk(d, input.radius);
+	} else if (coverageMode == COVERAGE_THRESHOLD) {
+		covered = sampleLinear(input.shape, input.texel - 0.5f) >= coverageThreshold;
+	} else if (coverageMode == COVERAGE_CONSERVATIVE) {
+		// NOTE: ラスタライザーを保守的にして、四角形と少しでも重なる画素で呼ばれるようにしてある。
+		covered = anyTexel(input.shape, input.texel, 0.5f * fwidth(input.texel));
+	} else {
+		const int2 t = int2(floor(input.texel));
+		covered = loadTexel(input.shape, t.x, t.y) > 0.5f;
+	}
+	if (!covered) {
+		discard;
+	}
+	output.groups = input.groups;
+
+	return output;
+}
@@ -6,30 +6,64 @@ struct VSInput {
 struct VSOutput {
 	float4 position: SV_POSITION;
 	float2 texcoord: TEXCOORD;
-	float4 mask: COLOR;
+	nointerpolation uint groups: GROUPS;
+	// 形の中での位置(テクセル単位。左上が(0, 0))と形の番号
+	float2 texel: TEXEL;
+	nointerpolation uint shape: SHAPE;
+	// 衝突判定ビットマップでの半径(画素)
+	nointerpolation float radius: RADIUS;
 };
 
 struct Entity {
 	float4 trans;
 	float4 scale;
-	float4 mask;
+	uint groups;
+	uint shape;
+	float angle;
 };
 StructuredBuffer<Entity> entities: register(t0);
 
 cbuffer Camera : register(b0) {
 	float4x4 proj;
+	uint shapeCount;
+	uint coverageMode;
+	float coverageThreshold;
+	float bitmapScale;
 };
 
+static const float MASK_SIZE = 32.0f;
+
+// 円の形の番号 (CPU版のSHAPE_CIRCLEと同じ)
+static const uint SHAPE_CIRCLE = 0;
+// CoverageMode::Thresholdの値
+static const uint COVERAGE_THRESHOLD = 1;
+
 VSOutput main(VSInput input, uint instIdx: SV_InstanceID) {
 	VSOutput output;
 
+	const float radius = entities[instIdx].scale.x * 0.5f * bitmapScale;
+	// しきい値の規則では円が半径 + 0.5画素まで広がるため、その分だけ四角形を広げる(形の座標も外へ延ばす)
+	float2 uv = input.texcoord;
 	output.position = input.position;
+	if (entities[instIdx].shape == SHAPE_CIRCLE && coverageMode == COVERAGE_THRESHOLD && radius > 0.0f) {
+		const float expand = (radius + 0.5f) / radius;
+		output.position.xy *= expand;
+		uv = (uv - 0.5f) * expand + 0.5f;
+	}
 	output.position *= entities[instIdx].scale;
+	// 画面はyが下向きなので、正の角度は時計回りになる(CPU版の回転と同じ向き)
+	float s, c;
+	sincos(entities[instIdx].angle, s, c);
+	output.position.xy = float2(output.position.x * c - output.position.y * s, output.position.x * s + output.position.y * c);
 	output.position += entities[instIdx].trans;
 	output.position = mul(proj, output.position);
 
-	output.texcoord = input.texcoord;
-	output.mask = entities[instIdx].mask;
+	// アトラスは形を縦に並べ、各形の行は画面の下向きに並ぶ。四角形のvは下端が0なので上下を返す
+	output.texcoord = float2(uv.x, (entities[instIdx].shape + 1.0f - uv.y) / shapeCount);
+	output.groups = entities[instIdx].groups;
+	output.texel = float2(uv.x, 1.0f - uv.y) * MASK_SIZE;
+	output.shape = entities[instIdx].shape;
+	output.radius = radius;
 
 	return output;
 }
@@ -1,14 +1,31 @@
 #pragma once
 
 #include "../../common/constant.hpp"
+#include "../../common/raycast.hpp"
+#include "../../common/resolution.hpp"
+#include "../../common/world.hpp"
 #include "util.hpp"
 
 #include <array>
+#include <bit>
 #include <d3d12.h>
 #include <wrl/client.h>
 
 using Microsoft::WRL::ComPtr;
 
+/// 衝突判定ビットマップの画素の形式
+///
+/// 1画素32bitで、物体群ごとに1bitを割り当てる。論理和で描画される。
+constexpr DXGI_FORMAT BITMAP_FORMAT = DXGI_FORMAT_R32_UINT;
+
+/// 幅widthの衝突判定ビットマップを読み戻すときの、1行あたりの画素数
+///
+/// 読み戻し先の1行のバイト数はD3D12_TEXTURE_DATA_PITCH_ALIGNMENTの倍数でなければならない。
+inline UINT getBitmapPitch(UINT width) {
+	constexpr UINT PIXELS_PER_ALIGNMENT = D3D12_TEXTURE_DATA_PITCH_ALIGNMENT / 4;
+	return (width + PIXELS_PER_ALIGNMENT - 1) / PIXELS_PER_ALIGNMENT * PIXELS_PER_ALIGNMENT;
+}
+
 class Bitmap final: public RenderTarget {
 private:
 	const ComPtr<ID3D12Resource> _rbb;
@@ -16,24 +33,26 @@ private:
 	const D3D12_TEXTURE_COPY_LOCATION _rbbCopyLocSrc;
 
 public:
-	explicit Bitmap(const ComPtr<ID3D12Device> &device, D3D12_CPU_DESCRIPTOR_HANDLE viewHandle):
+	explicit Bitmap(const ComPtr<ID3D12Device> &device, D3D12_CPU_DESCRIPTOR_HANDLE viewHandle, UINT width, UINT height):
 		RenderTarget(
 			device,
 			createTexture2DResource(
 				device,
-				WIDTH,
-				HEIGHT,
-				createColorClearValue(CLEAR_COLOR),
+				width,
+				height,
+				createColorClearValue(CLEAR_COLOR, BITMAP_FORMAT),
 				D3D12_RESOURCE_STATE_RENDER_TARGET,
-				D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET
+				D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET,
+				BITMAP_FORMAT
 			),
-			viewHandle
+			viewHandle,
+			BITMAP_FORMAT
 		),
-		_rbb(createBufferResource(device, WIDTH * HEIGHT * 4, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST)),
+		_rbb(createBufferResource(device, getBitmapPitch(width) * height * 4, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST)),
 		_rbbCopyLocDst{
 			_rbb.Get(),
 			D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
-			{0, {DXGI_FORMAT_R8G8B8A8_UNORM, WIDTH, HEIGHT, 1, WIDTH * 4}},
+			{0, {BITMAP_FORMAT, width, height, 1, getBitmapPitch(width) * 4}},
 		},
 		_rbbCopyLocSrc{
 			_res.Get(),
@@ -62,21 +81,45 @@ public:
 };
 
 /// 衝突判定ビットマップ(レンダーターゲット)を管理するオブジェクト
+///
+/// ビットマップはワールドworldの全体を、その1単位をscale画素とした解像度で覆う。
+/// NOTE: CPU版と異なり区画には分けないため、大きなワールドでは倍率を下げてテクスチャの大きさの上限に収めること。
 class BitmapManager final {
 private:
+	const WorldBounds _world;
+	const float _scale;
+	const int _width;
+	const int _height;
+	const UINT _pitch;
 	const ComPtr<ID3D12DescriptorHeap> _rtvHeap;
 	const std::array<Bitmap, FRAME_COUNT> _bitmaps;
-	uint8_t *_mappedBitmap;
+	uint32_t *_mappedBitmap;
+	OccupancyGrid _occupancy;
 
 public:
-	explicit BitmapManager(const ComPtr<ID3D12Device> &device):
+	explicit BitmapManager(const ComPtr<ID3D12Device> &device, const WorldBounds &world, float scale = 1.0f):
+		_world(world),
+		_scale(scale),
+		_width(toBitmapSize(world.width, scale)),
+		_height(toBitmapSize(world.height, scale)),
+		_pitch(getBitmapPitch(static_cast<UINT>(_width))),
 		_rtvHeap(createRTVHeap(device)),
 		_bitmaps{
-			Bitmap(device, {_rtvHeap->GetCPUDescriptorHandleForHeapStart().ptr}),
-			Bitmap(device, {_rtvHeap->GetCPUDescriptorHandleForHeapStart().ptr + device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV)}),
+			Bitmap(device, {_rtvHeap->GetCPUDescriptorHandleForHeapStart().ptr}, static_cast<UINT>(_width), static_cast<UINT>(_height)),
+			Bitmap(
+				device,
+				{_rtvHeap->GetCPUDescriptorHandleForHeapStart().ptr + device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV)},
+				static_cast<UINT>(_width),
+				static_cast<UINT>(_height)
+			),
 		},
-		_mappedBitmap(nullptr)
-	{}
+		_mappedBitmap(nullptr),
+		_occupancy(_width, _height)
+	{
+		if (_width > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION || _height > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION) {
+			throw "the bitmap is too large for the world; lower the bitmap scale.";
+		}
+	}
 	BitmapManager() = delete;
 	BitmapManager(const BitmapManager &) = delete;
 	BitmapManager(const BitmapManager &&) = delete;
@@ -84,6 +127,20 @@ public:
 	BitmapManager &&operator=(const BitmapManager &&) = delete;
 	~BitmapManager() = default;
 
+	inline const WorldBounds &getWorld() const {
+		return _world;
+	}
+	/// ワールドの1単位あたりの画素数
+	inline float getScale() const {
+		return _scale;
+	}
+	inline int getWidth() const {
+		return _width;
+	}
+	inline int getHeight() const {
+		return _height;
+	}
+
 	/// 衝突判定ビットマップをマップするためのメンバ関数
 	///
 	/// WARN: frameIndexには処理が終わったフレームの番号を指定すること。
@@ -101,12 +158,42 @@ public:
 
 	/// 衝突判定ビットマップ上に物体が存在するか確認する関数
 	///
+	/// maskで指定した物体群のビットのうち、(x, y)に存在する物体群のビットを返す。
+	/// (x, y)はワールドの座標ではなくビットマップの画素の番号。
+	///
 	/// WARN: この関数を呼ぶ前にmap()を呼んでおくこと。
-	inline uint8_t check(int x, int y, int channel) const {
-		if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
-			return false;
+	inline uint32_t check(int x, int y, uint32_t mask) const {
+		if (x < 0 || x >= _width || y < 0 || y >= _height) {
+			return 0;
 		} else {
-			return _mappedBitmap[4 * WIDTH * y + 4 * x + channel];
+			return _mappedBitmap[static_cast<size_t>(_pitch) * y + x] & mask;
+		}
+	}
+
+	/// マップ中の衝突判定ビットマップから粗い占有格子を作り直す関数
+	///
+	/// WARN: この関数を呼ぶ前にmap()を呼んでおくこと。
+	inline void updateOccupancy() {
+		_occupancy.build([this](int x, int y) { return _mappedBitmap[static_cast<size_t>(_pitch) * y + x]; });
+	}
+
+	/// count本の光線raysが最初に通るmaskの物体群の画素までの距離を求める関数
+	///
+	/// 光線と距離とはワールドの座標で表す。結果はdistances[q * groupCount + g]に書かれる(castRays()を参照)。
+	///
+	/// WARN: この関数を呼ぶ前にmap()とupdateOccupancy()とを呼んでおくこと。
+	inline void castRays(const Ray *rays, size_t count, uint32_t mask, float *distances, size_t groupCount) const {
+		const auto check = [this](int x, int y, uint32_t m) {
+			return this->check(x, y, m);
+		};
+		for (size_t q = 0; q < count; ++q) {
+			const auto &ray = rays[q];
+			const Ray scaled{ray.x * _scale, ray.y * _scale, ray.dx, ray.dy, ray.length * _scale};
+			auto *results = distances + q * groupCount;
+			castRay(_occupancy, scaled, mask, results, check);
+			for (auto bits = mask; bits != 0; bits &= bits - 1) {
+				results[std::countr_zero(bits)] /= _scale;
+			}
 		}
 	}
 
@@ -1,62 +1,163 @@
 #include "../../common/common.hpp"
+#include "../../common/distance.hpp"
+#include "../../common/footprint.hpp"
+#include "../../common/mask.hpp"
+#include "../../common/stopwatch.hpp"
 #include "bitmap.hpp"
 #include "core.hpp"
 #include "render.hpp"
 #include "window.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <string_view>
 
 #undef min
 #undef max
 
-class Entity final: public EntityBase {
-private:
-	float _px, _py;
+// NOTE: 以下の関数の座標と長さとは、ワールドではなくビットマップの画素で表す。
 
-public:
-	Entity(float x, float y, float r, float spd, float dir): EntityBase(x, y, r, spd, dir), _px(x), _py(y) {}
-	void update() {
-		_px = _x;
-		_py = _y;
-		EntityBase::update();
-	}
-	bool isHit(const BitmapManager &bmpMngr, unsigned int opponentGroup) {
-		const int r = static_cast<int>(std::round(_r));
-		const int x0 = static_cast<int>(std::round(_px));
-		const int y0 = static_cast<int>(std::round(_py));
-		int x = r;
-		int y = 0;
-		int f = -2 * r + 3;
-		while (x >= y) {
-			const auto b =
-				   bmpMngr.check(x0 + x, y0 + y, opponentGroup)
-				|| bmpMngr.check(x0 - x, y0 + y, opponentGroup)
-				|| bmpMngr.check(x0 + x, y0 - y, opponentGroup)
-				|| bmpMngr.check(x0 - x, y0 - y, opponentGroup)
-				|| bmpMngr.check(x0 + y, y0 + x, opponentGroup)
-				|| bmpMngr.check(x0 - y, y0 + x, opponentGroup)
-				|| bmpMngr.check(x0 + y, y0 - x, opponentGroup)
-				|| bmpMngr.check(x0 - y, y0 - x, opponentGroup);
-			if (b) {
-				return true;
-			}
-			if (f >= 0) {
-				x -= 1;
-				f -= 4 * x;
+/// 衝突判定ビットマップ上で、円(x0, y0, r)の縁の画素にmaskの物体群が存在するか調べる関数
+///
+/// 縁の画素は、中心が円の内側にある画素のうち上下左右のいずれかが円の外側であるもの(足跡の表の縁と同じ)。
+/// 描画(ps_bitmap.hlslのcoversDisk())と同じ画素の中心の規則で行ごとに範囲を求め、両端と上下の行の範囲からはみ出す部分とを調べる。
+/// 見つかった物体群のビットを返す。maskのビットがすべて見つかった時点で打ち切る。
+inline uint32_t isHit(const BitmapManager &bmpMngr, float x0, float y0, float r, uint32_t mask) {
+	int ya, yb;
+	getCenterDiskRows(y0, r, ya, yb);
+	// 行yの範囲[xa, xb)を求める。空の行は、どの範囲との共通部分も空になるよう[INT_MAX, INT_MIN)とする
+	const auto getSpan = [&](int y, int &xa, int &xb) {
+		if (y < ya || y >= yb || !getCenterDiskSpan(x0, y0, r, y, xa, xb)) {
+			xa = std::numeric_limits<int>::max();
+			xb = std::numeric_limits<int>::min();
+		}
+	};
+	const auto yBegin = std::max(ya, 0);
+	const auto yEnd = std::min(yb, bmpMngr.getHeight());
+	int prevA, prevB, curA, curB, nextA, nextB;
+	getSpan(yBegin - 1, prevA, prevB);
+	getSpan(yBegin, curA, curB);
+	uint32_t found = 0;
+	for (int y = yBegin; y < yEnd && found != mask; ++y) {
+		getSpan(y + 1, nextA, nextB);
+		if (curA < curB) {
+			// 両端を除き、上下の行も円の内側である部分[innerA, innerB)は縁ではない
+			const auto innerA = std::max({curA + 1, prevA, nextA});
+			const auto innerB = std::min({curB - 1, prevB, nextB});
+			const auto checkRange = [&](int xa, int xb) {
+				for (int x = std::max(xa, 0); x < std::min(xb, bmpMngr.getWidth()) && found != mask; ++x) {
+					found |= bmpMngr.check(x, y, mask);
+				}
+			};
+			if (innerA < innerB) {
+				checkRange(curA, innerA);
+				checkRange(innerB, curB);
+			} else {
+				checkRange(curA, curB);
 			}
-			y += 1;
-			f += 4 * y + 2;
 		}
-		return false;
+		prevA = curA;
+		prevB = curB;
+		curA = nextA;
+		curB = nextB;
 	}
-	void push(std::vector<EntityDataLayout> &data, DirectX::XMFLOAT4 mask) const {
-		data.emplace_back(DirectX::XMFLOAT4(_x, _y, 0.0f, 0.0f), DirectX::XMFLOAT4(_r * 2.0f, _r * 2.0f, 1.0f, 1.0f), mask);
+	return found;
+}
+
+/// 衝突判定ビットマップ上で、円(x0, y0, r)の足跡の縁の画素にmaskの物体群が存在するか調べる関数
+///
+/// isHit()の行ごとの走査の代わりに、前もって求めた足跡の縁の画素の並びを辿る。半径が表の範囲外ならばisHit()で調べる。
+inline uint32_t isHitFootprint(const BitmapManager &bmpMngr, const DiskFootprints &footprints, float x0, float y0, float r, uint32_t mask) {
+	int x, y;
+	const auto *footprint = footprints.find(x0, y0, r, x, y);
+	if (!footprint) {
+		return isHit(bmpMngr, x0, y0, r, mask);
+	}
+	const auto *rim = footprints.getRim(*footprint);
+	uint32_t found = 0;
+	for (uint32_t k = 0; k < footprint->rimCount; ++k) {
+		found |= bmpMngr.check(x + rim[k].x, y + rim[k].y, mask);
+		// 円の8つの部分を一巡りするごとに打ち切るか調べる
+		if ((k & 7) == 7 && found == mask) {
+			return found;
+		}
+	}
+	return found;
+}
+
+/// 衝突判定ビットマップ上で、円(x0, y0, r)と少しでも重なる画素にmaskの物体群が存在するか調べる関数
+///
+/// 保守的な規則での照合に用いる。円と重なる画素すべてを調べ、maskのビットがすべて見つかれば以後の画素は調べない。
+inline uint32_t isHitConservative(const BitmapManager &bmpMngr, float x0, float y0, float r, uint32_t mask) {
+	int ya, yb;
+	getConservativeDiskRows(y0, r, ya, yb);
+	uint32_t found = 0;
+	for (int y = std::max(ya, 0); y < std::min(yb, bmpMngr.getHeight()) && found != mask; ++y) {
+		int xa, xb;
+		if (!getConservativeDiskSpan(x0, y0, r, y, xa, xb)) {
+			continue;
+		}
+		for (int x = std::max(xa, 0); x < std::min(xb, bmpMngr.getWidth()) && found != mask; ++x) {
+			found |= bmpMngr.check(x, y, mask);
+		}
+	}
+	return found;
+}
+
+/// 衝突判定ビットマップ上で、(x0, y0)に半径rで角度angleだけ回して置いたatlasの形shapeが規則coverageで覆う画素にmaskの物体群が存在するか調べる関数
+///
+/// 形の画素すべてを調べ、見つかった物体群のビットを返す。maskのビットがすべて見つかれば以後の画素は調べない。
+inline uint32_t isHitMask(
+	const BitmapManager &bmpMngr,
+	const MaskAtlas &atlas,
+	uint32_t shape,
+	float x0,
+	float y0,
+	float r,
+	float angle,
+	const Coverage &coverage,
+	uint32_t mask
+) {
+	uint32_t found = 0;
+	forEachMaskSpan(atlas, shape, x0, y0, r, angle, coverage, bmpMngr.getWidth(), bmpMngr.getHeight(), [&](int y, int xa, int xb) {
+		for (int x = xa; x < xb && found != mask; ++x) {
+			found |= bmpMngr.check(x, y, mask);
+		}
+	});
+	return found;
+}
+
+class Scene final: public SceneBase {
+private:
+	std::unique_ptr<DistanceField> _distance;
+
+	/// マップ中の衝突判定ビットマップからかすり判定を行う関数
+	///
+	/// target群の距離場を求め、querier群の物体ごとに一度だけ参照する。
+	/// 距離場はビットマップの画素で求まるため、物体の座標と長さとを画素に直して参照する。
+	void graze(const BitmapManager &bmpMngr) {
+		if (!_distance) {
+			_distance = std::make_unique<DistanceField>(bmpMngr.getWidth(), bmpMngr.getHeight());
+		}
+		const auto targetBit = 1u << _graze->target;
+		_distance->build([&bmpMngr, targetBit](int x, int y) { return bmpMngr.check(x, y, targetBit) != 0; });
+		const auto scale = bmpMngr.getScale();
+		const auto &queriers = _groups[_graze->querier];
+		for (size_t i = 0; i < queriers.size(); ++i) {
+			if (_distance->classify(queriers.px[i] * scale, queriers.py[i] * scale, queriers.r[i] * scale, _graze->margin * scale) == Proximity::Graze) {
+				_grazeCount += 1;
+			}
+		}
 	}
-};
 
-class Scene final: public SceneBase<Entity> {
 public:
-	explicit Scene(size_t entityCount): SceneBase(entityCount) {}
+	explicit Scene(size_t entityCount, const WorldBounds &world = getDefaultWorld()): SceneBase(entityCount, world) {}
+	explicit Scene(const std::vector<GroupDesc> &descs, const InteractionMatrix &matrix, const WorldBounds &world = getDefaultWorld()):
+		SceneBase(descs, matrix, world)
+	{}
 	void update(Core &core, BitmapManager &bmpMngr, WindowManager &winMngr, Renderer &rndrr) {
 		// 衝突判定ビットマップの描画が終わるまで待機
 		core.wait();
@@ -65,24 +166,58 @@ public:
 		// 衝突判定ビットマップの参照を開始
 		bmpMngr.map(frameIndex);
 
+		// かすり判定
+		// NOTE: 物体の更新より前に、衝突判定と同じくpx, pyで判定する。
+		if (_graze) {
+			graze(bmpMngr);
+		}
+
 		// 物体のデータを格納するvectorを作成
 		std::vector<EntityDataLayout> data;
-		data.reserve(_entities1.size() + _entities2.size());
+		data.reserve(SceneBase::getEntityCount());
 
 		// 物体を更新
-		for (auto &n: _entities1) {
-			if (n.isHit(bmpMngr, 1)) {
-				SceneBase<Entity>::incrementHitCount();
+		// NOTE: マップしたビットマップには2フレーム前の描画結果が入っており、
+		//       更新前のpx, pyがちょうどその位置であるため、更新前にpx, pyで判定する。
+		// NOTE: ビットマップからは衝突した相手の物体群しか分からないため、衝突ペアは書き出さず衝突フラグのみ書き出す。
+		// NOTE: 自身の物体群は自身の描画と区別できないため、自身の物体群との衝突判定は行わない。
+		SceneBase::clearContactOutput();
+		const auto scale = bmpMngr.getScale();
+		for (unsigned int g = 0; g < _groups.size(); ++g) {
+			auto &group = _groups[g];
+			const auto bit = 1u << g;
+			const auto mask = _matrix.getRow(g) & ~bit;
+			if (mask != 0) {
+				for (size_t i = 0; i < group.size(); ++i) {
+					// ワールドの座標と長さとをビットマップの画素に直して調べる
+					const auto x = group.px[i] * scale;
+					const auto y = group.py[i] * scale;
+					const auto r = group.r[i] * scale;
+					// NOTE: しきい値の規則では、円は半径を変えた円として中心の規則と同じく調べる。
+					const auto rc = getCoveredRadius(r, _coverage);
+					const auto found = _atlas && group.shape[i] != SHAPE_CIRCLE
+						? isHitMask(bmpMngr, *_atlas, group.shape[i], x, y, r, group.angle[i], _coverage, mask)
+						: _coverage.mode == CoverageMode::Conservative
+						? isHitConservative(bmpMngr, x, y, r, mask)
+						: _footprints
+						? isHitFootprint(bmpMngr, *_footprints, x, y, rc, mask)
+						: isHit(bmpMngr, x, y, rc, mask);
+					if (found != 0) {
+						_hitCount += std::popcount(found);
+						SceneBase::emitHit(g, i);
+					}
+				}
 			}
-			n.update();
-			n.push(data, DirectX::XMFLOAT4(1.0f, 0.0f, 0.0f, 0.0f));
-		}
-		for (auto &n: _entities2) {
-			if (n.isHit(bmpMngr, 0)) {
-				SceneBase<Entity>::incrementHitCount();
+			group.update(_world);
+			for (size_t i = 0; i < group.size(); ++i) {
+				data.emplace_back(
+					DirectX::XMFLOAT4(group.x[i], group.y[i], 0.0f, 0.0f),
+					DirectX::XMFLOAT4(group.r[i] * 2.0f, group.r[i] * 2.0f, 1.0f, 1.0f),
+					bit,
+					group.shape[i],
+					group.angle[i]
+				);
 			}
-			n.update();
-			n.push(data, DirectX::XMFLOAT4(0.0f, 1.0f, 0.0f, 0.0f));
 		}
 
 		// 衝突判定ビットマップの参照を終了
@@ -92,12 +227,12 @@ public:
 		const auto &cmdList = core.getCurrentCommandList();
 		rndrr.uploadEntities(frameIndex, data);
 		bmpMngr.attach(cmdList, frameIndex);
-		rndrr.draw(cmdList, frameIndex, static_cast<UINT>(data.size()));
+		rndrr.drawBitmap(cmdList, frameIndex, static_cast<UINT>(data.size()));
 		bmpMngr.detach(cmdList, frameIndex);
 
 		// 画面に描画 (デバッグ用)
 		winMngr.attach(cmdList);
-		rndrr.draw(cmdList, frameIndex, static_cast<UINT>(data.size()));
+		rndrr.drawDisplay(cmdList, frameIndex, static_cast<UINT>(data.size()));
 		winMngr.detach(cmdList);
 
 		// コマンド提出
@@ -111,25 +246,52 @@ public:
 	}
 };
 
+/// 引数を読む関数
+///
+/// - `--world WxH` : シーンとビットマップとのワールドの大きさ (既定は画面と同じ大きさ)
+inline void parseArguments(int argc, char *argv[]) {
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--world" && i + 1 < argc) {
+			setDefaultWorld(parseWorld(argv[++i]));
+		}
+	}
+}
+
 #ifdef WINDOW_RENDERING
 int WINAPI WinMain(_In_ HINSTANCE inst, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ int) {
 	constexpr std::array<size_t, 1> entityCounts{500};
+	const auto argc = __argc;
+	const auto argv = __argv;
 #else
-int main() {
+int main(int argc, char *argv[]) {
 	HINSTANCE inst = nullptr;
 	constexpr std::array<size_t, 7> entityCounts{100, 500, 1000, 2000, 3000, 4000, 5000};
 #endif
+	try {
+		parseArguments(argc, argv);
+	} catch (const char *message) {
+		std::cerr << "error: " << message << std::endl;
+		return 1;
+	}
+	// 形と円の足跡とは起動時に一度だけ作る
+	const MaskAtlas atlas;
+	const DiskFootprints footprints;
+	// 描画と照合とに共通する、画素の覆い方の規則
+	constexpr auto coverage = Coverage::center();
+	// 衝突判定ビットマップの、ワールドの1単位あたりの画素数
+	constexpr auto bitmapScale = 1.0f;
 	for (auto entityCount: entityCounts) {
 		Core core;
-		BitmapManager bmpMngr(core.getDevice());
-		WindowManager winMngr(inst, core.getDevice(), core.getQueue());
-		Renderer rndrr(core.getDevice(), core.getQueue(), static_cast<UINT>(entityCount * 2));
 		Scene scene(entityCount);
+		BitmapManager bmpMngr(core.getDevice(), scene.getWorld(), bitmapScale);
+		WindowManager winMngr(inst, core.getDevice(), core.getQueue());
+		scene.setMaskAtlas(&atlas);
+		scene.setFootprints(&footprints);
+		scene.setCoverage(coverage);
+		Renderer rndrr(core.getDevice(), core.getQueue(), static_cast<UINT>(scene.getEntityCount()), atlas, bmpMngr, coverage);
 
-		LARGE_INTEGER freq;
-		QueryPerformanceFrequency(&freq);
-		LARGE_INTEGER before;
-		QueryPerformanceCounter(&before);
+		const Stopwatch stopwatch;
 
 #ifdef WINDOW_RENDERING
 		while (winMngr.process()) {
@@ -139,20 +301,18 @@ int main() {
 			scene.update(core, bmpMngr, winMngr, rndrr);
 		}
 
-		LARGE_INTEGER after;
-		QueryPerformanceCounter(&after);
+		const auto elapsed = stopwatch.elapsedMs();
 
 		core.waitAll();
 
 		std::cout
 			<< entityCount
 			<< " "
-			<< (static_cast<double>(after.QuadPart - before.QuadPart) * 1000.0 / static_cast<double>(freq.QuadPart))
+			<< elapsed
 			<< " "
 			<< scene.getHitCount()
 			<< std::endl;
-		
-		// NOTE: 念のため、GPUを冷ますために2秒待つ。
-		Sleep(2000);
+
+		cooldown();
 	}
 }
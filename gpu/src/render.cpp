@@ -1,10 +1,33 @@
 #include "render.hpp"
 
 #include <d3dcompiler.h>
+#include <string>
 
 namespace {
+	/// 実行ファイルと同じディレクトリにあるファイルnameのパスを返す関数
+	///
+	/// シェーダーをカレントディレクトリに依らず読み込むために用いる。
+	inline std::wstring getModuleRelativePath(LPCWSTR name) {
+		std::wstring path(MAX_PATH, L'\0');
+		const auto length = GetModuleFileNameW(nullptr, path.data(), static_cast<DWORD>(path.size()));
+		if (length == 0 || length == path.size()) {
+			throw "failed to get the module path.";
+		}
+		path.resize(length);
+		path.resize(path.find_last_of(L"\\/") + 1);
+		return path + name;
+	}
+
 	struct CameraDataLayout final {
 		DirectX::XMMATRIX proj;
+		/// アトラスの形の数
+		UINT shapeCount;
+		/// 画素を覆っているとみなす規則 (CoverageModeの値)
+		UINT coverageMode;
+		/// CoverageMode::Thresholdでのしきい値
+		FLOAT coverageThreshold;
+		/// 衝突判定ビットマップの、ワールドの1単位あたりの画素数
+		FLOAT bitmapScale;
 	};
 
 	inline ComPtr<ID3D12RootSignature> createRootSignature(const ComPtr<ID3D12Device> &device) {
@@ -18,7 +41,7 @@ namespace {
 		params[1].ParameterType             = D3D12_ROOT_PARAMETER_TYPE_CBV;
 		params[1].Descriptor.ShaderRegister = 0;
 		params[1].Descriptor.RegisterSpace  = 0;
-		params[1].ShaderVisibility          = D3D12_SHADER_VISIBILITY_VERTEX;
+		params[1].ShaderVisibility          = D3D12_SHADER_VISIBILITY_ALL;
 		// tex
 		D3D12_DESCRIPTOR_RANGE range;
 		range.RangeType                         = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
@@ -68,31 +91,66 @@ namespace {
 		return rootSig;
 	}
 
-	inline ComPtr<ID3D12PipelineState> createPipelineState(const ComPtr<ID3D12Device> &device, const ComPtr<ID3D12RootSignature> &rootSig) {
+	inline void checkLogicOpSupport(const ComPtr<ID3D12Device> &device) {
+		D3D12_FEATURE_DATA_D3D12_OPTIONS options{};
+		if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) || !options.OutputMergerLogicOp) {
+			throw "logic operations on render targets are not supported.";
+		}
+	}
+
+	inline void checkConservativeRasterSupport(const ComPtr<ID3D12Device> &device) {
+		D3D12_FEATURE_DATA_D3D12_OPTIONS options{};
+		if (
+			FAILED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)))
+			|| options.ConservativeRasterizationTier == D3D12_CONSERVATIVE_RASTERIZATION_TIER_NOT_SUPPORTED
+		) {
+			throw "conservative rasterization is not supported.";
+		}
+	}
+
+	/// パイプラインステートを作成する関数
+	///
+	/// logicOpがtrueならば、ブレンドの代わりに論理和で描画する。
+	/// conservativeがtrueならば、四角形と少しでも重なる画素すべてでピクセルシェーダーを実行する。
+	inline ComPtr<ID3D12PipelineState> createPipelineState(
+		const ComPtr<ID3D12Device> &device,
+		const ComPtr<ID3D12RootSignature> &rootSig,
+		LPCWSTR psPath,
+		DXGI_FORMAT format,
+		bool logicOp,
+		bool conservative
+	) {
+		if (logicOp) {
+			checkLogicOpSupport(device);
+		}
+		if (conservative) {
+			checkConservativeRasterSupport(device);
+		}
+
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc{};
 
 		ComPtr<ID3DBlob> vs;
 		ComPtr<ID3DBlob> ps;
-		if (FAILED(D3DReadFileToBlob(L"vs.cso", vs.GetAddressOf()))) {
+		if (FAILED(D3DReadFileToBlob(getModuleRelativePath(L"vs.cso").c_str(), vs.GetAddressOf()))) {
 			throw "failed to load vs.cso.";
 		}
-		if (FAILED(D3DReadFileToBlob(L"ps.cso", ps.GetAddressOf()))) {
-			throw "failed to load ps.cso.";
+		if (FAILED(D3DReadFileToBlob(getModuleRelativePath(psPath).c_str(), ps.GetAddressOf()))) {
+			throw "failed to load a pixel shader.";
 		}
 		desc.VS = {vs->GetBufferPointer(), vs->GetBufferSize()};
 		desc.PS = {ps->GetBufferPointer(), ps->GetBufferSize()};
 
 		desc.BlendState.AlphaToCoverageEnable  = FALSE;
 		desc.BlendState.IndependentBlendEnable = FALSE;
-		desc.BlendState.RenderTarget[0].BlendEnable           = TRUE;
-		desc.BlendState.RenderTarget[0].LogicOpEnable         = FALSE;
+		desc.BlendState.RenderTarget[0].BlendEnable           = logicOp ? FALSE : TRUE;
+		desc.BlendState.RenderTarget[0].LogicOpEnable         = logicOp ? TRUE : FALSE;
 		desc.BlendState.RenderTarget[0].SrcBlend              = D3D12_BLEND_ONE;
 		desc.BlendState.RenderTarget[0].DestBlend             = D3D12_BLEND_ONE;
 		desc.BlendState.RenderTarget[0].BlendOp               = D3D12_BLEND_OP_ADD;
 		desc.BlendState.RenderTarget[0].SrcBlendAlpha         = D3D12_BLEND_ONE;
 		desc.BlendState.RenderTarget[0].DestBlendAlpha        = D3D12_BLEND_ONE;
 		desc.BlendState.RenderTarget[0].BlendOpAlpha          = D3D12_BLEND_OP_ADD;
-		desc.BlendState.RenderTarget[0].LogicOp               = D3D12_LOGIC_OP_NOOP;
+		desc.BlendState.RenderTarget[0].LogicOp               = logicOp ? D3D12_LOGIC_OP_OR : D3D12_LOGIC_OP_NOOP;
 		desc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
 
 		desc.RasterizerState.FillMode              = D3D12_FILL_MODE_SOLID;
@@ -105,7 +163,7 @@ namespace {
 		desc.RasterizerState.MultisampleEnable     = FALSE;
 		desc.RasterizerState.AntialiasedLineEnable = FALSE;
 		desc.RasterizerState.ForcedSampleCount     = 0;
-		desc.RasterizerState.ConservativeRaster    = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+		desc.RasterizerState.ConservativeRaster    = conservative ? D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON : D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
 
 		desc.DepthStencilState.DepthEnable      = FALSE;
 		desc.DepthStencilState.DepthWriteMask   = D3D12_DEPTH_WRITE_MASK_ALL;
@@ -132,7 +190,7 @@ namespace {
 		desc.SampleMask            = UINT_MAX;
 		desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
 		desc.NumRenderTargets      = 1;
-		desc.RTVFormats[0]         = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.RTVFormats[0]         = format;
 		desc.DSVFormat             = DXGI_FORMAT_UNKNOWN;
 		desc.SampleDesc            = {1, 0};
 
@@ -157,22 +215,43 @@ namespace {
 	}
 }
 
-Renderer::Renderer(const ComPtr<ID3D12Device> &device, const ComPtr<ID3D12CommandQueue> &queue, UINT instCount):
+Renderer::Renderer(
+	const ComPtr<ID3D12Device> &device,
+	const ComPtr<ID3D12CommandQueue> &queue,
+	UINT instCount,
+	const MaskAtlas &atlas,
+	const BitmapManager &bmpMngr,
+	const Coverage &coverage
+):
 	_rootSig(createRootSignature(device)),
-	_state(createPipelineState(device, _rootSig)),
+	_bitmapState(createPipelineState(device, _rootSig, L"ps_bitmap.cso", BITMAP_FORMAT, true, coverage.mode == CoverageMode::Conservative)),
+	_displayState(createPipelineState(device, _rootSig, L"ps.cso", DXGI_FORMAT_R8G8B8A8_UNORM, false, false)),
 	_viewport{0.0f, 0.0f, WIDTH_FLOAT, HEIGHT_FLOAT, 0.0f, 1.0f},
 	_scissor{0, 0, WIDTH, HEIGHT},
+	_bitmapViewport{
+		0.0f,
+		0.0f,
+		bmpMngr.getWorld().width * bmpMngr.getScale(),
+		bmpMngr.getWorld().height * bmpMngr.getScale(),
+		0.0f,
+		1.0f,
+	},
+	_bitmapScissor{0, 0, bmpMngr.getWidth(), bmpMngr.getHeight()},
 	_srvHeap(createSRVHeap(device)),
 	_entities{
 		createBufferResource(device, sizeof(EntityDataLayout) * instCount),
 		createBufferResource(device, sizeof(EntityDataLayout) * instCount),
 	},
 	_camera(createBufferResource(device, sizeof(CameraDataLayout), D3D12_HEAP_TYPE_DEFAULT)),
-	_texture(device, queue, _srvHeap->GetCPUDescriptorHandleForHeapStart()),
+	_texture(device, queue, _srvHeap->GetCPUDescriptorHandleForHeapStart(), atlas),
 	_mesh(device, queue)
 {
 	const CameraDataLayout camera{
-		DirectX::XMMatrixOrthographicOffCenterLH(0.0f, WIDTH_FLOAT, HEIGHT_FLOAT, 0.0f, 0.0f, 1.0f),
+		DirectX::XMMatrixOrthographicOffCenterLH(0.0f, bmpMngr.getWorld().width, bmpMngr.getWorld().height, 0.0f, 0.0f, 1.0f),
+		static_cast<UINT>(atlas.size()),
+		static_cast<UINT>(coverage.mode),
+		coverage.threshold,
+		bmpMngr.getScale(),
 	};
 	uploadToBufferOnDefaultHeapImmediately(device, queue, _camera, static_cast<const void *>(&camera), sizeof(CameraDataLayout));
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../../common/constant.hpp"
+#include "../../common/coverage.hpp"
+#include "bitmap.hpp"
 #include "render/mesh.hpp"
 #include "render/texture.hpp"
 #include "util.hpp"
@@ -12,24 +14,71 @@
 struct EntityDataLayout {
 	DirectX::XMFLOAT4 trans;
 	DirectX::XMFLOAT4 scale;
-	DirectX::XMFLOAT4 offset;
+	UINT groups;
+	/// 衝突判定の形の番号
+	UINT shape;
+	/// 形の回転角(ラジアン)
+	FLOAT angle;
 };
 
 /// 描画を行うオブジェクト
 class Renderer final {
 private:
 	const ComPtr<ID3D12RootSignature> _rootSig;
-	const ComPtr<ID3D12PipelineState> _state;
+	const ComPtr<ID3D12PipelineState> _bitmapState;
+	const ComPtr<ID3D12PipelineState> _displayState;
 	const D3D12_VIEWPORT _viewport;
 	const D3D12_RECT _scissor;
+	/// 衝突判定ビットマップの解像度でのビューポート
+	///
+	/// 投影はワールドの座標のまま、ビューポートでビットマップの画素に拡大縮小する。
+	const D3D12_VIEWPORT _bitmapViewport;
+	const D3D12_RECT _bitmapScissor;
 	const ComPtr<ID3D12DescriptorHeap> _srvHeap;
 	const std::array<ComPtr<ID3D12Resource>, FRAME_COUNT> _entities;
 	const ComPtr<ID3D12Resource> _camera;
-	const CircleTexture _texture;
+	const MaskTexture _texture;
 	const SquareMesh _mesh;
 
+	/// 描画を行うメンバ関数
+	inline void draw(
+		const ComPtr<ID3D12GraphicsCommandList> &cmdList,
+		const ComPtr<ID3D12PipelineState> &state,
+		const D3D12_VIEWPORT &viewport,
+		const D3D12_RECT &scissor,
+		UINT frameIndex,
+		UINT instCount
+	) const {
+		std::array<ID3D12DescriptorHeap *, 1> descHeaps{_srvHeap.Get()};
+		cmdList->SetDescriptorHeaps(static_cast<UINT>(descHeaps.size()), descHeaps.data());
+		cmdList->SetGraphicsRootSignature(_rootSig.Get());
+		cmdList->SetGraphicsRootShaderResourceView(0, _entities[frameIndex]->GetGPUVirtualAddress());
+		cmdList->SetGraphicsRootConstantBufferView(1, _camera->GetGPUVirtualAddress());
+		cmdList->SetGraphicsRootDescriptorTable(2, _srvHeap->GetGPUDescriptorHandleForHeapStart());
+
+		cmdList->SetPipelineState(state.Get());
+		cmdList->RSSetViewports(1, &viewport);
+		cmdList->RSSetScissorRects(1, &scissor);
+
+		cmdList->IASetVertexBuffers(0, 1, &_mesh.vbv);
+		cmdList->IASetIndexBuffer(&_mesh.ibv);
+		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+		cmdList->DrawIndexedInstanced(_mesh.indexCount, instCount, 0, 0, 0);
+	}
+
 public:
-	explicit Renderer(const ComPtr<ID3D12Device> &device, const ComPtr<ID3D12CommandQueue> &queue, UINT instCount);
+	/// atlasの形をテクスチャとして転送する
+	///
+	/// 投影はbmpMngrのワールド全体を覆い、画面にはワールド全体を縮めて描画する。
+	/// 衝突判定ビットマップへはbmpMngrのビットマップの解像度で、coverageの規則で描画する。照合にも同じ規則を用いること。
+	explicit Renderer(
+		const ComPtr<ID3D12Device> &device,
+		const ComPtr<ID3D12CommandQueue> &queue,
+		UINT instCount,
+		const MaskAtlas &atlas,
+		const BitmapManager &bmpMngr,
+		const Coverage &coverage = Coverage::center()
+	);
 	Renderer() = delete;
 	Renderer(const Renderer &) = delete;
 	Renderer(const Renderer &&) = delete;
@@ -44,24 +93,17 @@ public:
 		uploadToUploadHeap(_entities[frameIndex], static_cast<const void *>(data.data()), sizeof(EntityDataLayout) * data.size());
 	}
 
-	/// 描画を行うメンバ関数
+	/// 衝突判定ビットマップに描画を行うメンバ関数
 	///
-	/// WARN: 一フレームに一度しか呼ばれない想定をしている。
-	inline void draw(const ComPtr<ID3D12GraphicsCommandList> &cmdList, UINT frameIndex, UINT instCount) const {
-		std::array<ID3D12DescriptorHeap *, 1> descHeaps{_srvHeap.Get()};
-		cmdList->SetDescriptorHeaps(static_cast<UINT>(descHeaps.size()), descHeaps.data());
-		cmdList->SetGraphicsRootSignature(_rootSig.Get());
-		cmdList->SetGraphicsRootShaderResourceView(0, _entities[frameIndex]->GetGPUVirtualAddress());
-		cmdList->SetGraphicsRootConstantBufferView(1, _camera->GetGPUVirtualAddress());
-		cmdList->SetGraphicsRootDescriptorTable(2, _srvHeap->GetGPUDescriptorHandleForHeapStart());
-
-		cmdList->SetPipelineState(_state.Get());
-		cmdList->RSSetViewports(1, &_viewport);
-		cmdList->RSSetScissorRects(1, &_scissor);
+	/// 各物体の物体群のビットを論理和で書き込む。
+	inline void drawBitmap(const ComPtr<ID3D12GraphicsCommandList> &cmdList, UINT frameIndex, UINT instCount) const {
+		draw(cmdList, _bitmapState, _bitmapViewport, _bitmapScissor, frameIndex, instCount);
+	}
 
-		cmdList->IASetVertexBuffers(0, 1, &_mesh.vbv);
-		cmdList->IASetIndexBuffer(&_mesh.ibv);
-		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-		cmdList->DrawIndexedInstanced(_mesh.indexCount, instCount, 0, 0, 0);
+	/// 画面に描画を行うメンバ関数 (デバッグ用)
+	///
+	/// 物体群ごとに色を付けて加算で描画する。
+	inline void drawDisplay(const ComPtr<ID3D12GraphicsCommandList> &cmdList, UINT frameIndex, UINT instCount) const {
+		draw(cmdList, _displayState, _viewport, _scissor, frameIndex, instCount);
 	}
 };
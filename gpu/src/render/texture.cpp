@@ -4,28 +4,33 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include <vector>
+
 namespace {
-	inline ComPtr<ID3D12Resource> createResource(const ComPtr<ID3D12Device> &device, const ComPtr<ID3D12CommandQueue> &queue) {
-		int width, height, channels;
-		unsigned char *imageData = stbi_load("circle.png", &width, &height, &channels, 4);
-		if (!imageData) {
-			throw "failed to load circle.png.";
+	inline ComPtr<ID3D12Resource> createResource(const ComPtr<ID3D12Device> &device, const ComPtr<ID3D12CommandQueue> &queue, const MaskAtlas &atlas) {
+		const auto width = MASK_SIZE;
+		const auto height = static_cast<int>(MASK_SIZE * atlas.size());
+		std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+		for (int y = 0; y < height; ++y) {
+			const auto row = atlas.getRow(static_cast<uint32_t>(y / MASK_SIZE), y % MASK_SIZE);
+			for (int x = 0; x < width; ++x) {
+				pixels[static_cast<size_t>(y) * width + x] = ((row >> x) & 1) != 0 ? 0xffffffff : 0x00ffffff;
+			}
 		}
 
 		const auto res = createTexture2DResource(device, width, height, std::nullopt);
-		uploadToTexture2DOnDefaultHeapImmediately(device, queue, res, static_cast<const void *>(imageData), width, height);
-
-		stbi_image_free(imageData);
+		uploadToTexture2DOnDefaultHeapImmediately(device, queue, res, static_cast<const void *>(pixels.data()), width, height);
 		return res;
 	}
 }
 
-CircleTexture::CircleTexture(
+MaskTexture::MaskTexture(
 	const ComPtr<ID3D12Device> &device,
 	const ComPtr<ID3D12CommandQueue> &queue,
-	D3D12_CPU_DESCRIPTOR_HANDLE handle
+	D3D12_CPU_DESCRIPTOR_HANDLE handle,
+	const MaskAtlas &atlas
 ):
-	res(createResource(device, queue))
+	res(createResource(device, queue, atlas))
 {
 	D3D12_SHADER_RESOURCE_VIEW_DESC desc;
 	desc.Format                        = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -37,3 +42,14 @@ CircleTexture::CircleTexture(
 	desc.Texture2D.ResourceMinLODClamp = 0.0f;
 	device->CreateShaderResourceView(res.Get(), &desc, handle);
 }
+
+uint32_t loadMaskImage(MaskAtlas &atlas, const char *path) {
+	int width, height, channels;
+	unsigned char *imageData = stbi_load(path, &width, &height, &channels, 4);
+	if (!imageData) {
+		throw "failed to load a mask image.";
+	}
+	const auto shape = atlas.addImage(imageData, width, height);
+	stbi_image_free(imageData);
+	return shape;
+}
@@ -1,22 +1,32 @@
 #pragma once
 
+#include "../../../common/mask.hpp"
+
 #include <d3d12.h>
 #include <wrl/client.h>
 
 using Microsoft::WRL::ComPtr;
 
-struct CircleTexture {
+/// 衝突判定の形のアトラスのテクスチャ
+///
+/// 形をMASK_SIZE x MASK_SIZEの画像として番号順に縦に並べ、起動時に一度だけ転送する。
+/// 形の内側の画素のアルファが1、外側が0になる。
+struct MaskTexture {
 	const ComPtr<ID3D12Resource> res;
 
-	explicit CircleTexture(
+	explicit MaskTexture(
 		const ComPtr<ID3D12Device> &device,
 		const ComPtr<ID3D12CommandQueue> &queue,
-		D3D12_CPU_DESCRIPTOR_HANDLE handle
+		D3D12_CPU_DESCRIPTOR_HANDLE handle,
+		const MaskAtlas &atlas
 	);
-	CircleTexture() = delete;
-	CircleTexture(const CircleTexture &) = delete;
-	CircleTexture(const CircleTexture &&) = delete;
-	CircleTexture &operator=(const CircleTexture &) = delete;
-	CircleTexture &&operator=(const CircleTexture &&) = delete;
-	~CircleTexture() = default;
+	MaskTexture() = delete;
+	MaskTexture(const MaskTexture &) = delete;
+	MaskTexture(const MaskTexture &&) = delete;
+	MaskTexture &operator=(const MaskTexture &) = delete;
+	MaskTexture &&operator=(const MaskTexture &&) = delete;
+	~MaskTexture() = default;
 };
+
+/// PNG画像pathの不透明な画素を形としてatlasに加え、その番号を返す関数
+uint32_t loadMaskImage(MaskAtlas &atlas, const char *path);
@@ -10,9 +10,9 @@
 
 using Microsoft::WRL::ComPtr;
 
-inline D3D12_CLEAR_VALUE createColorClearValue(const std::array<FLOAT, 4> &color) {
+inline D3D12_CLEAR_VALUE createColorClearValue(const std::array<FLOAT, 4> &color, DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM) {
 	D3D12_CLEAR_VALUE clearValue;
-	clearValue.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	clearValue.Format = format;
 	std::copy(color.cbegin(), color.cend(), clearValue.Color);
 	return clearValue;
 }
@@ -42,7 +42,12 @@ inline D3D12_RESOURCE_DESC createBufferResourceDesc(UINT size) {
 	};
 }
 
-inline D3D12_RESOURCE_DESC createTexture2DResourceDesc(UINT width, UINT height, D3D12_RESOURCE_FLAGS flag) {
+inline D3D12_RESOURCE_DESC createTexture2DResourceDesc(
+	UINT width,
+	UINT height,
+	D3D12_RESOURCE_FLAGS flag,
+	DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM
+) {
 	return {
 		D3D12_RESOURCE_DIMENSION_TEXTURE2D,
 		0,
@@ -50,7 +55,7 @@ inline D3D12_RESOURCE_DESC createTexture2DResourceDesc(UINT width, UINT height,
 		height,
 		1,
 		1,
-		DXGI_FORMAT_R8G8B8A8_UNORM,
+		format,
 		{1, 0},
 		D3D12_TEXTURE_LAYOUT_UNKNOWN,
 		flag,
@@ -85,10 +90,11 @@ inline ComPtr<ID3D12Resource> createTexture2DResource(
 	UINT height,
 	std::optional<D3D12_CLEAR_VALUE> clearValue,
 	D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_GENERIC_READ,
-	D3D12_RESOURCE_FLAGS flag = D3D12_RESOURCE_FLAG_NONE
+	D3D12_RESOURCE_FLAGS flag = D3D12_RESOURCE_FLAG_NONE,
+	DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM
 ) {
 	const D3D12_HEAP_PROPERTIES prop = createHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
-	const D3D12_RESOURCE_DESC desc = createTexture2DResourceDesc(width, height, flag);
+	const D3D12_RESOURCE_DESC desc = createTexture2DResourceDesc(width, height, flag, format);
 	ComPtr<ID3D12Resource> res;
 	if (FAILED(device->CreateCommittedResource(
 		&prop,
@@ -238,9 +244,14 @@ inline ComPtr<ID3D12DescriptorHeap> createRTVHeap(const ComPtr<ID3D12Device> &de
 	return rtvHeap;
 }
 
-inline void createRTV(const ComPtr<ID3D12Device> &device, const ComPtr<ID3D12Resource> &res, D3D12_CPU_DESCRIPTOR_HANDLE viewHandle) {
+inline void createRTV(
+	const ComPtr<ID3D12Device> &device,
+	const ComPtr<ID3D12Resource> &res,
+	D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
+	DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM
+) {
 	D3D12_RENDER_TARGET_VIEW_DESC desc;
-	desc.Format               = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.Format               = format;
 	desc.ViewDimension        = D3D12_RTV_DIMENSION_TEXTURE2D;
 	desc.Texture2D.MipSlice   = 0;
 	desc.Texture2D.PlaneSlice = 0;
@@ -254,11 +265,16 @@ protected:
 	const D3D12_CPU_DESCRIPTOR_HANDLE _viewHandle;
 
 public:
-	explicit RenderTarget(const ComPtr<ID3D12Device> &device, ComPtr<ID3D12Resource> &&res, D3D12_CPU_DESCRIPTOR_HANDLE viewHandle):
+	explicit RenderTarget(
+		const ComPtr<ID3D12Device> &device,
+		ComPtr<ID3D12Resource> &&res,
+		D3D12_CPU_DESCRIPTOR_HANDLE viewHandle,
+		DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM
+	):
 		_res(std::move(res)),
 		_viewHandle(viewHandle)
 	{
-		createRTV(device, _res, viewHandle);
+		createRTV(device, _res, viewHandle, format);
 	}
 	RenderTarget() = delete;
 	RenderTarget(const RenderTarget &) = delete;